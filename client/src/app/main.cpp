@@ -21,6 +21,7 @@
 */
 
 #include "mainwindow.h"
+#include "tracer.h"
 
 #include <KApplication>
 #include <KAboutData>
@@ -39,6 +40,7 @@ int main(int argc, char **argv)
 
     KCmdLineArgs::init(argc, argv, &about);
     KApplication app;
+    Tracer::instance(); // checks FATCRM_TRACE, before any thread starts tracing
     MainWindow *window = new MainWindow;
     window->setAttribute(Qt::WA_DeleteOnClose);
     window->show();
@@ -25,16 +25,20 @@
 #include "accountimportdialog.h"
 #include "accountrepository.h"
 #include "clientsettings.h"
+#include "clientsnapshot.h"
 #include "collectionmanager.h"
 #include "configurationdialog.h"
 #include "contactsimporter.h"
 #include "dbuswinidprovider.h"
+#include "diagnosticsdialog.h"
 #include "enums.h"
 #include "fatcrm_version.h"
 #include "notesrepository.h"
 #include "referenceddata.h"
 #include "reportpage.h"
 #include "resourceconfigdialog.h"
+#include "resourcesettingscache.h"
+#include "startupscheduler.h"
 
 #include "kdcrmdata/enumdefinitionattribute.h"
 
@@ -47,6 +51,9 @@
 #include <Akonadi/ServerManager>
 using namespace Akonadi;
 
+#include <KGlobal>
+#include <KLocale>
+
 #include <QCheckBox>
 #include <QCloseEvent>
 #include <QComboBox>
@@ -55,16 +62,24 @@ using namespace Akonadi;
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QProgressBar>
+#include <QShortcut>
 #include <QTimer>
 #include <QToolBar>
 
+// The referenced data restored from the snapshot: it resolves the account names and
+// countries of the items loaded before the accounts. The other tables are only shown
+// in combos, which are filled once all pages are loaded and have read them again.
+static const ReferencedDataType s_snapshotRefTypes[] = { AccountRef, AccountCountryRef };
+
 MainWindow::MainWindow()
     : QMainWindow(),
       mShowDetails(0),
       mProgressBar(0),
       mProgressBarHideTimer(0),
       mCollectionManager(new CollectionManager(this)),
-      mNotesRepository(new NotesRepository(this))
+      mNotesRepository(new NotesRepository(this)),
+      mStartupScheduler(new StartupScheduler(this)),
+      mSnapshotTimer(0)
 {
     mUi.setupUi(this);
     initialize();
@@ -155,6 +170,15 @@ void MainWindow::initialize()
             this, SLOT(slotNotesLoaded(int)));
     connect(mNotesRepository, SIGNAL(emailsLoaded(int)),
             this, SLOT(slotEmailsLoaded(int)));
+    connect(mStartupScheduler, SIGNAL(progress(int,int)),
+            this, SLOT(slotStartupProgress(int,int)));
+    connect(mStartupScheduler, SIGNAL(finished(qint64)),
+            this, SLOT(slotStartupFinished(qint64)));
+
+    // Keep the snapshot shown at the next startup reasonably recent, even if we crash
+    mSnapshotTimer = new QTimer(this);
+    mSnapshotTimer->setInterval(30 * 60 * 1000);
+    connect(mSnapshotTimer, SIGNAL(timeout()), this, SLOT(slotSaveSnapshot()));
 }
 
 void MainWindow::createActions()
@@ -181,6 +205,10 @@ void MainWindow::createActions()
     //connect(mShowDetails, SIGNAL(toggled(bool)), SLOT(slotShowDetails(bool)));
 
     mMainToolBar->addAction(printAction);
+
+    // not in the menus, for developers and bug reports
+    QShortcut *diagnosticsShortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::ALT + Qt::SHIFT + Qt::Key_D), this);
+    connect(diagnosticsShortcut, SIGNAL(activated()), this, SLOT(slotShowDiagnostics()));
 }
 
 void MainWindow::setupActions()
@@ -225,6 +253,7 @@ void MainWindow::slotResourceSelectionChanged(int index)
     AgentInstance agent = mResourceSelector->itemData(index, AgentInstanceModel::InstanceRole).value<AgentInstance>();
     if (agent.isValid()) {
         const QByteArray identifier = agent.identifier().toLatin1();
+        ResourceSettingsCache::instance()->setResource(identifier);
         emit resourceSelected(identifier);
         updateWindowTitle(agent.isOnline());
         mUi.actionSynchronize->setEnabled(true);
@@ -236,8 +265,19 @@ void MainWindow::slotResourceSelectionChanged(int index)
         ReferencedData::clearAll();
         AccountRepository::instance()->clear();
         mNotesRepository->clear();
+        mSnapshotTimer->stop();
+        loadSnapshot(agent.identifier());
+
+        // All collections are loaded in parallel, only what needs other data waits for it
+        mStartupScheduler->start(StartupScheduler::Accounts | StartupScheduler::Opportunities | StartupScheduler::Contacts |
+                                 StartupScheduler::Notes | StartupScheduler::Emails);
+        mStartupScheduler->whenDone(StartupScheduler::Accounts, this, "slotAccountsLoaded");
+        mStartupScheduler->whenDone(StartupScheduler::Accounts | StartupScheduler::Opportunities | StartupScheduler::Contacts,
+                                    this, "slotPagesLoaded");
+        mStartupScheduler->whenDone(StartupScheduler::Notes | StartupScheduler::Emails, this, "slotNotesAndEmailsLoaded");
+
         mCollectionManager->setResource(identifier);
-        slotShowMessage(i18n("(0/5) Listing folders..."));
+        slotShowMessage(i18n("Listing folders..."));
     } else {
         mUi.actionSynchronize->setEnabled(false);
         mUi.actionFullReload->setEnabled(false);
@@ -245,6 +285,42 @@ void MainWindow::slotResourceSelectionChanged(int index)
     }
 }
 
+void MainWindow::loadSnapshot(const QString &resourceIdentifier)
+{
+    mSnapshotFileName = ClientSnapshot::fileNameForResource(resourceIdentifier);
+    mSnapshot = QSharedPointer<ClientSnapshot>(new ClientSnapshot);
+    if (!mSnapshot->open(mSnapshotFileName)) {
+        mSnapshot.clear();
+        return;
+    }
+    // Silently, the combos are filled once the pages are loaded
+    for (uint i = 0; i < sizeof(s_snapshotRefTypes) / sizeof(*s_snapshotRefTypes); ++i) {
+        const ReferencedDataType type = s_snapshotRefTypes[i];
+        ReferencedData::instance(type)->addMap(mSnapshot->referencedData(type), false);
+    }
+    Q_FOREACH (Page *page, mPages) {
+        page->showSnapshot(mSnapshot);
+    }
+}
+
+void MainWindow::slotSaveSnapshot()
+{
+    // an incomplete snapshot would show missing items at the next startup
+    if (mSnapshotFileName.isEmpty() || mStartupScheduler->pendingTasks() != 0) {
+        return;
+    }
+    ClientSnapshotWriter writer;
+    Q_FOREACH (const Page *page, mPages) {
+        if (page->itemsTreeModel()) {
+            writer.addItems(page->detailsType(), page->itemsTreeModel());
+        }
+    }
+    for (uint i = 0; i < sizeof(s_snapshotRefTypes) / sizeof(*s_snapshotRefTypes); ++i) {
+        writer.addReferencedData(s_snapshotRefTypes[i]);
+    }
+    writer.save(mSnapshotFileName);
+}
+
 void MainWindow::slotResourceSelected(const Akonadi::AgentInstance &resource)
 {
     for (int index = 0; index < mResourceSelector->count(); ++index) {
@@ -320,43 +396,68 @@ void MainWindow::slotShowMessage(const QString &message)
 
 void MainWindow::slotModelLoaded(DetailsType type)
 {
-    // We load Opps, Accounts, Contacts, Notes and Emails in this order (see CollectionManager)
     //qDebug() << typeToString(type) << "loaded";
-    switch (type)
-    {
-    case Account:
-        slotShowMessage(i18n("(2/5) Loading opportunities..."));
-        break;
-    case Opportunity:
-        slotShowMessage(i18n("(3/5) Loading contacts..."));
-        break;
-    case Contact:
-        slotShowMessage(i18n("(4/5) Loading notes..."));
-        ReferencedData::emitInitialLoadingDoneForAll(); // fill combos
-        Q_FOREACH (Page *page, mPages) {
-            page->initialLoadingDone(); // select correct item in newly filled combos
-        }
-        mNotesRepository->loadNotes();
-        break;
-    case Lead:
-    case Campaign:
-        // currently unused
-        break;
-    }
+    mStartupScheduler->setDone(StartupScheduler::taskForType(type));
 }
 
 void MainWindow::slotNotesLoaded(int count)
 {
     Q_UNUSED(count);
-    slotShowMessage(i18n("(5/5) Loading emails..."));
-    mNotesRepository->loadEmails();
+    mStartupScheduler->setDone(StartupScheduler::Notes);
 }
 
 void MainWindow::slotEmailsLoaded(int count)
 {
     Q_UNUSED(count);
+    mStartupScheduler->setDone(StartupScheduler::Emails);
+}
+
+void MainWindow::slotAccountsLoaded()
+{
+    // forget the accounts from the snapshot which have been deleted since then;
+    // these are the only referenced data restored from it (s_snapshotRefTypes)
+    if (mSnapshot) {
+        QStringList removedIds;
+        const QMap<QString, QString> snapshotAccounts = mSnapshot->referencedData(AccountRef);
+        for (QMap<QString, QString>::const_iterator it = snapshotAccounts.constBegin(); it != snapshotAccounts.constEnd(); ++it) {
+            if (AccountRepository::instance()->accountById(it.key()).id().isEmpty()) {
+                removedIds.append(it.key());
+            }
+        }
+        ReferencedData::instance(AccountRef)->removeReferencedData(removedIds, false);
+        ReferencedData::instance(AccountCountryRef)->removeReferencedData(removedIds, false);
+    }
+
+    // resolve account names and countries in opportunities and contacts,
+    // without waiting for the other models
+    ReferencedData::instance(AccountRef)->emitInitialLoadingDone();
+    ReferencedData::instance(AccountCountryRef)->emitInitialLoadingDone();
+}
+
+void MainWindow::slotPagesLoaded()
+{
+    ReferencedData::emitInitialLoadingDoneForAll(); // fill combos
+    Q_FOREACH (Page *page, mPages) {
+        page->initialLoadingDone(); // select correct item in newly filled combos
+    }
+    mSnapshot.clear(); // unmapped once no page shows it anymore
+}
+
+void MainWindow::slotNotesAndEmailsLoaded()
+{
     mNotesRepository->monitorChanges();
-    slotShowMessage(i18n("Ready"));
+}
+
+void MainWindow::slotStartupProgress(int done, int total)
+{
+    slotShowMessage(i18n("(%1/%2) Loading...", done, total));
+}
+
+void MainWindow::slotStartupFinished(qint64 msecs)
+{
+    slotShowMessage(i18n("Ready (loaded in %1 seconds)", KGlobal::locale()->formatNumber(msecs / 1000.0, 1)));
+    slotSaveSnapshot();
+    mSnapshotTimer->start();
 }
 
 void MainWindow::createTabs()
@@ -435,6 +536,7 @@ void MainWindow::setupResourcesCombo()
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
+    slotSaveSnapshot();
     QMainWindow::closeEvent(event);
 }
 
@@ -467,9 +569,7 @@ void MainWindow::slotResourceOnline(const AgentInstance &resource, bool online)
         updateWindowTitle(online);
         mUi.actionOfflineMode->setChecked(!online);
         if (online) {
-            Q_FOREACH (Page *page, mPages) {
-                page->retrieveResourceUrl();
-            }
+            ResourceSettingsCache::instance()->refresh();
         }
     }
 }
@@ -563,10 +663,17 @@ void MainWindow::slotPrintReport()
         page->printReport();
 }
 
+void MainWindow::slotShowDiagnostics()
+{
+    DiagnosticsDialog *dialog = new DiagnosticsDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
 void MainWindow::slotCollectionResult(const QString &mimeType, const Collection &collection)
 {
     if (mimeType == "application/x-vnd.kdab.crm.account") {
-        slotShowMessage(i18n("(1/5) Loading accounts..."));
+        slotShowMessage(i18n("Loading..."));
     }
     foreach(Page *page, mPages) {
         if (page->mimeType() == mimeType) {
@@ -576,8 +683,10 @@ void MainWindow::slotCollectionResult(const QString &mimeType, const Collection
     }
     if (mimeType == "application/x-vnd.kdab.crm.note") {
         mNotesRepository->setNotesCollection(collection);
+        mNotesRepository->loadNotes();
     } else if (mimeType == "application/x-vnd.kdab.crm.email") {
         mNotesRepository->setEmailsCollection(collection);
+        mNotesRepository->loadEmails();
     }
 
 }
@@ -32,6 +32,7 @@
 #include "opportunitiespage.h"
 
 #include <QMainWindow>
+#include <QSharedPointer>
 
 class QAction;
 class QCheckBox;
@@ -40,9 +41,11 @@ class QProgressBar;
 class QTimer;
 class QToolBar;
 class ResourceConfigDialog;
+class ClientSnapshot;
 class CollectionManager;
 class NotesRepository;
 class ReportPage;
+class StartupScheduler;
 
 namespace Akonadi
 {
@@ -85,6 +88,10 @@ private:
     ResourceConfigDialog *mResourceDialog;
     CollectionManager *mCollectionManager;
     NotesRepository *mNotesRepository;
+    StartupScheduler *mStartupScheduler;
+    QSharedPointer<ClientSnapshot> mSnapshot; // shown until the pages are loaded
+    QString mSnapshotFileName;
+    QTimer *mSnapshotTimer;
 
     QToolBar *mMainToolBar;
     QAction *mResourceSelectorAction;
@@ -105,6 +112,12 @@ private Q_SLOTS:
     void slotModelLoaded(DetailsType type);
     void slotNotesLoaded(int count);
     void slotEmailsLoaded(int count);
+    void slotAccountsLoaded();
+    void slotPagesLoaded();
+    void slotNotesAndEmailsLoaded();
+    void slotStartupProgress(int done, int total);
+    void slotStartupFinished(qint64 msecs);
+    void slotSaveSnapshot();
     void slotConfigureResources();
     void slotResourceError(const Akonadi::AgentInstance &resource, const QString &message);
     void slotResourceOnline(const Akonadi::AgentInstance &resource, bool online);
@@ -115,6 +128,7 @@ private Q_SLOTS:
     void slotImportContacts();
     void slotConfigure();
     void slotPrintReport();
+    void slotShowDiagnostics();
     void slotCollectionResult(const QString &mimeType, const Akonadi::Collection& collection);
     void slotIgnoreModifications(bool ignore);
     void slotOppModelCreated(ItemsTreeModel *model);
@@ -128,6 +142,7 @@ private:
     void setupResourcesCombo();
     Akonadi::AgentInstance currentResource() const;
     void initialResourceSelection();
+    void loadSnapshot(const QString &resourceIdentifier);
 };
 
 #endif
@@ -73,10 +73,15 @@ void AccountDetails::setDataInternal(const QMap<QString, QString> &) const
 {
     fillComboBox(mUi->industry, KDCRMFields::industry());
     fillComboBox(mUi->account_type, KDCRMFields::accountType());
+}
 
+void AccountDetails::updateUrlLabel() const
+{
     const QString baseUrl = resourceBaseUrl();
     if (!baseUrl.isEmpty() && !id().isEmpty()) {
         const QString url = baseUrl + "?action=DetailView&module=Accounts&record=" + id();
         mUi->urllabel->setText(QString("<a href=\"%1\">Open Account in Web Browser</a>").arg(url));
+    } else {
+        mUi->urllabel->clear();
     }
 }
@@ -46,6 +46,7 @@ private:
     QMap<QString, QString> data(const Akonadi::Item &item) const Q_DECL_OVERRIDE;
     void updateItem(Akonadi::Item &item, const QMap<QString, QString> &data) const Q_DECL_OVERRIDE;
     void setDataInternal(const QMap<QString, QString> &data) const Q_DECL_OVERRIDE;
+    void updateUrlLabel() const Q_DECL_OVERRIDE;
 };
 
 #endif /* ACCOUNTDETAILS_H */
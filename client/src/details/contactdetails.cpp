@@ -252,11 +252,16 @@ void ContactDetails::setDataInternal(const QMap<QString, QString> &) const
 {
     fillComboBox(mUi->salutation, KDCRMFields::salutation());
     fillComboBox(mUi->lead_source, KDCRMFields::leadSource());
+}
 
+void ContactDetails::updateUrlLabel() const
+{
     const QString baseUrl = resourceBaseUrl();
     if (!baseUrl.isEmpty() && !id().isEmpty()) {
         const QString url = baseUrl + "?action=DetailView&module=Contacts&record=" + id();
         mUi->urllabel->setText(QString("<a href=\"%1\">Open Contact in Web Browser</a>").arg(url));
+    } else {
+        mUi->urllabel->clear();
     }
 }
 
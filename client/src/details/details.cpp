@@ -26,6 +26,8 @@
 #include "kdcrmutils.h"
 #include "qdateeditex.h"
 #include "referenceddatamodel.h"
+#include "resourcesettingscache.h"
+#include "tracer.h"
 
 #include <KLocalizedString>
 
@@ -65,10 +67,12 @@ static QStringList storedProperties()
 }
 
 Details::Details(DetailsType type, QWidget *parent)
-    : QWidget(parent), mType(type)
+    : QWidget(parent), mType(type), mBindingsBuilt(false)
 {
     // delayed init, wait for subclasses to create GUI
     QMetaObject::invokeMethod(this, "doConnects", Qt::QueuedConnection);
+    connect(ResourceSettingsCache::instance(), SIGNAL(baseUrlChanged(QString)),
+            this, SLOT(slotBaseUrlChanged()));
 }
 
 Details::~Details()
@@ -78,24 +82,102 @@ Details::~Details()
 void Details::doConnects()
 {
     // connect to changed signals
-    Q_FOREACH (QLineEdit *le, findChildren<QLineEdit *>()) {
-        if (!qobject_cast<QAbstractSpinBox *>(le->parentWidget()))
-            connect(le, SIGNAL(textChanged(QString)), this, SIGNAL(modified()));
+    Q_FOREACH (const Binding &binding, bindings()) {
+        QWidget *w = binding.widget;
+        switch (binding.kind) {
+        case Binding::LineEdit:
+            connect(w, SIGNAL(textChanged(QString)), this, SIGNAL(modified()));
+            break;
+        case Binding::ComboBox:
+            connect(w, SIGNAL(currentIndexChanged(int)), this, SIGNAL(modified()));
+            break;
+        case Binding::CheckBox:
+            connect(w, SIGNAL(toggled(bool)), this, SIGNAL(modified()));
+            break;
+        case Binding::TextEdit:
+        case Binding::PlainTextEdit:
+            connect(w, SIGNAL(textChanged()), this, SIGNAL(modified()));
+            break;
+        case Binding::SpinBox:
+            connect(w, SIGNAL(valueChanged(int)), this, SIGNAL(modified()));
+            break;
+        case Binding::DoubleSpinBox:
+            connect(w, SIGNAL(valueChanged(double)), this, SIGNAL(modified()));
+            break;
+        case Binding::DateEdit:
+            connect(w, SIGNAL(dateChanged(QDate)), this, SIGNAL(modified()));
+            break;
+        }
+    }
+}
+
+// Returns true for the widgets inside other input widgets, e.g. the line edit of a spinbox
+static bool isInternalWidget(const QWidget *widget, const QWidget *details)
+{
+    for (const QWidget *w = widget->parentWidget(); w && w != details; w = w->parentWidget()) {
+        if (qobject_cast<const QAbstractSpinBox *>(w) || qobject_cast<const QComboBox *>(w)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const QVector<Details::Binding> &Details::bindings() const
+{
+    if (!mBindingsBuilt) {
+        mBindingsBuilt = true;
+        Q_FOREACH (QWidget *w, findChildren<QWidget *>()) {
+            Binding binding;
+            if (qobject_cast<QLineEdit *>(w)) {
+                binding.kind = Binding::LineEdit;
+            } else if (qobject_cast<QComboBox *>(w)) {
+                binding.kind = Binding::ComboBox;
+            } else if (qobject_cast<QCheckBox *>(w)) {
+                binding.kind = Binding::CheckBox;
+            } else if (qobject_cast<QTextEdit *>(w)) {
+                binding.kind = Binding::TextEdit;
+            } else if (qobject_cast<QPlainTextEdit *>(w)) {
+                binding.kind = Binding::PlainTextEdit;
+            } else if (qobject_cast<QSpinBox *>(w)) {
+                binding.kind = Binding::SpinBox;
+            } else if (qobject_cast<QDoubleSpinBox *>(w)) {
+                binding.kind = Binding::DoubleSpinBox;
+            } else if (qobject_cast<QDateEditEx *>(w)) {
+                binding.kind = Binding::DateEdit;
+            } else {
+                continue;
+            }
+            binding.key = w->objectName();
+            if (binding.key.isEmpty() || isInternalWidget(w, this)) {
+                continue;
+            }
+            binding.widget = w;
+            mBindingIndex.insert(binding.key, mBindings.count());
+            mBindings.append(binding);
+        }
+    }
+    return mBindings;
+}
+
+QComboBox *Details::boundComboBox(const QString &key) const
+{
+    bindings();
+    const int index = mBindingIndex.value(key, -1);
+    if (index == -1 || mBindings.at(index).kind != Binding::ComboBox) {
+        return 0;
+    }
+    return static_cast<QComboBox *>(mBindings.at(index).widget);
+}
+
+void Details::bindCreatedModifiedLabels(QWidget *container)
+{
+    if (container == mCreatedModifiedContainer) {
+        return;
     }
-    Q_FOREACH (QComboBox *cb, findChildren<QComboBox *>())
-        connect(cb, SIGNAL(currentIndexChanged(int)), this, SIGNAL(modified()));
-    Q_FOREACH (QCheckBox *cb, findChildren<QCheckBox *>())
-        connect(cb, SIGNAL(toggled(bool)), this, SIGNAL(modified()));
-    Q_FOREACH (QTextEdit *te, findChildren<QTextEdit *>())
-        connect(te, SIGNAL(textChanged()), this, SIGNAL(modified()));
-    Q_FOREACH (QPlainTextEdit *te, findChildren<QPlainTextEdit *>())
-        connect(te, SIGNAL(textChanged()), this, SIGNAL(modified()));
-    Q_FOREACH (QSpinBox *w, findChildren<QSpinBox *>())
-        connect(w, SIGNAL(valueChanged(int)), this, SIGNAL(modified()));
-    Q_FOREACH (QDoubleSpinBox *w, findChildren<QDoubleSpinBox *>())
-        connect(w, SIGNAL(valueChanged(double)), this, SIGNAL(modified()));
-    Q_FOREACH (QDateEditEx *w, findChildren<QDateEditEx *>())
-        connect(w, SIGNAL(dateChanged(QDate)), this, SIGNAL(modified()));
+    mCreatedModifiedContainer = container;
+    mModifiedByLabel = container->findChild<QLabel *>(KDCRMFields::modifiedByName());
+    mDateEnteredLabel = container->findChild<QLabel *>(KDCRMFields::dateEntered());
+    mCreatedByLabel = container->findChild<QLabel *>(KDCRMFields::createdByName());
 }
 
 void Details::fillComboBox(QComboBox *combo, const QString &objectName) const
@@ -120,44 +202,57 @@ void Details::fillComboBox(QComboBox *combo, const QString &objectName) const
  */
 void Details::clear()
 {
-    Q_FOREACH (QLineEdit *le, findChildren<QLineEdit *>()) {
-        le->clear();
-    }
-    Q_FOREACH (QComboBox *cb, findChildren<QComboBox *>()) {
-        cb->setCurrentIndex(0);
-    }
-    Q_FOREACH (QCheckBox *cb, findChildren<QCheckBox *>()) {
-        cb->setChecked(false);
-    }
-    Q_FOREACH (QTextEdit *te, findChildren<QTextEdit *>()) {
-        te->clear();
-    }
-    Q_FOREACH (QPlainTextEdit *te, findChildren<QPlainTextEdit *>()) {
-        te->clear();
-    }
-    Q_FOREACH (QSpinBox *w, findChildren<QSpinBox *>()) {
-        w->clear();
-    }
-    Q_FOREACH (QDoubleSpinBox *w, findChildren<QDoubleSpinBox *>()) {
-        w->clear();
-    }
-    Q_FOREACH (QDateEditEx *w, findChildren<QDateEditEx *>()) {
-        w->setDate(QDate());
+    Q_FOREACH (const Binding &binding, bindings()) {
+        QWidget *w = binding.widget;
+        switch (binding.kind) {
+        case Binding::LineEdit:
+            static_cast<QLineEdit *>(w)->clear();
+            break;
+        case Binding::ComboBox:
+            static_cast<QComboBox *>(w)->setCurrentIndex(0);
+            break;
+        case Binding::CheckBox:
+            static_cast<QCheckBox *>(w)->setChecked(false);
+            break;
+        case Binding::TextEdit:
+            static_cast<QTextEdit *>(w)->clear();
+            break;
+        case Binding::PlainTextEdit:
+            static_cast<QPlainTextEdit *>(w)->clear();
+            break;
+        case Binding::SpinBox:
+        case Binding::DoubleSpinBox:
+            static_cast<QAbstractSpinBox *>(w)->clear();
+            break;
+        case Binding::DateEdit:
+            static_cast<QDateEditEx *>(w)->setDate(QDate());
+            break;
+        }
     }
     Q_FOREACH (const QString &prop, storedProperties()) {
         setProperty(prop.toLatin1(), QVariant());
     }
+    clearInternal();
 }
 
-void Details::setResourceIdentifier(const QByteArray &ident, const QString &baseUrl)
+void Details::setResourceIdentifier(const QByteArray &ident)
 {
     mResourceIdentifier = ident;
-    mResourceBaseUrl = baseUrl;
+}
+
+QString Details::resourceBaseUrl() const
+{
+    return ResourceSettingsCache::instance()->baseUrl();
+}
+
+void Details::slotBaseUrlChanged()
+{
+    updateUrlLabel();
 }
 
 void Details::setSupportedFields(const QStringList &fields)
 {
-    mKeys = fields;
+    mKeys = fields.toSet();
     Q_ASSERT(mKeys.contains("id"));
 }
 
@@ -188,6 +283,10 @@ QString Details::windowTitle() const
 void Details::setData(const QMap<QString, QString> &data,
                       QWidget *createdModifiedContainer)
 {
+    TraceScope trace("Details::setData", "details");
+    if (data.value(KDCRMFields::id()) != id()) {
+        clearInternal();
+    }
     Q_FOREACH (const QString &prop, storedProperties()) {
         if (data.contains(prop)) {
             setProperty(prop.toLatin1(), data.value(prop));
@@ -196,88 +295,73 @@ void Details::setData(const QMap<QString, QString> &data,
     setProperty("name", data.value("name")); // displayed in lineedit, but useful for subclasses (e.g. NotesDialog title)
 
     if (mKeys.isEmpty()) {
-        mKeys = data.keys(); // remember what are the expected keys, so getData can skip internal widgets
+        mKeys = data.keys().toSet(); // remember what are the expected keys, so getData can skip internal widgets
         Q_ASSERT(mKeys.contains("id"));
     }
 
     // Ensure comboboxes are filled
     setDataInternal(data);
+    updateUrlLabel();
 
-    QString key;
-
-    QList<QLineEdit *> lineEdits = findChildren<QLineEdit *>();
-    Q_FOREACH (QLineEdit *le, lineEdits) {
-        key = le->objectName();
-        if (!data.contains(key)) continue; // skip internal lineedits (e.g. in spinbox)
-        le->setText(data.value(key));
-    }
-    QList<QComboBox *> comboBoxes = findChildren<QComboBox *>();
-    Q_FOREACH (QComboBox *cb, comboBoxes) {
-        key = cb->objectName();
-        if (!data.contains(key)) continue; // skip internal combos (e.g. in QDateEditEx)
-        const int idx = cb->findData(data.value(key));
-        if (idx == -1 && cb->count() > 1) {
-            kDebug() << "Didn't find" << data.value(key) << "in combo" << key;
-            //for (int row = 0; row < cb->count(); ++row) {
-            //    kDebug() << "  " << cb->itemData(row);
-            //}
+    Q_FOREACH (const Binding &binding, bindings()) {
+        const QMap<QString, QString>::const_iterator it = data.constFind(binding.key);
+        if (it == data.constEnd()) {
+            continue;
+        }
+        const QString &value = it.value();
+        QWidget *w = binding.widget;
+        switch (binding.kind) {
+        case Binding::LineEdit:
+            static_cast<QLineEdit *>(w)->setText(value);
+            break;
+        case Binding::ComboBox: {
+            QComboBox *cb = static_cast<QComboBox *>(w);
+            const int idx = ReferencedDataModel::findId(cb, value);
+            if (idx == -1 && cb->count() > 1) {
+                kDebug() << "Didn't find" << value << "in combo" << binding.key;
+                //for (int row = 0; row < cb->count(); ++row) {
+                //    kDebug() << "  " << cb->itemData(row);
+                //}
+            }
+            cb->setCurrentIndex(idx);
+            break;
+        }
+        case Binding::CheckBox:
+            static_cast<QCheckBox *>(w)->setChecked(value == "1" ? true : false);
+            break;
+        case Binding::TextEdit:
+            static_cast<QTextEdit *>(w)->setPlainText(value);
+            break;
+        case Binding::PlainTextEdit:
+            static_cast<QPlainTextEdit *>(w)->setPlainText(value);
+            break;
+        case Binding::SpinBox:
+            static_cast<QSpinBox *>(w)->setValue(value.toInt());
+            break;
+        case Binding::DoubleSpinBox: {
+            QDoubleSpinBox *sb = static_cast<QDoubleSpinBox *>(w);
+            //kDebug() << value;
+            sb->setValue(QLocale::c().toDouble(value));
+            if (binding.key == KDCRMFields::amount())
+                sb->setSuffix(data.value(KDCRMFields::currencySymbol()));
+            break;
+        }
+        case Binding::DateEdit:
+            //kDebug() << w << "setDate" << binding.key << value << KDCRMUtils::dateFromString(value);
+            static_cast<QDateEditEx *>(w)->setDate(KDCRMUtils::dateFromString(value));
+            break;
         }
-        cb->setCurrentIndex(idx);
-    }
-
-    QList<QCheckBox *> checkBoxes = findChildren<QCheckBox *>();
-    Q_FOREACH (QCheckBox *cb, checkBoxes) {
-        key = cb->objectName();
-        if (!data.contains(key)) continue;
-        cb->setChecked(data.value(key) == "1" ? true : false);
-    }
-
-    QList<QTextEdit *> textEdits = findChildren<QTextEdit *>();
-    Q_FOREACH (QTextEdit *w, textEdits) {
-        key = w->objectName();
-        if (!data.contains(key)) continue;
-        w->setPlainText(data.value(key));
-    }
-
-    QList<QPlainTextEdit *> plainTextEdits = findChildren<QPlainTextEdit *>();
-    Q_FOREACH (QPlainTextEdit *w, plainTextEdits) {
-        key = w->objectName();
-        if (!data.contains(key)) continue;
-        w->setPlainText(data.value(key));
-    }
-
-    Q_FOREACH (QSpinBox *w, findChildren<QSpinBox *>()) {
-        key = w->objectName();
-        if (!data.contains(key)) continue;
-        w->setValue(data.value(key).toInt());
     }
 
-    Q_FOREACH (QDoubleSpinBox *w, findChildren<QDoubleSpinBox *>()) {
-        key = w->objectName();
-        if (!data.contains(key)) continue;
-        //kDebug() << data.value(key);
-        w->setValue(QLocale::c().toDouble(data.value(key)));
-        if (key == KDCRMFields::amount())
-            w->setSuffix(data.value(KDCRMFields::currencySymbol()));
+    bindCreatedModifiedLabels(createdModifiedContainer);
+    if (mModifiedByLabel) {
+        mModifiedByLabel->setText(data.value(KDCRMFields::modifiedByName()));
     }
-
-    Q_FOREACH (QDateEditEx *w, findChildren<QDateEditEx *>()) {
-        key = w->objectName();
-        if (!data.contains(key)) continue;
-        //kDebug() << w << "setDate" << key << data.value(key) << KDCRMUtils::dateFromString(data.value(key));
-        w->setDate(KDCRMUtils::dateFromString(data.value(key)));
+    if (mDateEnteredLabel) {
+        mDateEnteredLabel->setText(KDCRMUtils::formatTimestamp(data.value(KDCRMFields::dateEntered())));
     }
-
-    QList<QLabel *> labels = createdModifiedContainer->findChildren<QLabel *>();
-    Q_FOREACH (QLabel *lb, labels) {
-        key = lb->objectName();
-        if (key == KDCRMFields::modifiedByName()) {
-            lb->setText(data.value(KDCRMFields::modifiedByName()));
-        } else if (key == KDCRMFields::dateEntered()) {
-            lb->setText(KDCRMUtils::formatTimestamp(data.value(KDCRMFields::dateEntered())));
-        } else if (key == KDCRMFields::createdByName()) {
-            lb->setText(data.value(KDCRMFields::createdByName()));
-        }
+    if (mCreatedByLabel) {
+        mCreatedByLabel->setText(data.value(KDCRMFields::createdByName()));
     }
 }
 
@@ -290,59 +374,42 @@ const QMap<QString, QString> Details::getData() const
     Q_ASSERT(mKeys.contains("id"));
 
     QMap<QString, QString> currentData;
-    QString key;
-    QList<QLineEdit *> lineEdits = findChildren<QLineEdit *>();
-    Q_FOREACH (QLineEdit *le, lineEdits) {
-        key = le->objectName();
-        if (!mKeys.contains(key)) continue;
-        if (qobject_cast<QAbstractSpinBox *>(le->parent())) continue;
-        currentData[key] = le->text();
-    }
-
-    QList<QComboBox *> comboBoxes = findChildren<QComboBox *>();
-    Q_FOREACH (QComboBox *cb, comboBoxes) {
-        key = cb->objectName();
-        if (!mKeys.contains(key)) { kDebug() << "skipping" << key; continue; }
-        currentData[key] = cb->itemData(cb->currentIndex()).toString();
-    }
-
-    QList<QCheckBox *> checkBoxes = findChildren<QCheckBox *>();
-    Q_FOREACH (QCheckBox *cb, checkBoxes) {
-        key = cb->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData[key] = cb->isChecked() ? "1" : "0";
-    }
-
-    QList<QTextEdit *> textEdits = findChildren<QTextEdit *>();
-    Q_FOREACH (QTextEdit *w, textEdits) {
-        key = w->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData[key] = w->toPlainText();
-    }
-
-    QList<QPlainTextEdit *> plainTextEdits = findChildren<QPlainTextEdit *>();
-    Q_FOREACH (QPlainTextEdit *w, plainTextEdits) {
-        key = w->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData.insert(key, w->toPlainText());
-    }
-
-    Q_FOREACH (QSpinBox *w, findChildren<QSpinBox *>()) {
-        key = w->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData[key] = QString::number(w->value());
-    }
-
-    Q_FOREACH (QDoubleSpinBox *w, findChildren<QDoubleSpinBox *>()) {
-        key = w->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData[key] = QString::number(w->value());
-    }
-
-    Q_FOREACH (QDateEditEx *w, findChildren<QDateEditEx *>()) {
-        key = w->objectName();
-        if (!mKeys.contains(key)) continue;
-        currentData.insert(key, KDCRMUtils::dateToString(w->date()));
+    Q_FOREACH (const Binding &binding, bindings()) {
+        if (!mKeys.contains(binding.key)) {
+            if (binding.kind == Binding::ComboBox) {
+                kDebug() << "skipping" << binding.key;
+            }
+            continue;
+        }
+        const QWidget *w = binding.widget;
+        switch (binding.kind) {
+        case Binding::LineEdit:
+            currentData[binding.key] = static_cast<const QLineEdit *>(w)->text();
+            break;
+        case Binding::ComboBox: {
+            const QComboBox *cb = static_cast<const QComboBox *>(w);
+            currentData[binding.key] = cb->itemData(cb->currentIndex()).toString();
+            break;
+        }
+        case Binding::CheckBox:
+            currentData[binding.key] = static_cast<const QCheckBox *>(w)->isChecked() ? "1" : "0";
+            break;
+        case Binding::TextEdit:
+            currentData[binding.key] = static_cast<const QTextEdit *>(w)->toPlainText();
+            break;
+        case Binding::PlainTextEdit:
+            currentData[binding.key] = static_cast<const QPlainTextEdit *>(w)->toPlainText();
+            break;
+        case Binding::SpinBox:
+            currentData[binding.key] = QString::number(static_cast<const QSpinBox *>(w)->value());
+            break;
+        case Binding::DoubleSpinBox:
+            currentData[binding.key] = QString::number(static_cast<const QDoubleSpinBox *>(w)->value());
+            break;
+        case Binding::DateEdit:
+            currentData[binding.key] = KDCRMUtils::dateToString(static_cast<const QDateEditEx *>(w)->date());
+            break;
+        }
     }
 
     Q_FOREACH (const QString &prop, storedProperties()) {
@@ -369,12 +436,12 @@ QString Details::currentAccountId() const
     // Account has KDCRMFields::parentId()
     // Contact, Leads, Opportunity have KDCRMFields::accountId()
     if (mType != Campaign) {
-        const QList<QComboBox *> comboBoxes = findChildren<QComboBox *>();
-        Q_FOREACH (QComboBox *cb, comboBoxes) {
-            const QString key = cb->objectName();
-            if (key == KDCRMFields::parentId() || key == KDCRMFields::accountId()) {
-                return cb->itemData(cb->currentIndex()).toString();
-            }
+        const QComboBox *cb = boundComboBox(KDCRMFields::parentId());
+        if (!cb) {
+            cb = boundComboBox(KDCRMFields::accountId());
+        }
+        if (cb) {
+            return cb->itemData(cb->currentIndex()).toString();
         }
     }
     return QString();
@@ -385,14 +452,11 @@ void Details::assignToMe()
     const QString fullUserName = ClientSettings::self()->fullUserName();
     if (fullUserName.isEmpty())
         return;
-    const QList<QComboBox *> comboBoxes = findChildren<QComboBox *>();
-    Q_FOREACH (QComboBox *cb, comboBoxes) {
-        const QString key = cb->objectName();
-        if (key == KDCRMFields::assignedUserId()) {
-            const int idx = cb->findText(fullUserName);
-            if (idx >= 0) {
-                cb->setCurrentIndex(idx);
-            }
+    QComboBox *cb = boundComboBox(KDCRMFields::assignedUserId());
+    if (cb) {
+        const int idx = cb->findText(fullUserName);
+        if (idx >= 0) {
+            cb->setCurrentIndex(idx);
         }
     }
 }
@@ -28,9 +28,14 @@
 
 #include <Akonadi/Item>
 
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
 #include <QWidget>
 
 class QComboBox;
+class QLabel;
 class NotesRepository;
 
 class Details : public QWidget
@@ -49,7 +54,7 @@ public:
     const QMap<QString, QString> getData() const;
     void clear();
 
-    void setResourceIdentifier(const QByteArray &ident, const QString &baseUrl);
+    void setResourceIdentifier(const QByteArray &ident);
     void setSupportedFields(const QStringList &fields);
     void setEnumDefinitions(const EnumDefinitions &enums);
     virtual void setNotesRepository(NotesRepository *notesRepo) { Q_UNUSED(notesRepo); }
@@ -68,23 +73,65 @@ Q_SIGNALS:
 
 protected:
     QByteArray resourceIdentifier() const { return mResourceIdentifier; }
-    QString resourceBaseUrl() const { return mResourceBaseUrl; }
+    QString resourceBaseUrl() const;
+
+    /**
+     * Shows the link to the item in the web interface, if any.
+     * Called after setDataInternal() and when the base URL changes.
+     */
+    virtual void updateUrlLabel() const {}
 
     void fillComboBox(QComboBox *combo, const QString &objectName) const;
 
     virtual void setDataInternal(const QMap<QString, QString> &) const {}
+
+    /**
+     * Drops the state that belongs to the shown item.
+     * Called by clear() and before the data of another item is set.
+     */
+    virtual void clearInternal() {}
     QString id() const;
 
     QString currentAccountId() const;
 
 private Q_SLOTS:
     void doConnects();
+    void slotBaseUrlChanged();
 
 private:
+    // An input widget and the field it shows (its object name)
+    struct Binding
+    {
+        enum Kind {
+            LineEdit,
+            ComboBox,
+            CheckBox,
+            TextEdit,
+            PlainTextEdit,
+            SpinBox,
+            DoubleSpinBox,
+            DateEdit
+        };
+        Kind kind;
+        QString key;
+        QWidget *widget;
+    };
+    const QVector<Binding> &bindings() const;
+    QComboBox *boundComboBox(const QString &key) const;
+    void bindCreatedModifiedLabels(QWidget *container);
+
     const DetailsType mType;
     QByteArray mResourceIdentifier;
-    QString mResourceBaseUrl;
-    QStringList mKeys;
+    QSet<QString> mKeys;
     EnumDefinitions mEnumDefinitions;
+
+    // found once (after the subclass created the GUI) rather than on each item
+    mutable QVector<Binding> mBindings;
+    mutable QHash<QString, int> mBindingIndex; // key => index in mBindings
+    mutable bool mBindingsBuilt;
+    QPointer<QWidget> mCreatedModifiedContainer;
+    QPointer<QLabel> mModifiedByLabel;
+    QPointer<QLabel> mDateEnteredLabel;
+    QPointer<QLabel> mCreatedByLabel;
 };
 #endif /* DETAILS_H */
@@ -36,7 +36,7 @@
 #include <QCalendarWidget>
 
 OpportunityDetails::OpportunityDetails(QWidget *parent)
-    : Details(Opportunity, parent), mUi(new Ui::OpportunityDetails)
+    : Details(Opportunity, parent), mUi(new Ui::OpportunityDetails), mNotesRepository(0)
 {
     mUi->setupUi(this);
 
@@ -52,6 +52,12 @@ OpportunityDetails::~OpportunityDetails()
     delete mUi;
 }
 
+void OpportunityDetails::setNotesRepository(NotesRepository *notesRepo)
+{
+    mNotesRepository = notesRepo;
+    connect(mNotesRepository, SIGNAL(bodiesLoaded(QString)), this, SLOT(slotNotesBodiesLoaded(QString)));
+}
+
 void OpportunityDetails::initialize()
 {
     ReferencedDataModel::setModelForCombo(mUi->account_id, AccountRef);
@@ -108,6 +114,21 @@ void OpportunityDetails::setDataInternal(const QMap<QString, QString> &) const
     fillComboBox(mUi->lead_source, KDCRMFields::leadSource());
     fillComboBox(mUi->sales_stage, KDCRMFields::salesStage());
 
+    const QString oppId = id();
+    const int notes = oppId.isEmpty() ? 0 : mNotesRepository->countForOpportunity(oppId);
+    mUi->viewNotesButton->setEnabled(notes > 0);
+    const QString buttonText = (notes == 0) ? i18n("View Notes") : i18np("View 1 Note", "View %1 Notes", notes);
+    mUi->viewNotesButton->setText(buttonText);
+}
+
+void OpportunityDetails::clearInternal()
+{
+    // the notes of the previous opportunity must not pop up anymore
+    mPendingNotesOpportunityId.clear();
+}
+
+void OpportunityDetails::updateUrlLabel() const
+{
     const QString baseUrl = resourceBaseUrl();
     const QString oppId = id();
     if (!baseUrl.isEmpty() && !oppId.isEmpty()) {
@@ -116,16 +137,29 @@ void OpportunityDetails::setDataInternal(const QMap<QString, QString> &) const
     } else {
         mUi->urllabel->clear();
     }
-
-    const int notes = oppId.isEmpty() ? 0 : mNotesRepository->notesForOpportunity(oppId).count() + mNotesRepository->emailsForOpportunity(oppId).count();
-    mUi->viewNotesButton->setEnabled(notes > 0);
-    const QString buttonText = (notes == 0) ? i18n("View Notes") : i18np("View 1 Note", "View %1 Notes", notes);
-    mUi->viewNotesButton->setText(buttonText);
 }
 
 void OpportunityDetails::on_viewNotesButton_clicked()
 {
     const QString oppId = id();
+    if (mNotesRepository->hasBodies(oppId)) {
+        showNotesDialog(oppId);
+    } else {
+        mPendingNotesOpportunityId = oppId;
+        mNotesRepository->prefetch(QStringList() << oppId);
+    }
+}
+
+void OpportunityDetails::slotNotesBodiesLoaded(const QString &oppId)
+{
+    if (oppId == mPendingNotesOpportunityId) {
+        mPendingNotesOpportunityId.clear();
+        showNotesDialog(oppId);
+    }
+}
+
+void OpportunityDetails::showNotesDialog(const QString &oppId)
+{
     const QVector<SugarNote> notes = mNotesRepository->notesForOpportunity(oppId);
     kDebug() << notes.count() << "notes found for opp" << oppId;
     const QVector<SugarEmail> emails = mNotesRepository->emailsForOpportunity(oppId);
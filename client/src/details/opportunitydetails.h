@@ -39,7 +39,7 @@ public:
 
     ~OpportunityDetails();
 
-    void setNotesRepository(NotesRepository *notesRepo) Q_DECL_OVERRIDE { mNotesRepository = notesRepo; }
+    void setNotesRepository(NotesRepository *notesRepo) Q_DECL_OVERRIDE;
 
 private Q_SLOTS:
     void slotAutoNextStepDate();
@@ -47,16 +47,21 @@ private Q_SLOTS:
 
     void on_viewNotesButton_clicked();
     void on_buttonOpenAccount_clicked();
+    void slotNotesBodiesLoaded(const QString &oppId);
 
 private:
     void initialize();
+    void showNotesDialog(const QString &oppId);
     QMap<QString, QString> data(const Akonadi::Item &item) const Q_DECL_OVERRIDE;
     void updateItem(Akonadi::Item &item, const QMap<QString, QString> &data) const Q_DECL_OVERRIDE;
     void setDataInternal(const QMap<QString, QString> &data) const Q_DECL_OVERRIDE;
+    void clearInternal() Q_DECL_OVERRIDE;
+    void updateUrlLabel() const Q_DECL_OVERRIDE;
 
 private:
     Ui::OpportunityDetails *mUi;
     NotesRepository *mNotesRepository;
+    QString mPendingNotesOpportunityId; // the notes dialog is shown once its bodies are fetched
 };
 
 #endif /* OPPORTUNITYDETAILS_H */
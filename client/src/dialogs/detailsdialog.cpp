@@ -36,6 +36,7 @@
 #include <Akonadi/ItemModifyJob>
 
 #include <QDialogButtonBox>
+#include <QPointer>
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QDebug>
@@ -64,6 +65,7 @@ public:
     Details *mDetails;
     QDialogButtonBox *mButtonBox;
     QPushButton *mSaveButton;
+    QList<QPointer<KJob> > mSaveJobs; // started for the current use of the dialog
 
 public: // slots
     void saveClicked();
@@ -113,6 +115,7 @@ void DetailsDialog::Private::saveClicked()
         job = new ItemCreateJob(item, mCollection, q);
     }
 
+    mSaveJobs.append(job);
     QObject::connect(job, SIGNAL(result(KJob*)), q, SLOT(saveResult(KJob*)));
 }
 
@@ -123,6 +126,7 @@ void DetailsDialog::Private::dataModified()
 
 void DetailsDialog::Private::saveResult(KJob *job)
 {
+    mSaveJobs.removeAll(job);
     kDebug() << "save result=" << job->error();
     if (job->error() != 0) {
         kError() << job->errorText();
@@ -166,10 +170,38 @@ DetailsDialog::DetailsDialog(Details *details, QWidget *parent)
 
 DetailsDialog::~DetailsDialog()
 {
-    ClientSettings::self()->saveWindowSize("details", this);
     delete d;
 }
 
+void DetailsDialog::done(int result)
+{
+    // not in the destructor: pooled dialogs can be deleted without having been shown
+    ClientSettings::self()->saveWindowSize("details", this);
+    QDialog::done(result);
+}
+
+void DetailsDialog::reset()
+{
+    // Let the saves still running finish on their own: their result must not
+    // close the dialog again once it is pooled, or reused for another item
+    foreach (const QPointer<KJob> &job, d->mSaveJobs) {
+        if (job) {
+            job->disconnect(this);
+            job->setParent(0);
+        }
+    }
+    d->mSaveJobs.clear();
+    d->mItem = Item();
+    d->mCollection = Collection();
+    d->mDetails->clear();
+    d->mUi.date_modified->clear();
+    d->mUi.description->clear();
+    d->mUi.createdModifiedContainer->show();
+    d->mSaveButton->setEnabled(false);
+    // possibly resized by another dialog meanwhile
+    ClientSettings::self()->restoreWindowSize("details", this);
+}
+
 // open for creation
 void DetailsDialog::showNewItem(const QMap<QString, QString> &data, const Akonadi::Collection &collection)
 {
@@ -44,6 +44,14 @@ public:
 
     void showNewItem(const QMap<QString, QString> &data, const Akonadi::Collection &collection);
 
+    /**
+     * Forgets the item and clears the fields, so that the dialog can be reused
+     * (see Page::createDetailsDialog()).
+     */
+    void reset();
+
+    void done(int result) Q_DECL_OVERRIDE;
+
 public Q_SLOTS:
     void setItem(const Akonadi::Item &item);
     void updateItem(const Akonadi::Item &item);
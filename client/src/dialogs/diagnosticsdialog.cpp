@@ -0,0 +1,90 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "diagnosticsdialog.h"
+#include "tracer.h"
+
+#include <KLocalizedString>
+
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTimer>
+#include <QVBoxLayout>
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle(i18n("Diagnostics"));
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    mRecordCheckBox = new QCheckBox(i18n("Record traces"), this);
+    mRecordCheckBox->setChecked(Tracer::isEnabled());
+    connect(mRecordCheckBox, SIGNAL(toggled(bool)), this, SLOT(slotRecordingToggled(bool)));
+    layout->addWidget(mRecordCheckBox);
+    mEventCountLabel = new QLabel(this);
+    layout->addWidget(mEventCountLabel);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, Qt::Horizontal, this);
+    QPushButton *exportButton = buttonBox->addButton(i18n("Export..."), QDialogButtonBox::ActionRole);
+    connect(exportButton, SIGNAL(clicked()), this, SLOT(slotExport()));
+    QPushButton *clearButton = buttonBox->addButton(i18n("Clear"), QDialogButtonBox::ResetRole);
+    connect(clearButton, SIGNAL(clicked()), this, SLOT(slotClear()));
+    connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+    layout->addWidget(buttonBox);
+
+    QTimer *timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(updateEventCount()));
+    timer->start(1000);
+    updateEventCount();
+}
+
+void DiagnosticsDialog::slotRecordingToggled(bool on)
+{
+    Tracer::instance()->setEnabled(on);
+}
+
+void DiagnosticsDialog::slotExport()
+{
+    const QString fileName = QFileDialog::getSaveFileName(this, i18n("Export Trace"), "fatcrm-trace.json",
+                                                          i18n("Chrome trace (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+    if (!Tracer::instance()->exportChromeTrace(fileName)) {
+        QMessageBox::warning(this, i18n("Export Trace"), i18n("Cannot write %1", fileName));
+    }
+}
+
+void DiagnosticsDialog::slotClear()
+{
+    Tracer::instance()->clear();
+    updateEventCount();
+}
+
+void DiagnosticsDialog::updateEventCount()
+{
+    Tracer *tracer = Tracer::instance();
+    mEventCountLabel->setText(i18n("%1 of at most %2 events recorded", tracer->eventCount(), tracer->capacity()));
+}
@@ -0,0 +1,204 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "displaycache.h"
+
+#include <QDateTime>
+
+#include <limits>
+#include <string.h>
+
+// Appends @p value so that the byte order of keys is the numeric order of values
+static void appendOrderedInt64(QByteArray &key, qint64 value)
+{
+    const quint64 bits = quint64(value) ^ (Q_UINT64_C(1) << 63);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        key.append(char(bits >> shift));
+    }
+}
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+// QString::localeAwareCompare() uses strcoll() on the local 8 bit encoding on this platform,
+// and compares the UTF-16 code units when strcoll() considers both strings equal
+static QByteArray collationKey(const QString &text)
+{
+    const QByteArray local = text.toLocal8Bit();
+    const size_t size = strxfrm(0, local.constData(), 0);
+    QByteArray key;
+    key.resize(int(size) + 1);
+    strxfrm(key.data(), local.constData(), size + 1);
+    key.resize(int(size));
+    // strxfrm() output contains no NUL, so this terminator sorts shorter keys first
+    key.append('\0');
+    key.reserve(key.size() + 2 * text.size());
+    const ushort *c = text.utf16();
+    for (int i = 0; i < text.size(); ++i) {
+        key.append(char(c[i] >> 8));
+        key.append(char(c[i] & 0xff));
+    }
+    return key;
+}
+#endif
+
+DisplayCache::DisplayCache(int columnCount)
+    : mSlotCount(0)
+{
+    setColumnCount(columnCount);
+}
+
+void DisplayCache::setColumnCount(int columnCount)
+{
+    clear();
+    mDisplayValues.resize(columnCount);
+    mEditValues.resize(columnCount);
+    mSortKeys.resize(columnCount);
+}
+
+int DisplayCache::columnCount() const
+{
+    return mDisplayValues.count();
+}
+
+int DisplayCache::insert(qint64 id)
+{
+    QHash<qint64, int>::const_iterator it = mSlots.constFind(id);
+    if (it != mSlots.constEnd())
+        return it.value();
+
+    int slot;
+    if (!mFreeSlots.isEmpty()) {
+        slot = mFreeSlots.last();
+        mFreeSlots.pop_back();
+    } else {
+        slot = mSlotCount++;
+        for (int column = 0; column < mDisplayValues.count(); ++column) {
+            mDisplayValues[column].resize(mSlotCount);
+            mSortKeys[column].resize(mSlotCount);
+        }
+    }
+    mSlots.insert(id, slot);
+    return slot;
+}
+
+void DisplayCache::setValue(int slot, int column, const QVariant &display, const QVariant &edit)
+{
+    Q_ASSERT(slot >= 0 && slot < mSlotCount);
+    mDisplayValues[column][slot] = display;
+
+    QVector<QVariant> &editValues = mEditValues[column];
+    if (edit.isValid()) {
+        if (editValues.count() < mSlotCount)
+            editValues.resize(mSlotCount);
+        editValues[slot] = edit;
+    } else if (slot < editValues.count()) {
+        editValues[slot] = QVariant();
+    }
+    mSortKeys[column][slot] = makeSortKey(edit.isValid() ? edit : display);
+}
+
+void DisplayCache::setSortKey(int slot, int column, const QByteArray &key)
+{
+    Q_ASSERT(slot >= 0 && slot < mSlotCount);
+    mSortKeys[column][slot] = key;
+}
+
+void DisplayCache::remove(qint64 id)
+{
+    QHash<qint64, int>::iterator it = mSlots.find(id);
+    if (it == mSlots.end())
+        return;
+    const int slot = it.value();
+    mSlots.erase(it);
+    for (int column = 0; column < mDisplayValues.count(); ++column) {
+        mDisplayValues[column][slot] = QVariant();
+        mSortKeys[column][slot] = QByteArray();
+        QVector<QVariant> &editValues = mEditValues[column];
+        if (slot < editValues.count())
+            editValues[slot] = QVariant();
+    }
+    mFreeSlots.append(slot);
+}
+
+void DisplayCache::clear()
+{
+    mSlots.clear();
+    mFreeSlots.clear();
+    mSlotCount = 0;
+    for (int column = 0; column < mDisplayValues.count(); ++column) {
+        mDisplayValues[column].clear();
+        mEditValues[column].clear();
+        mSortKeys[column].clear();
+    }
+}
+
+QVariant DisplayCache::value(int slot, int column, int role) const
+{
+    if (role == Qt::EditRole) {
+        const QVector<QVariant> &editValues = mEditValues.at(column);
+        if (slot < editValues.count()) {
+            const QVariant &edit = editValues.at(slot);
+            if (edit.isValid())
+                return edit;
+        }
+    }
+    return mDisplayValues.at(column).at(slot);
+}
+
+QByteArray DisplayCache::makeSortKey(const QVariant &value)
+{
+    QByteArray key;
+    switch (value.userType()) {
+    case QVariant::Invalid:
+        key = QByteArray(""); // before everything else, but not null
+        break;
+    case QVariant::Date: {
+        const QDate date = value.toDate();
+        appendOrderedInt64(key, date.isValid() ? date.toJulianDay() : std::numeric_limits<qint64>::min());
+        break;
+    }
+    case QVariant::DateTime: {
+        const QDateTime dateTime = value.toDateTime();
+        if (dateTime.isValid()) {
+            appendOrderedInt64(key, qint64(dateTime.date().toJulianDay()) * 86400 + QTime(0, 0).secsTo(dateTime.time()));
+        } else {
+            appendOrderedInt64(key, std::numeric_limits<qint64>::min());
+        }
+        break;
+    }
+    case QVariant::String:
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+        key = collationKey(value.toString());
+#endif
+        break;
+    default:
+        break;
+    }
+    return key;
+}
+
+int DisplayCache::compareSortKeys(const QByteArray &left, const QByteArray &right)
+{
+    const int ret = memcmp(left.constData(), right.constData(), qMin(left.size(), right.size()));
+    if (ret != 0)
+        return ret;
+    return left.size() - right.size();
+}
@@ -0,0 +1,105 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISPLAYCACHE_H
+#define DISPLAYCACHE_H
+
+#include <QHash>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * Caches the DisplayRole and EditRole values of a list of items.
+ *
+ * The values are stored as one array per column (struct of arrays), indexed
+ * by a slot number assigned to each item id. Sorting or filtering on a column
+ * therefore only touches that column's array.
+ * Most columns have the same value for both roles, the edit array of a column
+ * is only allocated once a different edit value is stored in it.
+ *
+ * Each value also gets a sort key, a byte array whose order is the order of
+ * the value, so that sorting only needs byte comparisons.
+ */
+class DisplayCache
+{
+public:
+    explicit DisplayCache(int columnCount = 0);
+
+    void setColumnCount(int columnCount);
+    int columnCount() const;
+
+    /**
+     * Returns the slot of the item @p id, allocating one if needed.
+     */
+    int insert(qint64 id);
+
+    /**
+     * Stores the values of @p column for the item in @p slot.
+     * An invalid @p edit means that the edit value is the same as @p display.
+     */
+    void setValue(int slot, int column, const QVariant &display, const QVariant &edit = QVariant());
+
+    void remove(qint64 id);
+    void clear();
+
+    /**
+     * Returns the slot of the item @p id, or -1 if it isn't cached.
+     */
+    int slot(qint64 id) const { return mSlots.value(id, -1); }
+    bool contains(qint64 id) const { return mSlots.contains(id); }
+    int count() const { return mSlots.count(); }
+
+    /**
+     * Returns the cached value for @p role (Qt::DisplayRole or Qt::EditRole).
+     */
+    QVariant value(int slot, int column, int role) const;
+
+    /**
+     * Returns the sort key of the value in @p slot and @p column.
+     * By default it is computed from the edit value by makeSortKey().
+     */
+    QByteArray sortKey(int slot, int column) const { return mSortKeys.at(column).at(slot); }
+    void setSortKey(int slot, int column, const QByteArray &key);
+
+    /**
+     * Returns a key whose byte order is the sort order of @p value: like
+     * QString::localeAwareCompare() for strings, chronological for dates,
+     * and invalid values first. Returns a null array if @p value can't be
+     * turned into a key on this platform.
+     */
+    static QByteArray makeSortKey(const QVariant &value);
+
+    /**
+     * Compares two keys returned by makeSortKey(), like memcmp().
+     */
+    static int compareSortKeys(const QByteArray &left, const QByteArray &right);
+
+private:
+    QHash<qint64, int> mSlots;
+    QVector<int> mFreeSlots;
+    int mSlotCount;
+    QVector<QVector<QVariant> > mDisplayValues;
+    QVector<QVector<QVariant> > mEditValues;
+    QVector<QVector<QByteArray> > mSortKeys;
+};
+
+#endif
@@ -21,7 +21,10 @@
 */
 
 #include "filterproxymodel.h"
+#include "displaycache.h"
 #include "itemstreemodel.h"
+#include "searchindex.h"
+#include "tracer.h"
 
 #include "kdcrmdata/sugaraccount.h"
 #include "kdcrmdata/sugarcampaign.h"
@@ -34,40 +37,193 @@
 
 #include <KLocalizedString>
 
-static bool accountMatchesFilter(const SugarAccount &account,
-                                 const QString &filterString);
-static bool campaignMatchesFilter(const SugarCampaign &campaign,
-                                  const QString &filterString);
-static bool contactMatchesFilter(const KABC::Addressee &addressee,
-                                 const QString &filterString);
-static bool leadMatchesFilter(const SugarLead &lead,
-                              const QString &filterString);
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QtConcurrentMap>
+
+static QStringList accountSearchTexts(const SugarAccount &account);
+static QStringList campaignSearchTexts(const SugarCampaign &campaign);
+static QStringList contactSearchTexts(const KABC::Addressee &addressee);
+static QStringList leadSearchTexts(const SugarLead &lead);
 
 using namespace Akonadi;
 
+// Models with at least this many rows are filtered asynchronously
+static const int s_asyncFilterThreshold = 10000;
+
+// Rows evaluated per task; a multiple of 64 so that no two tasks write to the same bitmap word
+static const int s_filterChunkRows = 64 * 32;
+
+namespace {
+
+struct FilterJob
+{
+    QScopedPointer<FilterPredicate> predicate;
+    QVector<int> chunks; // first row of each task
+    QVector<quint64> bitmap; // one bit per source row of the snapshot
+    quint64 *words;
+    qint64 traceStart;
+};
+
+class ChunkEvaluator
+{
+public:
+    typedef void result_type;
+
+    explicit ChunkEvaluator(const QSharedPointer<FilterJob> &job)
+        : mJob(job)
+    {}
+
+    void operator()(int &start) const
+    {
+        const FilterPredicate *predicate = mJob->predicate.data();
+        const int end = qMin(start + s_filterChunkRows, predicate->mItemIds.count());
+        for (int row = start; row < end; ++row) {
+            if (predicate->acceptsRow(row)) {
+                mJob->words[row >> 6] |= Q_UINT64_C(1) << (row & 63);
+            }
+        }
+    }
+
+private:
+    QSharedPointer<FilterJob> mJob; // keeps the job alive until all tasks are done, even when cancelled
+};
+
+}
+
 class FilterProxyModel::Private
 {
 public:
     Private(DetailsType type)
-        : mType(type)
+        : mType(type),
+          mAsyncFilterThreshold(s_asyncFilterThreshold)
     {}
+
+    void cancelFilterJob()
+    {
+        if (mRunningJob) {
+            mFilterWatcher.cancel();
+            mRunningJob.clear();
+        }
+        mResult.clear();
+        mChangedDuringJob.clear();
+    }
+
+    // Returns 1 or 0 if the evaluated bitmap is valid for this row, -1 if it has to be evaluated directly
+    int acceptedByResult(int row, Item::Id id) const
+    {
+        if (!mResult || row >= mResult->predicate->mItemIds.count() || mResult->predicate->mItemIds.at(row) != id)
+            return -1;
+        return (mResult->bitmap.at(row >> 6) >> (row & 63)) & 1;
+    }
+
     DetailsType mType;
+    int mAsyncFilterThreshold;
     QString mFilter;
+    QString mFoldedFilter;
+    SearchIndex mIndex;
+    QVector<Item::Id> mRowIds; // the item of each top-level source row, kept up to date as the source changes
+    QSet<Item::Id> mMatches; // items containing mFilter, kept up to date as the source changes
+
+    // The results of the shorter filters that the current one was typed from,
+    // so that deleting characters doesn't require a new search
+    struct CachedResult {
+        QString foldedFilter;
+        QSet<Item::Id> matches;
+    };
+    QVector<CachedResult> mHistory;
+
+    QSet<Item::Id> refine(const QSet<Item::Id> &candidates, const QString &foldedFilter) const
+    {
+        QSet<Item::Id> matches;
+        foreach (Item::Id id, candidates) {
+            if (mIndex.matches(id, foldedFilter))
+                matches.insert(id);
+        }
+        return matches;
+    }
+
+    void updateMatch(QSet<Item::Id> &matches, Item::Id id, const QString &foldedFilter) const
+    {
+        if (mIndex.matches(id, foldedFilter)) {
+            matches.insert(id);
+        } else {
+            matches.remove(id);
+        }
+    }
+
+    QFutureWatcher<void> mFilterWatcher;
+    QSharedPointer<FilterJob> mRunningJob;
+    QSharedPointer<FilterJob> mResult; // the last applied asynchronous evaluation
+    QSet<Item::Id> mChangedDuringJob; // items whose snapshot in mRunningJob is outdated
 };
 
+// Typing more than this many characters drops the oldest cached results
+static const int s_maxHistory = 32;
+
 FilterProxyModel::FilterProxyModel(DetailsType type, QObject *parent)
     : QSortFilterProxyModel(parent), d(new Private(type))
 {
     // account names should be sorted correctly
     setSortLocaleAware(true);
     setDynamicSortFilter(true); // for sorting during insertion, too
+
+    connect(&d->mFilterWatcher, SIGNAL(finished()), this, SLOT(slotFilterJobDone()));
 }
 
 FilterProxyModel::~FilterProxyModel()
 {
+    d->mFilterWatcher.cancel();
+    d->mFilterWatcher.waitForFinished();
     delete d;
 }
 
+void FilterProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (sourceModel()) {
+        disconnect(sourceModel(), SIGNAL(rowsInserted(QModelIndex,int,int)),
+                   this, SLOT(slotSourceRowsInserted(QModelIndex,int,int)));
+        disconnect(sourceModel(), SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                   this, SLOT(slotSourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+        disconnect(sourceModel(), SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                   this, SLOT(slotSourceRowsRemoved(QModelIndex,int,int)));
+        disconnect(sourceModel(), SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                   this, SLOT(slotSourceDataChanged(QModelIndex,QModelIndex)));
+        disconnect(sourceModel(), SIGNAL(modelReset()),
+                   this, SLOT(slotSourceModelReset()));
+        disconnect(sourceModel(), SIGNAL(layoutChanged()),
+                   this, SLOT(slotSourceLayoutChanged()));
+        disconnect(sourceModel(), SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+                   this, SLOT(slotSourceLayoutChanged()));
+    }
+    // Connected before QSortFilterProxyModel's own connections, so that the
+    // index is up to date when filterAcceptsRow() is called for the changed rows
+    if (model) {
+        connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                this, SLOT(slotSourceRowsInserted(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                this, SLOT(slotSourceRowsAboutToBeRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                this, SLOT(slotSourceRowsRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                this, SLOT(slotSourceDataChanged(QModelIndex,QModelIndex)));
+        connect(model, SIGNAL(modelReset()),
+                this, SLOT(slotSourceModelReset()));
+        connect(model, SIGNAL(layoutChanged()),
+                this, SLOT(slotSourceLayoutChanged()));
+        connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+                this, SLOT(slotSourceLayoutChanged()));
+    }
+    d->cancelFilterJob();
+    QSortFilterProxyModel::setSourceModel(model);
+    rebuildIndex();
+    if (!d->mFoldedFilter.isEmpty()) {
+        d->mMatches = d->mIndex.search(d->mFilter);
+        invalidateFilter();
+    }
+}
+
 QString FilterProxyModel::filterString() const
 {
     return d->mFilter;
@@ -82,138 +238,345 @@ QString FilterProxyModel::filterDescription() const
 
 void FilterProxyModel::setFilterString(const QString &filter)
 {
+    const QString folded = SearchIndex::fold(filter);
     d->mFilter = filter;
-    invalidateFilter();
+    if (folded == d->mFoldedFilter) {
+        return; // same matches
+    }
+
+    if (folded.isEmpty()) {
+        d->mHistory.clear();
+        d->mMatches.clear();
+    } else if (!d->mFoldedFilter.isEmpty() && folded.contains(d->mFoldedFilter)) {
+        // The filter was extended: only the currently accepted rows can still match
+        if (d->mHistory.count() == s_maxHistory) {
+            d->mHistory.remove(0);
+        }
+        const Private::CachedResult previous = { d->mFoldedFilter, d->mMatches };
+        d->mHistory.append(previous);
+        d->mMatches = d->refine(d->mMatches, folded);
+    } else {
+        // Characters were deleted (or the filter replaced): go back to the closest
+        // previous result that is still a superset of the new one
+        while (!d->mHistory.isEmpty() && !folded.contains(d->mHistory.last().foldedFilter)) {
+            d->mHistory.pop_back();
+        }
+        if (d->mHistory.isEmpty()) {
+            d->mMatches = d->mIndex.search(filter);
+        } else if (d->mHistory.last().foldedFilter == folded) {
+            d->mMatches = d->mHistory.last().matches;
+            d->mHistory.pop_back();
+        } else {
+            d->mMatches = d->refine(d->mHistory.last().matches, folded);
+        }
+    }
+    d->mFoldedFilter = folded;
+    refilter();
 }
 
-bool FilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+void FilterProxyModel::refilter()
 {
-    if (d->mFilter.isEmpty()) {
-        return true;
-    }
-    const QModelIndex index = sourceModel()->index(row, 0, parent);
-    const Akonadi::Item item =
-        index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+    // Outdated now: until the new evaluation is done, rows are evaluated directly
+    d->cancelFilterJob();
 
-    switch (d->mType) {
-    case Account: {
-        Q_ASSERT(item.hasPayload<SugarAccount>());
-        const SugarAccount account = item.payload<SugarAccount>();
-        return accountMatchesFilter(account, d->mFilter);
-    }
-    case Campaign: {
-        Q_ASSERT(item.hasPayload<SugarCampaign>());
-        const SugarCampaign campaign = item.payload<SugarCampaign>();
-        return campaignMatchesFilter(campaign, d->mFilter);
-    }
-    case Contact: {
-        Q_ASSERT(item.hasPayload<KABC::Addressee>());
-        const KABC::Addressee contact = item.payload<KABC::Addressee>();
-        return contactMatchesFilter(contact, d->mFilter);
+    const int rows = sourceModel() ? sourceModel()->rowCount() : 0;
+    if (rows < d->mAsyncFilterThreshold) {
+        TraceScope trace("FilterProxyModel::invalidateFilter", "filter");
+        invalidateFilter();
+        return;
     }
-    case Lead: {
-        Q_ASSERT(item.hasPayload<SugarLead>());
-        const SugarLead lead = item.payload<SugarLead>();
-        return leadMatchesFilter(lead, d->mFilter);
-    }
-    case Opportunity: // notreached, handled by subclass
-        return false;
+
+    QSharedPointer<FilterJob> job(new FilterJob);
+    job->traceStart = Tracer::timestamp();
+    job->predicate.reset(createPredicate());
+    const int snapshotRows = job->predicate->mItemIds.count();
+    job->bitmap.fill(0, (snapshotRows + 63) / 64);
+    job->words = job->bitmap.data();
+    for (int start = 0; start < snapshotRows; start += s_filterChunkRows) {
+        job->chunks.append(start);
     }
-    return true;
+    d->mRunningJob = job;
+    d->mFilterWatcher.setFuture(QtConcurrent::map(job->chunks, ChunkEvaluator(job)));
 }
 
-static bool accountMatchesFilter(const SugarAccount &account, const QString &filter)
+void FilterProxyModel::setAsyncFilterThreshold(int rows)
 {
-    if (account.name().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (account.billingAddressCity().contains(filter, Qt::CaseInsensitive) ||
-            account.shippingAddressCity().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    d->mAsyncFilterThreshold = rows;
+}
+
+void FilterProxyModel::waitForFilter()
+{
+    d->mFilterWatcher.waitForFinished();
+    // deliver the finished() signal of the watcher, which applies the result
+    QCoreApplication::sendPostedEvents(&d->mFilterWatcher, 0);
+}
+
+void FilterProxyModel::slotFilterJobDone()
+{
+    if (!d->mRunningJob || d->mFilterWatcher.isCanceled()) {
+        return;
     }
-    if (account.email1().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    QSharedPointer<FilterJob> job = d->mRunningJob;
+    d->mRunningJob.clear();
+    if (!d->mChangedDuringJob.isEmpty()) {
+        // these rows are evaluated directly instead
+        QVector<qint64> &ids = job->predicate->mItemIds;
+        for (int row = 0; row < ids.count(); ++row) {
+            if (d->mChangedDuringJob.contains(ids.at(row))) {
+                ids[row] = -1;
+            }
+        }
+        d->mChangedDuringJob.clear();
     }
-    if (account.billingAddressCountry().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    d->mResult = job;
+    {
+        TraceScope trace("FilterProxyModel::applyFilterResult", "filter");
+        invalidateFilter(); // the accepted rows are inserted in sorted position, no need to sort again
     }
-    if (account.phoneOffice().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    // from the start of the evaluation in the thread pool
+    Tracer::instance()->addEvent("FilterProxyModel::refilter", "filter", job->traceStart);
+}
+
+FilterPredicate *FilterProxyModel::createPredicate() const
+{
+    FilterPredicate *predicate = new FilterPredicate;
+    initPredicate(predicate);
+    return predicate;
+}
+
+void FilterProxyModel::initPredicate(FilterPredicate *predicate) const
+{
+    predicate->mItemIds = d->mRowIds; // shared, copied only once modified
+    predicate->mTextFilterEmpty = d->mFoldedFilter.isEmpty();
+    predicate->mTextMatches = d->mMatches;
+}
+
+bool FilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+{
+    if (d->mResult && !parent.isValid()) {
+        const int accepted = d->acceptedByResult(row, d->mRowIds.at(row));
+        if (accepted >= 0) {
+            return accepted;
+        }
     }
+    // rows inserted or changed after the snapshot was taken
+    return evaluateRow(row, parent);
+}
 
-    return false;
+void FilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+    TraceScope trace("FilterProxyModel::sort", "sort");
+    QSortFilterProxyModel::sort(column, order);
 }
 
-static bool campaignMatchesFilter(const SugarCampaign &campaign, const QString &filter)
+bool FilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
-    if (campaign.name().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    const QByteArray leftKey = left.data(ItemsTreeModel::SortKeyRole).toByteArray();
+    const QByteArray rightKey = right.data(ItemsTreeModel::SortKeyRole).toByteArray();
+    if (!leftKey.isNull() && !rightKey.isNull()) {
+        return DisplayCache::compareSortKeys(leftKey, rightKey) < 0;
     }
-    if (campaign.status().contains(filter, Qt::CaseInsensitive)) {
+    return QSortFilterProxyModel::lessThan(left, right);
+}
+
+bool FilterProxyModel::evaluateRow(int row, const QModelIndex &parent) const
+{
+    return matchesFilterString(row, parent);
+}
+
+bool FilterProxyModel::matchesFilterString(int row, const QModelIndex &parent) const
+{
+    if (d->mFoldedFilter.isEmpty()) {
         return true;
     }
-    if (campaign.campaignType().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    return d->mMatches.contains(sourceItemId(row, parent));
+}
+
+qint64 FilterProxyModel::sourceItemId(int row, const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return d->mRowIds.at(row);
     }
-    if (campaign.endDate().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    return sourceModel()->index(row, 0, parent).data(EntityTreeModel::ItemIdRole).toLongLong();
+}
+
+QStringList FilterProxyModel::searchTexts(const Akonadi::Item &item) const
+{
+    switch (d->mType) {
+    case Account:
+        if (item.hasPayload<SugarAccount>())
+            return accountSearchTexts(item.payload<SugarAccount>());
+        break;
+    case Campaign:
+        if (item.hasPayload<SugarCampaign>())
+            return campaignSearchTexts(item.payload<SugarCampaign>());
+        break;
+    case Contact:
+        if (item.hasPayload<KABC::Addressee>())
+            return contactSearchTexts(item.payload<KABC::Addressee>());
+        break;
+    case Lead:
+        if (item.hasPayload<SugarLead>())
+            return leadSearchTexts(item.payload<SugarLead>());
+        break;
+    default: // Opportunity is handled by the subclass
+        break;
     }
-    if (campaign.assignedUserName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    return QStringList();
+}
+
+void FilterProxyModel::indexRows(const QModelIndex &parent, int start, int end)
+{
+    for (int row = start; row <= end; ++row) {
+        const QModelIndex index = sourceModel()->index(row, 0, parent);
+        const Item item = index.data(EntityTreeModel::ItemRole).value<Item>();
+        if (!parent.isValid()) {
+            d->mRowIds[row] = item.id(); // -1 if not an item
+        }
+        if (!item.isValid()) {
+            continue;
+        }
+        d->mIndex.insert(item.id(), searchTexts(item));
+        sourceItemChanged(item);
+        if (!d->mFoldedFilter.isEmpty()) {
+            d->updateMatch(d->mMatches, item.id(), d->mFoldedFilter);
+            for (int i = 0; i < d->mHistory.count(); ++i) {
+                d->updateMatch(d->mHistory[i].matches, item.id(), d->mHistory.at(i).foldedFilter);
+            }
+        }
     }
+}
 
-    return false;
+void FilterProxyModel::sourceItemChanged(const Akonadi::Item &item)
+{
+    Q_UNUSED(item);
 }
 
-static bool contactMatchesFilter(const KABC::Addressee& contact, const QString &filter)
+void FilterProxyModel::sourceItemRemoved(qint64 id)
 {
-    if (contact.assembledName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    Q_UNUSED(id);
+}
+
+void FilterProxyModel::sourceItemsCleared()
+{
+}
+
+void FilterProxyModel::rebuildIndex()
+{
+    sourceItemsCleared();
+    d->mIndex.clear();
+    d->mMatches.clear();
+    d->mHistory.clear();
+    const int rows = sourceModel() ? sourceModel()->rowCount() : 0;
+    d->mRowIds.fill(-1, rows);
+    if (rows > 0) {
+        indexRows(QModelIndex(), 0, rows - 1);
     }
-    if (contact.organization().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+}
+
+void FilterProxyModel::slotSourceRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    if (!parent.isValid()) {
+        d->mRowIds.insert(start, end - start + 1, -1);
     }
-    if (contact.preferredEmail().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+    indexRows(parent, start, end);
+}
+
+void FilterProxyModel::slotSourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+    for (int row = start; row <= end; ++row) {
+        const Item::Id id = sourceItemId(row, parent);
+        d->mIndex.remove(id);
+        sourceItemRemoved(id);
+        d->mMatches.remove(id);
+        for (int i = 0; i < d->mHistory.count(); ++i) {
+            d->mHistory[i].matches.remove(id);
+        }
     }
-    if (contact.phoneNumber(KABC::PhoneNumber::Work).number().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+}
+
+void FilterProxyModel::slotSourceRowsRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (!parent.isValid()) {
+        d->mRowIds.remove(start, end - start + 1);
     }
-    if (contact.phoneNumber(KABC::PhoneNumber::Cell).number().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+}
+
+void FilterProxyModel::slotSourceLayoutChanged()
+{
+    // the rows moved, the items are the same
+    const int rows = sourceModel()->rowCount();
+    d->mRowIds.resize(rows);
+    for (int row = 0; row < rows; ++row) {
+        d->mRowIds[row] = sourceModel()->index(row, 0).data(EntityTreeModel::ItemIdRole).toLongLong();
     }
-    if (contact.givenName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
+}
+
+void FilterProxyModel::slotSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    indexRows(topLeft.parent(), topLeft.row(), bottomRight.row());
+
+    // The asynchronous results for these rows are outdated
+    if (d->mResult || d->mRunningJob) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+            const Item::Id id = sourceItemId(row, topLeft.parent());
+            if (d->mRunningJob) {
+                d->mChangedDuringJob.insert(id);
+            }
+            if (d->mResult && d->acceptedByResult(row, id) >= 0) {
+                d->mResult->predicate->mItemIds[row] = -1;
+            }
+        }
     }
-    if (ItemsTreeModel::countryForContact(contact).contains(filter, Qt::CaseInsensitive)) {
-        return true;
+}
+
+void FilterProxyModel::slotSourceModelReset()
+{
+    d->cancelFilterJob();
+    rebuildIndex();
+    if (!d->mFoldedFilter.isEmpty()) {
+        d->mMatches = d->mIndex.search(d->mFilter);
     }
+}
 
-    return false;
+static QStringList accountSearchTexts(const SugarAccount &account)
+{
+    return QStringList() << account.name()
+                         << account.billingAddressCity()
+                         << account.shippingAddressCity()
+                         << account.email1()
+                         << account.billingAddressCountry()
+                         << account.phoneOffice();
 }
 
-static bool leadMatchesFilter(const SugarLead &lead, const QString &filter)
+static QStringList campaignSearchTexts(const SugarCampaign &campaign)
 {
-    if (lead.firstName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (lead.lastName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (lead.status().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (lead.accountName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (lead.email1().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (lead.assignedUserName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
+    return QStringList() << campaign.name()
+                         << campaign.status()
+                         << campaign.campaignType()
+                         << campaign.endDate()
+                         << campaign.assignedUserName();
+}
 
-    return false;
+static QStringList contactSearchTexts(const KABC::Addressee &contact)
+{
+    return QStringList() << contact.assembledName()
+                         << contact.organization()
+                         << contact.preferredEmail()
+                         << contact.phoneNumber(KABC::PhoneNumber::Work).number()
+                         << contact.phoneNumber(KABC::PhoneNumber::Cell).number()
+                         << contact.givenName()
+                         << ItemsTreeModel::countryForContact(contact);
+}
+
+static QStringList leadSearchTexts(const SugarLead &lead)
+{
+    return QStringList() << lead.firstName()
+                         << lead.lastName()
+                         << lead.status()
+                         << lead.accountName()
+                         << lead.email1()
+                         << lead.assignedUserName();
 }
 
 #include "filterproxymodel.moc"
@@ -24,8 +24,41 @@
 #define FILTERPROXYMODEL_H
 
 #include <QtGui/QSortFilterProxyModel>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
 #include "enums.h"
 
+namespace Akonadi { class Item; }
+
+/**
+ * An immutable snapshot of the data needed to filter the source rows.
+ *
+ * It is created on the GUI thread and evaluated by worker threads when
+ * FilterProxyModel filters asynchronously, so acceptsRow() must only use
+ * the snapshot.
+ */
+class FilterPredicate
+{
+public:
+    FilterPredicate() : mTextFilterEmpty(true) {}
+    virtual ~FilterPredicate() {}
+
+    /**
+     * Returns true if the source row @p row passes the filter. Called from worker threads.
+     */
+    virtual bool acceptsRow(int row) const { return matchesText(row); }
+
+    bool matchesText(int row) const
+    {
+        return mTextFilterEmpty || mTextMatches.contains(mItemIds.at(row));
+    }
+
+    QVector<qint64> mItemIds; // the item of each source row, when the snapshot was taken
+    QSet<qint64> mTextMatches;
+    bool mTextFilterEmpty;
+};
+
 /**
  * A proxy model for sugar tree models.
  *
@@ -34,6 +67,18 @@
  * Only items that contain this pattern as part of their data will be
  * listed.
  *
+ * The searchable texts of the items are kept in a SearchIndex, updated
+ * as the source model changes, so that filtering doesn't have to look
+ * at the payload of every row. When the filter string is extended, only
+ * the previously matching items are tested again; when it is shortened,
+ * the previous results are reused.
+ *
+ * For large models the filter is evaluated asynchronously: a FilterPredicate
+ * snapshot is evaluated in chunks on the global thread pool into a bitmap of
+ * accepted rows, which is then applied to the proxy in one layout change.
+ *
+ * Sorting compares the precomputed ItemsTreeModel::SortKeyRole keys when
+ * the source model provides them.
  */
 class FilterProxyModel : public QSortFilterProxyModel
 {
@@ -60,6 +105,19 @@ public:
      */
     virtual QString filterDescription() const;
 
+    void setSourceModel(QAbstractItemModel *sourceModel) Q_DECL_OVERRIDE;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) Q_DECL_OVERRIDE;
+
+    /**
+     * Sets the number of rows from which the filter is evaluated asynchronously. For unittests.
+     */
+    void setAsyncFilterThreshold(int rows);
+
+    /**
+     * Blocks until the asynchronous evaluation of the filter is applied. For unittests.
+     */
+    void waitForFilter();
+
 public Q_SLOTS:
     /**
      * Sets the filter that is used to filter for matching items
@@ -67,9 +125,63 @@ public Q_SLOTS:
     void setFilterString(const QString &filter);
 
 protected:
-    virtual bool filterAcceptsRow(int row, const QModelIndex &parent) const;
+    bool filterAcceptsRow(int row, const QModelIndex &parent) const Q_DECL_OVERRIDE;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const Q_DECL_OVERRIDE;
+
+    /**
+     * Applies a changed filter, asynchronously for large models
+     */
+    void refilter();
+
+    /**
+     * Evaluates the filter for one source row, on the GUI thread
+     */
+    virtual bool evaluateRow(int row, const QModelIndex &parent) const;
+
+    /**
+     * Returns a snapshot of the current filter, for asynchronous evaluation.
+     * Reimplementations should call initPredicate().
+     */
+    virtual FilterPredicate *createPredicate() const;
+    void initPredicate(FilterPredicate *predicate) const;
+
+    /**
+     * Called when an item of the source model was inserted or changed,
+     * before the proxy evaluates the filter for it. For keeping
+     * precomputed per-item data up to date.
+     */
+    virtual void sourceItemChanged(const Akonadi::Item &item);
+    virtual void sourceItemRemoved(qint64 id);
+    virtual void sourceItemsCleared();
+
+    /**
+     * Returns true if the source row contains the filter string
+     */
+    bool matchesFilterString(int row, const QModelIndex &parent) const;
+
+    /**
+     * Returns the id of the item in the source row, without querying the source model for top-level rows
+     */
+    qint64 sourceItemId(int row, const QModelIndex &parent) const;
+
+    /**
+     * Returns the texts of @p item that the filter string is searched in
+     */
+    virtual QStringList searchTexts(const Akonadi::Item &item) const;
+
+private Q_SLOTS:
+    void slotSourceRowsInserted(const QModelIndex &parent, int start, int end);
+    void slotSourceRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void slotSourceRowsRemoved(const QModelIndex &parent, int start, int end);
+    void slotSourceLayoutChanged();
+    void slotSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void slotSourceModelReset();
+    void slotFilterJobDone();
 
 private:
+    void indexRows(const QModelIndex &parent, int start, int end);
+    void rebuildIndex();
+
     class Private;
     Private *const d;
 };
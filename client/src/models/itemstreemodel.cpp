@@ -22,7 +22,9 @@
 
 #include "itemstreemodel.h"
 
+#include "displaycache.h"
 #include "referenceddata.h"
+#include "referenceindex.h"
 
 #include "kdcrmdata/sugaraccount.h"
 #include "kdcrmdata/sugarcampaign.h"
@@ -46,31 +48,81 @@ class ItemsTreeModel::Private
 public:
     Private()
         : mColumns(),
-          mIconSize(KIconLoader::global()->currentSize(KIconLoader::Small))
+          mIconSize(KIconLoader::global()->currentSize(KIconLoader::Small)),
+          mCacheUpToDate(false),
+          mAccountNameRefs(0),
+          mAccountCountryRefs(0)
     {
     }
 
     ItemsTreeModel::ColumnTypes mColumns;
     const int mIconSize;
+    DisplayCache mCache;
+    bool mCacheUpToDate; // set while emitting dataChanged for an already refreshed column
+    ReferenceIndex *mAccountNameRefs; // AccountRef id -> items
+    ReferenceIndex *mAccountCountryRefs; // AccountCountryRef id -> items
+    QHash<QString, Item::Id> mItemIds; // remote id -> item id
+    QHash<Item::Id, QString> mRemoteIds; // item id -> remote id
 };
 
+// Columns whose EditRole value (used for sorting) differs from the DisplayRole value
+static bool hasSeparateEditValue(ItemsTreeModel::ColumnType column)
+{
+    switch (column) {
+    case ItemsTreeModel::CreationDate:
+    case ItemsTreeModel::NextStepDate:
+    case ItemsTreeModel::LastModifiedDate:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Stores the values of columns [firstColumn, lastColumn] of one item,
+// extracting the payload only once for the whole row
+template <typename T>
+static void cacheRow(const ItemsTreeModel *model, QVariant (ItemsTreeModel::*data)(const T &, int, int) const,
+                     const T &payload, DisplayCache &cache, int slot, int firstColumn, int lastColumn)
+{
+    const ItemsTreeModel::ColumnTypes columns = model->columnTypes();
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+        const QVariant display = (model->*data)(payload, column, Qt::DisplayRole);
+        const QVariant edit = hasSeparateEditValue(columns.at(column)) ? (model->*data)(payload, column, Qt::EditRole) : QVariant();
+        cache.setValue(slot, column, display, edit);
+    }
+}
+
 ItemsTreeModel::ItemsTreeModel(DetailsType type, ChangeRecorder *monitor, QObject *parent)
     : EntityTreeModel(monitor, parent), d(new Private), mType(type)
 {
     d->mColumns = columnTypes(mType);
-
-    if (mType == Opportunity) {
+    d->mCache.setColumnCount(d->mColumns.count());
+    d->mAccountNameRefs = new ReferenceIndex(ReferencedData::instance(AccountRef), this);
+    d->mAccountCountryRefs = new ReferenceIndex(ReferencedData::instance(AccountCountryRef), this);
+
+    // Connected before any view or proxy, so the cache is filled before they query the new data
+    connect(this, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(slotRowsInserted(QModelIndex,int,int)));
+    connect(this, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            this, SLOT(slotRowsAboutToBeRemoved(QModelIndex,int,int)));
+    connect(this, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+            this, SLOT(slotDataChanged(QModelIndex,QModelIndex)));
+    connect(this, SIGNAL(modelReset()),
+            this, SLOT(slotModelReset()));
+
+    if (mType == Opportunity || mType == Contact) {
         // Update accountName and country columns once all accounts are loaded
         connect(ReferencedData::instance(AccountCountryRef), SIGNAL(initialLoadingDone()),
-                this, SLOT(oppCountryColumnChanged()));
+                this, SLOT(countryColumnChanged()));
         connect(ReferencedData::instance(AccountRef), SIGNAL(initialLoadingDone()),
-                this, SLOT(oppAccountNameColumnChanged()));
-
-        // and update it again later in case of single changes (by the user or when updating from server)
-        connect(ReferencedData::instance(AccountCountryRef), SIGNAL(dataChanged(int)),
-                this, SLOT(slotAccountCountryChanged(int)));
-        connect(ReferencedData::instance(AccountRef), SIGNAL(dataChanged(int)),
-                this, SLOT(slotAccountNameChanged(int)));
+                this, SLOT(accountNameColumnChanged()));
+
+        // and update the rows referring to an account again when it is changed (by the user or when
+        // updating from server), or added after them, or removed
+        connect(d->mAccountCountryRefs, SIGNAL(itemsChanged(QSet<qint64>)),
+                this, SLOT(slotAccountCountryChanged(QSet<qint64>)));
+        connect(d->mAccountNameRefs, SIGNAL(itemsChanged(QSet<qint64>)),
+                this, SLOT(slotAccountNameChanged(QSet<qint64>)));
     }
 }
 
@@ -92,23 +144,232 @@ ItemsTreeModel::ColumnTypes ItemsTreeModel::columnTypes() const
  */
 QVariant ItemsTreeModel::entityData(const Item &item, int column, int role) const
 {
+    if (role == Qt::DisplayRole || role == Qt::EditRole || role == SortKeyRole) {
+        const int slot = d->mCache.slot(item.id());
+        if (slot >= 0 && column >= 0 && column < d->mColumns.count()) {
+            if (role == SortKeyRole) {
+                return d->mCache.sortKey(slot, column);
+            }
+            return d->mCache.value(slot, column, role);
+        }
+        if (role == SortKeyRole) {
+            return DisplayCache::makeSortKey(itemData(item, column, Qt::EditRole));
+        }
+    }
+
     // avoid calling item.payload() for all other roles
     if (role == Qt::DisplayRole || role == Qt::EditRole || role == Qt::DecorationRole) {
+        return itemData(item, column, role);
+    }
+
+    return EntityTreeModel::entityData(item, column, role);
+}
+
+/**
+ * Computes the data of an item, without using the cache
+ */
+QVariant ItemsTreeModel::itemData(const Item &item, int column, int role) const
+{
+    if (mType == Account && item.hasPayload<SugarAccount>()) {
+        return accountData(item.payload<SugarAccount>(), column, role);
+    } else if (mType == Campaign && item.hasPayload<SugarCampaign>()) {
+        return campaignData(item.payload<SugarCampaign>(), column, role);
+    } else if (mType == Contact && item.hasPayload<KABC::Addressee>()) {
+        return contactData(item.payload<KABC::Addressee>(), column, role);
+    } else if (mType == Lead && item.hasPayload<SugarLead>()) {
+        return leadData(item.payload<SugarLead>(), column, role);
+    } else if (mType == Opportunity && item.hasPayload<SugarOpportunity>()) {
+        return opportunityData(item.payload<SugarOpportunity>(), column, role);
+    }
+
+    // Pass modeltest
+    if (role == Qt::DisplayRole) {
+        return item.remoteId();
+    }
+    return QVariant();
+}
+
+/**
+ * Fills the cached values of columns [firstColumn, lastColumn] for @p item
+ */
+void ItemsTreeModel::cacheItem(const Item &item, int firstColumn, int lastColumn)
+{
+    DisplayCache &cache = d->mCache;
+    if (mType == Account && item.hasPayload<SugarAccount>()) {
+        cacheRow(this, &ItemsTreeModel::accountData, item.payload<SugarAccount>(), cache, cache.insert(item.id()), firstColumn, lastColumn);
+    } else if (mType == Campaign && item.hasPayload<SugarCampaign>()) {
+        cacheRow(this, &ItemsTreeModel::campaignData, item.payload<SugarCampaign>(), cache, cache.insert(item.id()), firstColumn, lastColumn);
+    } else if (mType == Contact && item.hasPayload<KABC::Addressee>()) {
+        const KABC::Addressee addressee = item.payload<KABC::Addressee>();
+        cacheRow(this, &ItemsTreeModel::contactData, addressee, cache, cache.insert(item.id()), firstColumn, lastColumn);
+        // same keys as contactData() and countryForContact()
+        d->mAccountNameRefs->insert(item.id(), addressee.custom("FATCRM", "X-AccountId"));
+        d->mAccountCountryRefs->insert(item.id(), addressee.organization());
+    } else if (mType == Lead && item.hasPayload<SugarLead>()) {
+        cacheRow(this, &ItemsTreeModel::leadData, item.payload<SugarLead>(), cache, cache.insert(item.id()), firstColumn, lastColumn);
+    } else if (mType == Opportunity && item.hasPayload<SugarOpportunity>()) {
+        const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+        const int slot = cache.insert(item.id());
+        cacheRow(this, &ItemsTreeModel::opportunityData, opportunity, cache, slot, firstColumn, lastColumn);
+        d->mAccountNameRefs->insert(item.id(), opportunity.accountId());
+        d->mAccountCountryRefs->insert(item.id(), opportunity.accountId());
+
+        // Opportunities with the same next step date are sorted by last modification date
+        const int nextStepDateColumn = d->mColumns.indexOf(NextStepDate);
+        const int lastModifiedDateColumn = d->mColumns.indexOf(LastModifiedDate);
+        const QDate lastModifiedDate = cache.value(slot, lastModifiedDateColumn, Qt::EditRole).toDateTime().date();
+        cache.setSortKey(slot, nextStepDateColumn,
+                         DisplayCache::makeSortKey(cache.value(slot, nextStepDateColumn, Qt::EditRole)) + DisplayCache::makeSortKey(lastModifiedDate));
+    } else {
+        // no payload (yet), entityData() computes the fallback values
+        removeCachedItem(item.id());
+    }
+}
+
+void ItemsTreeModel::removeCachedItem(Item::Id id)
+{
+    d->mCache.remove(id);
+    d->mAccountNameRefs->remove(id);
+    d->mAccountCountryRefs->remove(id);
+}
+
+/**
+ * Returns the index of the item with the remote id (SugarCRM id) @p remoteId,
+ * without iterating over the rows
+ */
+QModelIndex ItemsTreeModel::indexForRemoteId(const QString &remoteId) const
+{
+    const QHash<QString, Item::Id>::const_iterator it = d->mItemIds.constFind(remoteId);
+    if (it == d->mItemIds.constEnd()) {
+        return QModelIndex();
+    }
+    const QModelIndexList indexes = modelIndexesForItem(this, Item(it.value()));
+    return indexes.isEmpty() ? QModelIndex() : indexes.first();
+}
+
+void ItemsTreeModel::updateRemoteId(const Item &item)
+{
+    QHash<Item::Id, QString>::iterator it = d->mRemoteIds.find(item.id());
+    if (it != d->mRemoteIds.end()) {
+        if (it.value() == item.remoteId())
+            return;
+        d->mItemIds.remove(it.value());
+        it.value() = item.remoteId();
+    } else {
+        d->mRemoteIds.insert(item.id(), item.remoteId());
+    }
+    // new items only get a remote id once created on the server
+    if (!item.remoteId().isEmpty()) {
+        d->mItemIds.insert(item.remoteId(), item.id());
+    }
+}
 
-        if (mType == Account) {
-            return accountData(item, column, role);
-        } else if (mType == Campaign) {
-            return campaignData(item, column, role);
-        } else if (mType == Contact) {
-            return contactData(item, column, role);
-        } else if (mType == Lead) {
-            return leadData(item, column, role);
-        } else if (mType == Opportunity) {
-            return opportunityData(item, column, role);
+void ItemsTreeModel::slotRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    const int lastColumn = d->mColumns.count() - 1;
+    for (int row = start; row <= end; ++row) {
+        const Item item = index(row, 0, parent).data(EntityTreeModel::ItemRole).value<Item>();
+        if (item.isValid()) {
+            cacheItem(item, 0, lastColumn);
+            updateRemoteId(item);
         }
     }
+}
 
-    return EntityTreeModel::entityData(item, column, role);
+void ItemsTreeModel::slotRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+    for (int row = start; row <= end; ++row) {
+        const Item item = index(row, 0, parent).data(EntityTreeModel::ItemRole).value<Item>();
+        if (item.isValid()) {
+            removeCachedItem(item.id());
+            const QString remoteId = d->mRemoteIds.take(item.id());
+            if (d->mItemIds.value(remoteId) == item.id()) {
+                d->mItemIds.remove(remoteId);
+            }
+        }
+    }
+}
+
+void ItemsTreeModel::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (d->mCacheUpToDate) {
+        return;
+    }
+    // EntityTreeModel only signals column 0 when an item changes, so refresh the whole row
+    const QModelIndex parent = topLeft.parent();
+    const int lastColumn = d->mColumns.count() - 1;
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Item item = index(row, 0, parent).data(EntityTreeModel::ItemRole).value<Item>();
+        if (item.isValid()) {
+            cacheItem(item, 0, lastColumn);
+            updateRemoteId(item);
+        }
+    }
+}
+
+void ItemsTreeModel::slotModelReset()
+{
+    d->mCache.clear();
+    d->mItemIds.clear();
+    d->mRemoteIds.clear();
+    d->mAccountNameRefs->clear();
+    d->mAccountCountryRefs->clear();
+}
+
+/**
+ * Recomputes one column for all cached items, then notifies the views
+ */
+void ItemsTreeModel::refreshColumn(int column)
+{
+    const int rows = rowCount();
+    if (column < 0 || rows == 0) {
+        return;
+    }
+    for (int row = 0; row < rows; ++row) {
+        const Item item = index(row, 0).data(EntityTreeModel::ItemRole).value<Item>();
+        if (d->mCache.contains(item.id())) {
+            cacheItem(item, column, column);
+        }
+    }
+    //kDebug() << "emitting dataChanged for column" << column;
+    d->mCacheUpToDate = true;
+    emit dataChanged(index(0, column), index(rows - 1, column));
+    d->mCacheUpToDate = false;
+}
+
+/**
+ * Recomputes one column for the items @p ids, then notifies the views
+ * with one dataChanged per range of contiguous rows
+ */
+void ItemsTreeModel::refreshItems(const QSet<Item::Id> &ids, int column)
+{
+    if (column < 0 || ids.isEmpty()) {
+        return;
+    }
+    QMap<QModelIndex, QList<int> > rowsByParent;
+    foreach (Item::Id id, ids) {
+        foreach (const QModelIndex &idx, modelIndexesForItem(this, Item(id))) {
+            const Item item = idx.data(EntityTreeModel::ItemRole).value<Item>();
+            if (d->mCache.contains(item.id())) {
+                cacheItem(item, column, column);
+            }
+            rowsByParent[idx.parent()].append(idx.row());
+        }
+    }
+
+    d->mCacheUpToDate = true;
+    for (QMap<QModelIndex, QList<int> >::iterator it = rowsByParent.begin(); it != rowsByParent.end(); ++it) {
+        QList<int> &rows = it.value();
+        qSort(rows);
+        int first = 0;
+        for (int i = 1; i <= rows.count(); ++i) {
+            if (i == rows.count() || rows.at(i) != rows.at(i - 1) + 1) {
+                emit dataChanged(index(rows.at(first), column, it.key()), index(rows.at(i - 1), column, it.key()));
+                first = i;
+            }
+        }
+    }
+    d->mCacheUpToDate = false;
 }
 
 /**
@@ -153,42 +414,24 @@ QString ItemsTreeModel::countryForContact(const KABC::Addressee &addressee)
     return country;
 }
 
-void ItemsTreeModel::slotAccountCountryChanged(int row)
+void ItemsTreeModel::slotAccountCountryChanged(const QSet<qint64> &ids)
 {
-    if (mType == Opportunity) {
-        Q_UNUSED(row);
-        //const QString accountId = ReferencedData::instance(AccountCountryRef)->data(row);
-        // We could iterate over all opps to find those which use that account.... but maybe this is just faster:
-        oppCountryColumnChanged();
-    }
+    refreshItems(ids, d->mColumns.indexOf(Country));
 }
 
-void ItemsTreeModel::slotAccountNameChanged(int row)
+void ItemsTreeModel::slotAccountNameChanged(const QSet<qint64> &ids)
 {
-    if (mType == Opportunity) {
-        Q_UNUSED(row); // same reasoning as in slotAccountCountryChanged(row)
-        oppAccountNameColumnChanged();
-    }
+    refreshItems(ids, d->mColumns.indexOf(mType == Contact ? Organization : OpportunityAccountName));
 }
 
-void ItemsTreeModel::oppCountryColumnChanged()
+void ItemsTreeModel::countryColumnChanged()
 {
-    const int column = d->mColumns.indexOf(Country);
-    const int rows = rowCount();
-    if (rows > 0) {
-        //kDebug() << "emitting dataChanged for column" << column;
-        emit dataChanged(index(0, column), index(rows - 1, column));
-    }
+    refreshColumn(d->mColumns.indexOf(Country));
 }
 
-void ItemsTreeModel::oppAccountNameColumnChanged()
+void ItemsTreeModel::accountNameColumnChanged()
 {
-    const int column = d->mColumns.indexOf(OpportunityAccountName);
-    const int rows = rowCount();
-    if (rows > 0) {
-        //kDebug() << "emitting dataChanged for column" << column;
-        emit dataChanged(index(0, column), index(rows- 1, column));
-    }
+    refreshColumn(d->mColumns.indexOf(mType == Contact ? Organization : OpportunityAccountName));
 }
 
 /**
@@ -224,18 +467,8 @@ QVariant ItemsTreeModel::entityHeaderData(int section, Qt::Orientation orientati
 /**
  * Return the data. SugarAccount type
  */
-QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::accountData(const SugarAccount &account, int column, int role) const
 {
-    if (!item.hasPayload<SugarAccount>()) {
-        // Pass modeltest
-        if (role == Qt::DisplayRole) {
-            return item.remoteId();
-        }
-
-        return QVariant();
-    }
-    const SugarAccount account = item.payload<SugarAccount>();
-
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
         switch (columnTypes().at(column)) {
         case Name:
@@ -260,20 +493,8 @@ QVariant ItemsTreeModel::accountData(const Item &item, int column, int role) con
 /**
  * Return the data. SugarCampaign type
  */
-QVariant ItemsTreeModel::campaignData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::campaignData(const SugarCampaign &campaign, int column, int role) const
 {
-    if (!item.hasPayload<SugarCampaign>()) {
-
-        // Pass modeltest
-        if (role == Qt::DisplayRole) {
-            return item.remoteId();
-        }
-
-        return QVariant();
-    }
-
-    const SugarCampaign campaign = item.payload<SugarCampaign>();
-
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
         switch (columnTypes().at(column)) {
         case CampaignName:
@@ -296,20 +517,8 @@ QVariant ItemsTreeModel::campaignData(const Item &item, int column, int role) co
 /**
  * Return the data. KABC::Addressee type - ref: Contacts
  */
-QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::contactData(const KABC::Addressee &addressee, int column, int role) const
 {
-    if (!item.hasPayload<KABC::Addressee>()) {
-
-        // Pass modeltest
-        if (role == Qt::DisplayRole) {
-            return item.remoteId();
-        }
-
-        return QVariant();
-    }
-
-    const KABC::Addressee addressee = item.payload<KABC::Addressee>();
-
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
         switch (columnTypes().at(column)) {
         case FullName:
@@ -346,20 +555,8 @@ QVariant ItemsTreeModel::contactData(const Item &item, int column, int role) con
 /**
  * Return the data. SugarLead type
  */
-QVariant ItemsTreeModel::leadData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::leadData(const SugarLead &lead, int column, int role) const
 {
-    if (!item.hasPayload<SugarLead>()) {
-
-        // Pass modeltest
-        if (role == Qt::DisplayRole) {
-            return item.remoteId();
-        }
-
-        return QVariant();
-    }
-
-    const SugarLead lead = item.payload<SugarLead>();
-
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
         switch (columnTypes().at(column)) {
         case LeadName:
@@ -382,20 +579,8 @@ QVariant ItemsTreeModel::leadData(const Item &item, int column, int role) const
 /**
  * Return the data. SugarOpportunity type
  */
-QVariant ItemsTreeModel::opportunityData(const Item &item, int column, int role) const
+QVariant ItemsTreeModel::opportunityData(const SugarOpportunity &opportunity, int column, int role) const
 {
-    if (!item.hasPayload<SugarOpportunity>()) {
-
-        // Pass modeltest
-        if (role == Qt::DisplayRole) {
-            return item.remoteId();
-        }
-
-        return QVariant();
-    }
-
-    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
-
     if ((role == Qt::DisplayRole) || (role == Qt::EditRole)) {
         switch (columnTypes().at(column)) {
         case OpportunityName:
@@ -407,7 +592,7 @@ QVariant ItemsTreeModel::opportunityData(const Item &item, int column, int role)
         case Amount:
             return QLocale().toCurrencyString(QLocale::c().toDouble(opportunity.amount()), opportunity.currencySymbol());
         case CreationDate: {
-            const QDateTime dt = KDCRMUtils::dateTimeFromString(opportunity.dateEntered());
+            const QDateTime dt = KDCRMUtils::dateTimeFromSecsSinceEpoch(opportunity.dateEnteredSecsSinceEpoch());
             if (role == Qt::DisplayRole)
                 return KDCRMUtils::formatDate(dt.date());
             return dt; // for sorting
@@ -490,7 +675,7 @@ ItemsTreeModel::ColumnTypes ItemsTreeModel::columnTypes(DetailsType type)
     return columns;
 }
 
-QString ItemsTreeModel::columnTitle(ItemsTreeModel::ColumnType col) const
+QString ItemsTreeModel::columnTitle(ItemsTreeModel::ColumnType col)
 {
     switch (col) {
     case Name:
@@ -579,8 +764,13 @@ ItemsTreeModel::ColumnType ItemsTreeModel::columnTypeFromName(const QString &nam
 
 ItemsTreeModel::ColumnTypes ItemsTreeModel::defaultVisibleColumns() const
 {
-    ItemsTreeModel::ColumnTypes columns = columnTypes();
-    switch (mType) {
+    return defaultVisibleColumns(mType);
+}
+
+ItemsTreeModel::ColumnTypes ItemsTreeModel::defaultVisibleColumns(DetailsType type)
+{
+    ItemsTreeModel::ColumnTypes columns = columnTypes(type);
+    switch (type) {
     case Account:
         break;
     case Contact:
@@ -27,12 +27,23 @@
 
 #include <Akonadi/EntityTreeModel>
 
+#include <QSet>
+
 namespace KABC { class Addressee; }
+class SugarAccount;
+class SugarCampaign;
+class SugarLead;
+class SugarOpportunity;
 
 /**
  * A model for sugar items.
  * This class provides a model for displaying the sugar items.
  *
+ * The DisplayRole and EditRole values of each item are computed once, when the
+ * item is inserted or changed, and kept in a DisplayCache; entityData() then
+ * only has to look them up.
+ * The items showing the name or country of an account are indexed by account id,
+ * so that renaming one account only updates the rows that refer to it.
  */
 class ItemsTreeModel : public Akonadi::EntityTreeModel
 {
@@ -78,6 +89,14 @@ public:
 
     Q_ENUMS(ColumnType)
 
+    /**
+     * Additional data roles.
+     */
+    enum Roles {
+        /// A QByteArray whose byte order (DisplayCache::compareSortKeys) is the sort order of the EditRole value
+        SortKeyRole = EntityTreeModel::UserRole
+    };
+
     /**
      * Describes a list of columns of the items tree model.
      */
@@ -101,6 +120,8 @@ public:
     static QString columnNameFromType(ColumnType col);
     static ColumnType columnTypeFromName(const QString &name);
     static ColumnTypes columnTypes(DetailsType type);
+    static ColumnTypes defaultVisibleColumns(DetailsType type);
+    static QString columnTitle(ColumnType col);
 
     QVariant entityData(const Akonadi::Item &item, int column, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
     QVariant entityData(const Akonadi::Collection &collection, int column, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
@@ -109,19 +130,30 @@ public:
 
     static QString countryForContact(const KABC::Addressee &addressee);
 
+    QModelIndex indexForRemoteId(const QString &remoteId) const;
+
 private Q_SLOTS:
-    void slotAccountCountryChanged(int row);
-    void slotAccountNameChanged(int row);
-    void oppCountryColumnChanged();
-    void oppAccountNameColumnChanged();
+    void slotAccountCountryChanged(const QSet<qint64> &ids);
+    void slotAccountNameChanged(const QSet<qint64> &ids);
+    void countryColumnChanged();
+    void accountNameColumnChanged();
+    void slotRowsInserted(const QModelIndex &parent, int start, int end);
+    void slotRowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+    void slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void slotModelReset();
 
 private:
-    QVariant accountData(const Akonadi::Item &item, int column, int role) const;
-    QVariant campaignData(const Akonadi::Item &item, int column, int role) const;
-    QVariant contactData(const Akonadi::Item &item, int column, int role) const;
-    QVariant leadData(const Akonadi::Item &item, int column, int role) const;
-    QVariant opportunityData(const Akonadi::Item &item, int column, int role) const;
-    QString columnTitle(ColumnType col) const;
+    QVariant itemData(const Akonadi::Item &item, int column, int role) const;
+    void cacheItem(const Akonadi::Item &item, int firstColumn, int lastColumn);
+    void removeCachedItem(Akonadi::Item::Id id);
+    void updateRemoteId(const Akonadi::Item &item);
+    void refreshColumn(int column);
+    void refreshItems(const QSet<Akonadi::Item::Id> &ids, int column);
+    QVariant accountData(const SugarAccount &account, int column, int role) const;
+    QVariant campaignData(const SugarCampaign &campaign, int column, int role) const;
+    QVariant contactData(const KABC::Addressee &addressee, int column, int role) const;
+    QVariant leadData(const SugarLead &lead, int column, int role) const;
+    QVariant opportunityData(const SugarOpportunity &opportunity, int column, int role) const;
 
 private:
     class Private;
@@ -22,32 +22,135 @@
 
 #include "opportunityfilterproxymodel.h"
 #include "clientsettings.h"
-#include "itemstreemodel.h"
 #include "opportunitiespage.h"
 #include "opportunityfiltersettings.h"
 #include "referenceddata.h"
 
+#include "kdcrmdata/kdcrmutils.h"
 #include "kdcrmdata/sugaropportunity.h"
 
 #include <Akonadi/EntityTreeModel>
 
 #include <QDate>
 
+#include <limits>
+
 using namespace Akonadi;
 
+namespace {
+
+// What the filter needs to know about an opportunity, precomputed when it is inserted or changed
+struct OpportunityRecord
+{
+    int assigneeId;
+    int countryId; // country of the account, case-folded
+    int nextCallDay; // julian day, 0 if not set
+    qint64 dateModified;
+    bool closed;
+};
+
+// OpportunityFilterSettings, compiled to what can be compared to an OpportunityRecord
+struct CompiledOpportunityFilter
+{
+    CompiledOpportunityFilter()
+        : filterAssignees(false), filterCountries(false), showOpen(true), showClosed(true),
+          maxDay(0), modifiedAfter(std::numeric_limits<qint64>::min()),
+          modifiedBefore(std::numeric_limits<qint64>::max())
+    {}
+
+    QSet<int> assigneeIds;
+    QSet<int> countryIds;
+    bool filterAssignees;
+    bool filterCountries;
+    bool showOpen;
+    bool showClosed;
+    int maxDay; // julian day, 0 if not set
+    qint64 modifiedAfter; // inclusive
+    qint64 modifiedBefore; // exclusive
+};
+
+}
+
+// Thread-safe, used by both the direct and the asynchronous evaluation
+static bool opportunityAccepted(const OpportunityRecord &record, const CompiledOpportunityFilter &filter)
+{
+    if (filter.filterAssignees && !filter.assigneeIds.contains(record.assigneeId))
+        return false;
+    if (filter.filterCountries && !filter.countryIds.contains(record.countryId))
+        return false;
+    if (record.closed ? !filter.showClosed : !filter.showOpen)
+        return false;
+    if (filter.maxDay != 0 && (record.nextCallDay == 0 || record.nextCallDay > filter.maxDay))
+        return false;
+    if (record.dateModified < filter.modifiedAfter || record.dateModified >= filter.modifiedBefore)
+        return false;
+    return true;
+}
+
 class OpportunityFilterProxyModel::Private
 {
 public:
     Private()
     {}
 
-    OpportunityFilterSettings settings;
+    // Returns a small integer identifying @p text
+    static int intern(QHash<QString, int> &ids, const QString &text)
+    {
+        QHash<QString, int>::const_iterator it = ids.constFind(text);
+        if (it != ids.constEnd())
+            return it.value();
+        const int id = ids.count();
+        ids.insert(text, id);
+        return id;
+    }
+
+    OpportunityRecord record(const SugarOpportunity &opportunity)
+    {
+        OpportunityRecord record;
+        record.assigneeId = intern(mAssigneeIds, opportunity.assignedUserName());
+        const QString country = ReferencedData::instance(AccountCountryRef)->referencedData(opportunity.accountId());
+        record.countryId = intern(mCountryIds, country.toCaseFolded());
+        const QDate nextCallDate = opportunity.nextCallDate();
+        record.nextCallDay = nextCallDate.isValid() ? nextCallDate.toJulianDay() : 0;
+        record.dateModified = opportunity.dateModifiedSecsSinceEpoch();
+        record.closed = opportunity.salesStage().contains("Closed");
+        return record;
+    }
 
+    void compile()
+    {
+        mFilter = CompiledOpportunityFilter();
+        const QStringList assignees = settings.assignees();
+        mFilter.filterAssignees = !assignees.isEmpty();
+        foreach (const QString &assignee, assignees) {
+            mFilter.assigneeIds.insert(intern(mAssigneeIds, assignee));
+        }
+        const QStringList countries = settings.countries();
+        mFilter.filterCountries = !countries.isEmpty();
+        foreach (const QString &country, countries) {
+            mFilter.countryIds.insert(intern(mCountryIds, country.toCaseFolded()));
+        }
+        mFilter.showOpen = settings.showOpen();
+        mFilter.showClosed = settings.showClosed();
+        if (settings.maxDate().isValid())
+            mFilter.maxDay = settings.maxDate().toJulianDay();
+        if (settings.modifiedAfter().isValid())
+            mFilter.modifiedAfter = KDCRMUtils::secsSinceEpochFromDate(settings.modifiedAfter());
+        if (settings.modifiedBefore().isValid())
+            mFilter.modifiedBefore = KDCRMUtils::secsSinceEpochFromDate(settings.modifiedBefore().addDays(1));
+    }
+
+    OpportunityFilterSettings settings;
+    CompiledOpportunityFilter mFilter;
+    QHash<Item::Id, OpportunityRecord> mRecords;
+    QHash<QString, int> mAssigneeIds;
+    QHash<QString, int> mCountryIds;
 };
 
 OpportunityFilterProxyModel::OpportunityFilterProxyModel(QObject *parent)
     : FilterProxyModel(Opportunity, parent), d(new Private())
 {
+    d->compile();
 }
 
 OpportunityFilterProxyModel::~OpportunityFilterProxyModel()
@@ -58,7 +161,8 @@ OpportunityFilterProxyModel::~OpportunityFilterProxyModel()
 void OpportunityFilterProxyModel::setFilter(const OpportunityFilterSettings &settings)
 {
     d->settings = settings;
-    invalidate();
+    d->compile();
+    refilter();
 }
 
 QString OpportunityFilterProxyModel::filterDescription() const
@@ -72,92 +176,86 @@ QString OpportunityFilterProxyModel::filterDescription() const
     return txt;
 }
 
-static bool opportunityMatchesFilter(const SugarOpportunity &opportunity, const QString &filter)
+QStringList OpportunityFilterProxyModel::searchTexts(const Akonadi::Item &item) const
 {
-    if (opportunity.name().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    const QString accountName = ReferencedData::instance(AccountRef)->referencedData(opportunity.accountId());
-    if (accountName.contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.salesStage().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.amount().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.dateClosed().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-    if (opportunity.assignedUserName().contains(filter, Qt::CaseInsensitive)) {
-        return true;
-    }
-
-    return false;
+    if (!item.hasPayload<SugarOpportunity>())
+        return QStringList();
+    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+    return QStringList() << opportunity.name()
+                         << ReferencedData::instance(AccountRef)->referencedData(opportunity.accountId())
+                         << opportunity.salesStage()
+                         << opportunity.amount()
+                         << opportunity.dateClosed()
+                         << opportunity.assignedUserName();
 }
 
-bool OpportunityFilterProxyModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+void OpportunityFilterProxyModel::sourceItemChanged(const Akonadi::Item &item)
 {
-    const QModelIndex index = sourceModel()->index(row, 0, parent);
-    const Akonadi::Item item =
-        index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+    if (item.hasPayload<SugarOpportunity>()) {
+        d->mRecords.insert(item.id(), d->record(item.payload<SugarOpportunity>()));
+    } else {
+        d->mRecords.remove(item.id());
+    }
+}
 
-    Q_ASSERT(item.hasPayload<SugarOpportunity>());
-    const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+void OpportunityFilterProxyModel::sourceItemRemoved(qint64 id)
+{
+    d->mRecords.remove(id);
+}
 
-    const QStringList assignees = d->settings.assignees();
-    if (!assignees.isEmpty() && !assignees.contains(opportunity.assignedUserName()))
-        return false;
+void OpportunityFilterProxyModel::sourceItemsCleared()
+{
+    d->mRecords.clear();
+}
 
-    const QStringList countries = d->settings.countries();
-    if (!countries.isEmpty()) {
-        const QString country = ReferencedData::instance(AccountCountryRef)->referencedData(opportunity.accountId());
-        if (!countries.contains(country, Qt::CaseInsensitive))
-            return false;
+class OpportunityFilterPredicate : public FilterPredicate
+{
+public:
+    bool acceptsRow(int row) const Q_DECL_OVERRIDE
+    {
+        return opportunityAccepted(mRecords.at(row), mFilter) && matchesText(row);
     }
 
-    const bool isClosed = opportunity.salesStage().contains("Closed");
-    if (!d->settings.showClosed() && isClosed)
-        return false;
-    if (!d->settings.showOpen() && !isClosed)
-        return false;
-    if (d->settings.maxDate().isValid() && (!opportunity.nextCallDate().isValid()
-                                 || opportunity.nextCallDate() > d->settings.maxDate()))
-        return false;
-    if (d->settings.modifiedAfter().isValid() && opportunity.dateModified().date() < d->settings.modifiedAfter())
-        return false;
-    if (d->settings.modifiedBefore().isValid() && opportunity.dateModified().date() > d->settings.modifiedBefore())
-        return false;
+    QVector<OpportunityRecord> mRecords;
+    CompiledOpportunityFilter mFilter;
+};
 
-    const QString filterStr = filterString();
-    if (filterStr.isEmpty()) {
-        return true;
+FilterPredicate *OpportunityFilterProxyModel::createPredicate() const
+{
+    OpportunityFilterPredicate *predicate = new OpportunityFilterPredicate;
+    initPredicate(predicate);
+    predicate->mFilter = d->mFilter;
+    const int rows = predicate->mItemIds.count();
+    predicate->mRecords.resize(rows);
+    for (int row = 0; row < rows; ++row) {
+        QHash<Item::Id, OpportunityRecord>::const_iterator it = d->mRecords.constFind(predicate->mItemIds.at(row));
+        if (it != d->mRecords.constEnd()) {
+            predicate->mRecords[row] = it.value();
+        } else {
+            predicate->mItemIds[row] = -1; // no payload yet, evaluated directly later
+        }
     }
-
-    return opportunityMatchesFilter(opportunity, filterStr);
+    return predicate;
 }
 
-bool OpportunityFilterProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+bool OpportunityFilterProxyModel::evaluateRow(int row, const QModelIndex &parent) const
 {
-    const ItemsTreeModel::ColumnTypes columns = ItemsTreeModel::columnTypes(Opportunity);
-    const int nextStepDateColumn = columns.indexOf(ItemsTreeModel::NextStepDate);
-    if (sortColumn() == nextStepDateColumn) {
-        QVariant l = (left.model() ? left.model()->data(left, sortRole()) : QVariant());
-        QVariant r = (right.model() ? right.model()->data(right, sortRole()) : QVariant());
-        if (l.userType() == QVariant::Date) {
-            QDate leftDt = l.toDate();
-            QDate rightDt = r.toDate();
-            if (leftDt == rightDt) {
-                // compare last modified dates
-                const int lastModifiedDateColumn = columns.indexOf(ItemsTreeModel::LastModifiedDate);
-                leftDt = left.sibling(left.row(), lastModifiedDateColumn).data(sortRole()).toDate();
-                rightDt = right.sibling(right.row(), lastModifiedDateColumn).data(sortRole()).toDate();
-            }
-            return leftDt < rightDt;
-        }
+    const Item::Id id = sourceItemId(row, parent);
+
+    QHash<Item::Id, OpportunityRecord>::const_iterator it = d->mRecords.constFind(id);
+    if (it == d->mRecords.constEnd()) {
+        const QModelIndex index = sourceModel()->index(row, 0, parent);
+        const Akonadi::Item item = index.data(EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        Q_ASSERT(item.hasPayload<SugarOpportunity>());
+        if (!item.hasPayload<SugarOpportunity>())
+            return false;
+        it = d->mRecords.insert(id, d->record(item.payload<SugarOpportunity>()));
     }
-    return FilterProxyModel::lessThan(left, right);
+
+    if (!opportunityAccepted(it.value(), d->mFilter))
+        return false;
+
+    return matchesFilterString(row, parent);
 }
 
 #include "opportunityfilterproxymodel.moc"
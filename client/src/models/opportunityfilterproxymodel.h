@@ -57,8 +57,12 @@ public:
     QString filterDescription() const;
 
 protected:
-    virtual bool filterAcceptsRow(int row, const QModelIndex &parent) const Q_DECL_OVERRIDE;
-    virtual bool lessThan(const QModelIndex &left, const QModelIndex &right) const Q_DECL_OVERRIDE;
+    bool evaluateRow(int row, const QModelIndex &parent) const Q_DECL_OVERRIDE;
+    FilterPredicate *createPredicate() const Q_DECL_OVERRIDE;
+    void sourceItemChanged(const Akonadi::Item &item) Q_DECL_OVERRIDE;
+    void sourceItemRemoved(qint64 id) Q_DECL_OVERRIDE;
+    void sourceItemsCleared() Q_DECL_OVERRIDE;
+    QStringList searchTexts(const Akonadi::Item &item) const Q_DECL_OVERRIDE;
 
 private:
     class Private;
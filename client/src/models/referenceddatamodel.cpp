@@ -24,8 +24,75 @@
 #include "referenceddata.h"
 
 #include <QComboBox>
+#include <QCompleter>
+#include <QLineEdit>
+#include <QListView>
+#include <QMap>
+#include <QPointer>
 #include <QSortFilterProxyModel>
 
+// Selects the item matching the text typed in an editable combo,
+// or restores the text of the current item if there is none
+class ComboCompletionHelper : public QObject
+{
+    Q_OBJECT
+public:
+    ComboCompletionHelper(QComboBox *combo, QCompleter *completer)
+        : QObject(combo), mCombo(combo), mCompleter(completer)
+    {
+        connect(completer, SIGNAL(activated(QModelIndex)), this, SLOT(slotActivated(QModelIndex)));
+        connect(combo->lineEdit(), SIGNAL(editingFinished()), this, SLOT(slotEditingFinished()));
+    }
+
+private Q_SLOTS:
+    void slotActivated(const QModelIndex &index)
+    {
+        const int row = comboRow(index);
+        if (row >= 0) {
+            mCombo->setCurrentIndex(row);
+        }
+    }
+
+    void slotEditingFinished()
+    {
+        const QString text = mCombo->lineEdit()->text();
+        if (text == mCombo->itemText(mCombo->currentIndex())) {
+            return;
+        }
+        int row = -1;
+        if (text.isEmpty()) {
+            row = 0; // the empty item at the top
+        } else {
+            mCompleter->setCompletionPrefix(text);
+            if (mCompleter->currentCompletion().compare(text, Qt::CaseInsensitive) == 0) {
+                row = comboRow(mCompleter->currentIndex());
+            }
+        }
+        if (row >= 0 && row != mCombo->currentIndex()) {
+            mCombo->setCurrentIndex(row);
+        } else {
+            mCombo->setEditText(mCombo->itemText(mCombo->currentIndex()));
+        }
+    }
+
+private:
+    // Maps an index of the completion model to a row of the combo
+    int comboRow(const QModelIndex &index) const
+    {
+        const QAbstractProxyModel *completionModel = qobject_cast<QAbstractProxyModel *>(mCompleter->completionModel());
+        if (!index.isValid() || !completionModel) {
+            return -1;
+        }
+        return completionModel->mapToSource(index).row();
+    }
+
+    QComboBox *mCombo;
+    QCompleter *mCompleter;
+};
+
+typedef QMap<ReferencedDataType, QPointer<QSortFilterProxyModel> > SortedModelMap;
+Q_GLOBAL_STATIC(SortedModelMap, s_sortedModels)
+
 class ReferencedDataModel::Private
 {
     ReferencedDataModel *const q;
@@ -87,8 +154,8 @@ void ReferencedDataModel::Private::slotInitialLoadingDone()
 void ReferencedDataModel::Private::slotCleared()
 {
     // do we need aboutToClear()?
-    q->beginRemoveRows(QModelIndex(), 0, q->rowCount() - 1);
-    q->endRemoveRows();
+    q->beginResetModel();
+    q->endResetModel();
 }
 
 ReferencedDataModel::ReferencedDataModel(ReferencedDataType type, QObject *parent)
@@ -109,16 +176,71 @@ ReferencedDataModel::~ReferencedDataModel()
     delete d;
 }
 
+QAbstractItemModel *ReferencedDataModel::sortedModel(ReferencedDataType type)
+{
+    QPointer<QSortFilterProxyModel> &proxy = (*s_sortedModels())[type];
+    if (!proxy) {
+        ReferencedData *data = ReferencedData::instance(type);
+        proxy = new QSortFilterProxyModel(data);
+        proxy->setDynamicSortFilter(true);
+        proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+        ReferencedDataModel *model = new ReferencedDataModel(type, proxy);
+        proxy->setSourceModel(model);
+        proxy->sort(0);
+    }
+    return proxy;
+}
+
 void ReferencedDataModel::setModelForCombo(QComboBox *combo, ReferencedDataType type)
 {
-    QSortFilterProxyModel *proxy = new QSortFilterProxyModel(combo);
-    proxy->setDynamicSortFilter(true);
-    proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
-    ReferencedDataModel *model = new ReferencedDataModel(type, combo);
-    proxy->setSourceModel(model);
-    proxy->sort(0);
+    QAbstractItemModel *proxy = sortedModel(type);
     combo->setModel(proxy);
-    combo->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+
+    // Only the visible rows of the popup are laid out
+    QListView *view = new QListView(combo);
+    view->setUniformItemSizes(true);
+    combo->setView(view);
+
+    if (type != AccountRef) {
+        combo->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+        return;
+    }
+
+    // Tens of thousands of accounts: AdjustToContents would measure every item
+    // whenever rows are inserted, and scrolling to one in the popup is tedious,
+    // so the account combo gets a fixed width and completes typed names
+    combo->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    combo->setMinimumContentsLength(25);
+
+    combo->setEditable(true);
+    combo->setInsertPolicy(QComboBox::NoInsert);
+    QCompleter *completer = new QCompleter(proxy, combo);
+    completer->setCompletionRole(Qt::DisplayRole); // the role the proxy sorts by
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel); // binary search
+    completer->setCompletionMode(QCompleter::PopupCompletion);
+    if (QListView *popup = qobject_cast<QListView *>(completer->popup())) {
+        popup->setUniformItemSizes(true);
+    }
+    combo->setCompleter(completer);
+    new ComboCompletionHelper(combo, completer);
+}
+
+int ReferencedDataModel::findId(QComboBox *combo, const QString &id)
+{
+    QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(combo->model());
+    ReferencedDataModel *model = proxy ? qobject_cast<ReferencedDataModel *>(proxy->sourceModel()) : 0;
+    if (!model) {
+        return combo->findData(id);
+    }
+    if (id.isEmpty()) {
+        return proxy->mapFromSource(model->index(0, 0)).row();
+    }
+    const int row = model->d->mData->indexOf(id);
+    if (row == -1) {
+        return -1;
+    }
+    return proxy->mapFromSource(model->index(row + 1, 0)).row(); // +1 for the empty item at the top
 }
 
 static QString elideText(const QString& text)
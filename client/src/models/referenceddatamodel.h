@@ -29,6 +29,10 @@
 class QComboBox;
 
 // List model for filling comboboxes referencing an account/campaign/user/etc.
+//
+// The combos share one sorted model per type, show a fixed width, and only
+// lay out the visible rows of their popup; typing in them completes by
+// prefix with a binary search in the sorted model.
 class ReferencedDataModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -39,6 +43,12 @@ public:
 
     static void setModelForCombo(QComboBox *combo, ReferencedDataType type);
 
+    // The sorted model shared by all combos showing @p type
+    static QAbstractItemModel *sortedModel(ReferencedDataType type);
+
+    // Like combo->findData(id), without iterating over all rows for combos set up by setModelForCombo
+    static int findId(QComboBox *combo, const QString &id);
+
     /* reimpl */ QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     /* reimpl */ int rowCount(const QModelIndex &index = QModelIndex()) const;
 
@@ -0,0 +1,97 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "referenceindex.h"
+
+#include "referenceddata.h"
+
+#include <QPair>
+#include <QStringList>
+
+ReferenceIndex::ReferenceIndex(ReferencedData *data, QObject *parent)
+    : QObject(parent),
+      mData(data)
+{
+    connect(data, SIGNAL(dataChanged(int)), this, SLOT(slotDataChanged(int)));
+    connect(data, SIGNAL(idsInserted(QStringList)), this, SLOT(slotIdsChanged(QStringList)));
+    connect(data, SIGNAL(idsRemoved(QStringList)), this, SLOT(slotIdsChanged(QStringList)));
+}
+
+void ReferenceIndex::insert(qint64 id, const QString &key)
+{
+    QHash<qint64, QString>::iterator it = mKeys.find(id);
+    if (it != mKeys.end()) {
+        if (it.value() == key)
+            return;
+        removeItem(it.value(), id);
+        it.value() = key;
+    } else {
+        mKeys.insert(id, key);
+    }
+    mItems[key].insert(id);
+}
+
+void ReferenceIndex::remove(qint64 id)
+{
+    QHash<qint64, QString>::iterator it = mKeys.find(id);
+    if (it != mKeys.end()) {
+        removeItem(it.value(), id);
+        mKeys.erase(it);
+    }
+}
+
+void ReferenceIndex::clear()
+{
+    mItems.clear();
+    mKeys.clear();
+}
+
+void ReferenceIndex::removeItem(const QString &key, qint64 id)
+{
+    QHash<QString, QSet<qint64> >::iterator it = mItems.find(key);
+    if (it != mItems.end()) {
+        it.value().remove(id);
+        if (it.value().isEmpty())
+            mItems.erase(it);
+    }
+}
+
+void ReferenceIndex::slotDataChanged(int row)
+{
+    const QSet<qint64> ids = items(mData->data(row).first);
+    if (!ids.isEmpty()) {
+        emit itemsChanged(ids);
+    }
+}
+
+void ReferenceIndex::slotIdsChanged(const QStringList &keys)
+{
+    QSet<qint64> ids;
+    foreach (const QString &key, keys) {
+        ids += items(key);
+    }
+    if (!ids.isEmpty()) {
+        emit itemsChanged(ids);
+    }
+}
+
+#include "referenceindex.moc"
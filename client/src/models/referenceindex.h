@@ -0,0 +1,73 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REFERENCEINDEX_H
+#define REFERENCEINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class ReferencedData;
+class QStringList;
+
+/**
+ * Maps the ids of the entries of a ReferencedData (e.g. accounts) to the
+ * items displaying their data (e.g. opportunities), and reports the items
+ * to refresh whenever an entry is changed, added or removed.
+ *
+ * Items may be inserted before the entry they refer to exists, they are
+ * reported once it is added.
+ */
+class ReferenceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ReferenceIndex(ReferencedData *data, QObject *parent = 0);
+
+    /**
+     * Records that the item @p id refers to the entry @p key, replacing its previous key.
+     */
+    void insert(qint64 id, const QString &key);
+    void remove(qint64 id);
+    void clear();
+
+    QSet<qint64> items(const QString &key) const { return mItems.value(key); }
+
+Q_SIGNALS:
+    void itemsChanged(const QSet<qint64> &ids);
+
+private Q_SLOTS:
+    void slotDataChanged(int row);
+    void slotIdsChanged(const QStringList &keys);
+
+private:
+    void removeItem(const QString &key, qint64 id);
+
+    ReferencedData *mData;
+    QHash<QString, QSet<qint64> > mItems;
+    QHash<qint64, QString> mKeys;
+};
+
+#endif
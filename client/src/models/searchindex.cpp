@@ -0,0 +1,253 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "searchindex.h"
+
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+// Separates the texts of an item in its haystack; never part of a filter typed in a line edit
+static const ushort s_separator = '\n';
+
+// Number of updates merged into the posting lists per lock, so that searches don't wait too long
+static const int s_mergeChunkSize = 1024;
+
+static inline quint64 trigramKey(ushort a, ushort b, ushort c)
+{
+    return (quint64(a) << 32) | (quint64(b) << 16) | quint64(c);
+}
+
+// Returns the sorted, unique trigrams of @p text, skipping those spanning two texts
+static QVector<quint64> trigramsOf(const QString &text)
+{
+    QVector<quint64> trigrams;
+    const int count = text.size() - 2;
+    if (count <= 0)
+        return trigrams;
+    trigrams.reserve(count);
+    const ushort *c = text.utf16();
+    for (int i = 0; i < count; ++i) {
+        if (c[i] == s_separator || c[i + 1] == s_separator || c[i + 2] == s_separator)
+            continue;
+        trigrams.append(trigramKey(c[i], c[i + 1], c[i + 2]));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// Runs in a worker thread
+static QVector<SearchIndex::IndexedItem> indexItems(SearchIndex::Postings *postings, const QVector<SearchIndex::Update> &updates)
+{
+    // The expensive part runs without holding the lock
+    QVector<QVector<quint64> > trigrams(updates.count());
+    for (int i = 0; i < updates.count(); ++i) {
+        if (!updates.at(i).removed)
+            trigrams[i] = trigramsOf(updates.at(i).haystack);
+    }
+
+    QVector<SearchIndex::IndexedItem> indexedItems;
+    indexedItems.reserve(updates.count());
+    for (int chunk = 0; chunk < updates.count(); chunk += s_mergeChunkSize) {
+        QMutexLocker locker(&postings->mutex);
+        const int end = qMin(chunk + s_mergeChunkSize, updates.count());
+        for (int i = chunk; i < end; ++i) {
+            const SearchIndex::Update &update = updates.at(i);
+            QHash<qint64, QVector<quint64> >::iterator it = postings->trigramsByItem.find(update.id);
+            if (it != postings->trigramsByItem.end()) {
+                foreach (quint64 trigram, it.value()) {
+                    QHash<quint64, QSet<qint64> >::iterator posting = postings->itemsByTrigram.find(trigram);
+                    if (posting != postings->itemsByTrigram.end()) {
+                        posting.value().remove(update.id);
+                        if (posting.value().isEmpty())
+                            postings->itemsByTrigram.erase(posting);
+                    }
+                }
+                postings->trigramsByItem.erase(it);
+            }
+            if (!update.removed) {
+                foreach (quint64 trigram, trigrams.at(i)) {
+                    postings->itemsByTrigram[trigram].insert(update.id);
+                }
+                postings->trigramsByItem.insert(update.id, trigrams.at(i));
+            }
+            indexedItems.append(SearchIndex::IndexedItem(update.id, update.generation));
+        }
+    }
+    return indexedItems;
+}
+
+SearchIndex::SearchIndex(QObject *parent)
+    : QObject(parent), mGeneration(0), mResultPending(false)
+{
+    connect(&mWatcher, SIGNAL(finished()), this, SLOT(slotIndexingDone()));
+}
+
+SearchIndex::~SearchIndex()
+{
+    mWatcher.waitForFinished();
+}
+
+QString SearchIndex::fold(const QString &text)
+{
+    return text.toCaseFolded();
+}
+
+void SearchIndex::insert(qint64 id, const QStringList &texts)
+{
+    Entry &entry = mEntries[id];
+    entry.haystack = fold(texts.join(QString(QChar(s_separator))));
+    entry.generation = ++mGeneration;
+    mPendingItems.insert(id);
+
+    const Update update = { id, entry.generation, entry.haystack, false };
+    mQueue.append(update);
+    scheduleIndexing();
+}
+
+void SearchIndex::remove(qint64 id)
+{
+    if (mEntries.remove(id) == 0)
+        return;
+    mPendingItems.remove(id);
+
+    const Update update = { id, ++mGeneration, QString(), true };
+    mQueue.append(update);
+    scheduleIndexing();
+}
+
+void SearchIndex::clear()
+{
+    mWatcher.waitForFinished();
+    mResultPending = false;
+    mEntries.clear();
+    mPendingItems.clear();
+    mQueue.clear();
+    QMutexLocker locker(&mPostings.mutex);
+    mPostings.itemsByTrigram.clear();
+    mPostings.trigramsByItem.clear();
+}
+
+int SearchIndex::count() const
+{
+    return mEntries.count();
+}
+
+bool SearchIndex::contains(qint64 id) const
+{
+    return mEntries.contains(id);
+}
+
+bool SearchIndex::matches(qint64 id, const QString &foldedFilter) const
+{
+    QHash<qint64, Entry>::const_iterator it = mEntries.constFind(id);
+    return it != mEntries.constEnd() && it.value().haystack.contains(foldedFilter);
+}
+
+QSet<qint64> SearchIndex::search(const QString &filter) const
+{
+    const QString folded = fold(filter);
+    QSet<qint64> result;
+    if (folded.size() < 3) {
+        // too short for trigrams, scan the haystacks
+        QHash<qint64, Entry>::const_iterator it = mEntries.constBegin();
+        for (; it != mEntries.constEnd(); ++it) {
+            if (it.value().haystack.contains(folded))
+                result.insert(it.key());
+        }
+        return result;
+    }
+
+    const QVector<quint64> trigrams = trigramsOf(folded);
+    QSet<qint64> candidates;
+    if (!trigrams.isEmpty()) {
+        QMutexLocker locker(&mPostings.mutex);
+        QVector<const QSet<qint64> *> postings;
+        postings.reserve(trigrams.count());
+        foreach (quint64 trigram, trigrams) {
+            QHash<quint64, QSet<qint64> >::const_iterator it = mPostings.itemsByTrigram.constFind(trigram);
+            if (it == mPostings.itemsByTrigram.constEnd()) {
+                postings.clear();
+                break;
+            }
+            postings.append(&it.value());
+        }
+        if (!postings.isEmpty()) {
+            // start from the shortest posting list
+            int shortest = 0;
+            for (int i = 1; i < postings.count(); ++i) {
+                if (postings.at(i)->count() < postings.at(shortest)->count())
+                    shortest = i;
+            }
+            foreach (qint64 id, *postings.at(shortest)) {
+                bool inAll = true;
+                for (int i = 0; i < postings.count() && inAll; ++i) {
+                    inAll = (i == shortest) || postings.at(i)->contains(id);
+                }
+                if (inAll)
+                    candidates.insert(id);
+            }
+        }
+    }
+    candidates += mPendingItems;
+
+    foreach (qint64 id, candidates) {
+        if (matches(id, folded))
+            result.insert(id);
+    }
+    return result;
+}
+
+void SearchIndex::waitForIndexing()
+{
+    while (mResultPending) {
+        mWatcher.waitForFinished();
+        slotIndexingDone();
+    }
+}
+
+void SearchIndex::scheduleIndexing()
+{
+    if (mResultPending || mQueue.isEmpty())
+        return;
+    QVector<Update> updates;
+    updates.swap(mQueue);
+    mResultPending = true;
+    mWatcher.setFuture(QtConcurrent::run(indexItems, &mPostings, updates));
+}
+
+void SearchIndex::slotIndexingDone()
+{
+    if (!mResultPending || !mWatcher.isFinished())
+        return;
+    mResultPending = false;
+    foreach (const IndexedItem &indexedItem, mWatcher.result()) {
+        QHash<qint64, Entry>::const_iterator it = mEntries.constFind(indexedItem.first);
+        // skip items that changed again meanwhile, they are still queued
+        if (it != mEntries.constEnd() && it.value().generation == indexedItem.second)
+            mPendingItems.remove(indexedItem.first);
+    }
+    scheduleIndexing();
+}
+
+#include "searchindex.moc"
@@ -0,0 +1,115 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include <QFutureWatcher>
+
+/**
+ * A substring search index over the searchable texts of a list of items.
+ *
+ * Each item gets a case-folded haystack (its texts joined by newlines), and
+ * a trigram posting list maps every three-character sequence to the items
+ * containing it. Searching intersects the posting lists of the trigrams of the
+ * filter and only verifies the remaining candidates against their haystack.
+ *
+ * Haystacks are updated synchronously, the posting lists are maintained by a
+ * background job. Items whose postings aren't up to date yet are always
+ * treated as candidates, so results are exact at any time.
+ */
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(QObject *parent = 0);
+    ~SearchIndex();
+
+    /**
+     * Inserts the item @p id, or updates its texts if it is already indexed.
+     */
+    void insert(qint64 id, const QStringList &texts);
+    void remove(qint64 id);
+    void clear();
+
+    int count() const;
+    bool contains(qint64 id) const;
+
+    /**
+     * Returns the ids of all items with a text containing @p filter, case-insensitively.
+     */
+    QSet<qint64> search(const QString &filter) const;
+
+    /**
+     * Returns true if the item @p id has a text containing @p foldedFilter,
+     * which must have been passed through fold().
+     */
+    bool matches(qint64 id, const QString &foldedFilter) const;
+
+    /**
+     * Blocks until the background indexing is done. For unittests.
+     */
+    void waitForIndexing();
+
+    static QString fold(const QString &text);
+
+    struct Update {
+        qint64 id;
+        uint generation;
+        QString haystack;
+        bool removed;
+    };
+    typedef QPair<qint64, uint> IndexedItem;
+
+    struct Postings {
+        QMutex mutex;
+        QHash<quint64, QSet<qint64> > itemsByTrigram;
+        QHash<qint64, QVector<quint64> > trigramsByItem;
+    };
+
+private Q_SLOTS:
+    void slotIndexingDone();
+
+private:
+    void scheduleIndexing();
+
+    struct Entry {
+        QString haystack;
+        uint generation;
+    };
+    QHash<qint64, Entry> mEntries;
+    QSet<qint64> mPendingItems; // inserted or changed, posting lists not updated yet
+    QVector<Update> mQueue;
+    uint mGeneration;
+    bool mResultPending; // a job was started and its result not processed yet
+    mutable Postings mPostings;
+    QFutureWatcher<QVector<IndexedItem> > mWatcher;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snapshotmodel.h"
+#include "clientsnapshot.h"
+#include "displaycache.h"
+#include "tracer.h"
+
+#include <QtAlgorithms>
+
+namespace {
+
+// Orders snapshot rows by the sort keys of a column, like FilterProxyModel::lessThan
+class SnapshotRowLessThan
+{
+public:
+    SnapshotRowLessThan(const ClientSnapshot *snapshot, DetailsType type, int column, Qt::SortOrder order)
+        : mSnapshot(snapshot), mType(type), mColumn(column), mOrder(order)
+    {
+    }
+
+    bool operator()(int left, int right) const
+    {
+        return mOrder == Qt::AscendingOrder ? lessThan(left, right) : lessThan(right, left);
+    }
+
+private:
+    bool lessThan(int left, int right) const
+    {
+        const QByteArray leftKey = mSnapshot->sortKey(mType, left, mColumn);
+        const QByteArray rightKey = mSnapshot->sortKey(mType, right, mColumn);
+        if (!leftKey.isNull() && !rightKey.isNull()) {
+            return DisplayCache::compareSortKeys(leftKey, rightKey) < 0;
+        }
+        return QString::localeAwareCompare(mSnapshot->text(mType, left, mColumn), mSnapshot->text(mType, right, mColumn)) < 0;
+    }
+
+    const ClientSnapshot *mSnapshot;
+    DetailsType mType;
+    int mColumn;
+    Qt::SortOrder mOrder;
+};
+
+}
+
+SnapshotModel::SnapshotModel(const QSharedPointer<ClientSnapshot> &snapshot, DetailsType type, QObject *parent)
+    : QAbstractTableModel(parent),
+      mSnapshot(snapshot),
+      mType(type),
+      mColumns(ItemsTreeModel::columnTypes(type))
+{
+    const int rows = mSnapshot->rowCount(mType);
+    mRows.reserve(rows);
+    for (int row = 0; row < rows; ++row) {
+        mRows.append(row);
+    }
+}
+
+SnapshotModel::~SnapshotModel()
+{
+}
+
+QString SnapshotModel::remoteId(int row) const
+{
+    if (row < 0 || row >= mRows.count()) {
+        return QString();
+    }
+    const QString id = mSnapshot->remoteId(mType, mRows.at(row));
+    return QString(id.constData(), id.size());
+}
+
+int SnapshotModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : mRows.count();
+}
+
+int SnapshotModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : mColumns.count();
+}
+
+QVariant SnapshotModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const int row = mRows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole: {
+        // the views keep the string around, don't let it point into the mapping
+        const QString text = mSnapshot->text(mType, row, index.column());
+        return QString(text.constData(), text.size());
+    }
+    case ItemsTreeModel::SortKeyRole: {
+        const QByteArray key = mSnapshot->sortKey(mType, row, index.column());
+        return key.isNull() ? QVariant() : QVariant(QByteArray(key.constData(), key.size()));
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SnapshotModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < mColumns.count()) {
+        return ItemsTreeModel::columnTitle(mColumns.at(section));
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+Qt::ItemFlags SnapshotModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void SnapshotModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= mColumns.count()) {
+        return;
+    }
+    TraceScope trace("SnapshotModel::sort", "sort");
+    emit layoutAboutToBeChanged();
+    const QVector<int> oldRows = mRows;
+    qStableSort(mRows.begin(), mRows.end(), SnapshotRowLessThan(mSnapshot.data(), mType, column, order));
+
+    // keep the current item and the selection on the same snapshot rows
+    QVector<int> newPositions(mRows.count());
+    for (int row = 0; row < mRows.count(); ++row) {
+        newPositions[mRows.at(row)] = row;
+    }
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    foreach (const QModelIndex &index, oldIndexes) {
+        newIndexes.append(this->index(newPositions.at(oldRows.at(index.row())), index.column()));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+    emit layoutChanged();
+}
+
+#include "snapshotmodel.moc"
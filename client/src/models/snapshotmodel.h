@@ -0,0 +1,64 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNAPSHOTMODEL_H
+#define SNAPSHOTMODEL_H
+
+#include "enums.h"
+#include "itemstreemodel.h"
+
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include <QVector>
+
+class ClientSnapshot;
+
+/**
+ * A read-only model showing the items of one type saved in a ClientSnapshot,
+ * with the same columns as the ItemsTreeModel. It is shown by the pages until
+ * the real model is loaded.
+ */
+class SnapshotModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    SnapshotModel(const QSharedPointer<ClientSnapshot> &snapshot, DetailsType type, QObject *parent = 0);
+
+    ~SnapshotModel();
+
+    QString remoteId(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) Q_DECL_OVERRIDE;
+
+private:
+    QSharedPointer<ClientSnapshot> mSnapshot;
+    DetailsType mType;
+    ItemsTreeModel::ColumnTypes mColumns;
+    QVector<int> mRows; // snapshot row of each model row
+};
+
+#endif
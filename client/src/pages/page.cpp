@@ -25,12 +25,15 @@
 #include "detailsdialog.h"
 #include "accountrepository.h"
 #include "clientsettings.h"
+#include "clientsnapshot.h"
 #include "detailswidget.h"
 #include "enums.h"
+#include "ingestionpipeline.h"
 #include "referenceddata.h"
 #include "reportgenerator.h"
-#include "sugarresourcesettings.h"
 #include "rearrangecolumnsproxymodel.h"
+#include "snapshotmodel.h"
+#include "tracer.h"
 
 #include "kdcrmdata/enumdefinitionattribute.h"
 #include "kdcrmdata/sugaraccount.h"
@@ -57,6 +60,7 @@
 
 #include <QMessageBox>
 #include <QShortcut>
+#include <QTimer>
 
 using namespace Akonadi;
 
@@ -68,8 +72,15 @@ Page::Page(QWidget *parent, const QString &mimeType, DetailsType type)
       mChangeRecorder(0),
       mItemsTreeModel(0),
       mShowDetailsAction(0),
+      mSearchTimer(0),
+      mNotesRepository(0),
       mFilterModel(0),
-      mInitialLoadingDone(false)
+      mSnapshotModel(0),
+      mDetailsDialogGeneration(0),
+      mIngestionPipeline(new IngestionPipeline(type, this)),
+      mInitialLoadingDone(false),
+      mModelLoadedPending(false),
+      mLoadStart(-1)
 {
     mUi.setupUi(this);
     mUi.splitter->setCollapsible(0, false);
@@ -90,16 +101,13 @@ QAction *Page::showDetailsAction(const QString &title) const
 
 void Page::openDialog(const QString &id)
 {
-    const int count = mItemsTreeModel->rowCount();
-    for (int i = 0; i < count; ++i) {
-        const QModelIndex index = mItemsTreeModel->index(i, 0);
+    const QModelIndex index = mItemsTreeModel->indexForRemoteId(id);
+    if (index.isValid()) {
         const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.remoteId() == id) {
-            DetailsDialog *dialog = createDetailsDialog();
-            dialog->setItem(item);
-            dialog->show();
-            // cppcheck-suppress memleak as dialog deletes itself
-        }
+        DetailsDialog *dialog = createDetailsDialog();
+        dialog->setItem(item);
+        dialog->show();
+        // cppcheck-suppress memleak as the page reuses or deletes the dialog once closed
     }
 }
 
@@ -129,7 +137,7 @@ void Page::setFilter(FilterProxyModel *filter)
     connect(mFilter, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(slotVisibleRowCountChanged()));
 
     connect(mUi.searchLE, SIGNAL(textChanged(QString)),
-            mFilter, SLOT(setFilterString(QString)));
+            this, SLOT(slotSearchTextChanged(QString)));
 }
 
 // Connected to signal resourceSelected() from the mainwindow
@@ -148,11 +156,17 @@ void Page::slotResourceSelectionChanged(const QByteArray &identifier)
     mUi.treeView->setModel(0);
     delete mItemsTreeModel;
     mItemsTreeModel = 0;
+    delete mSnapshotModel;
+    mSnapshotModel = 0;
+    mUi.searchLE->setEnabled(true);
+    mIngestionPipeline->clear();
+    clearDetailsDialogPool();
 
-    retrieveResourceUrl();
+    mDetailsWidget->details()->setResourceIdentifier(mResourceIdentifier);
     mUi.reloadPB->setEnabled(false);
 
     mInitialLoadingDone = false;
+    mModelLoadedPending = false;
 
     // now we wait for the collection manager to find our collection and tell us
 }
@@ -201,6 +215,23 @@ void Page::setModificationsIgnored(bool b)
 void Page::initialLoadingDone()
 {
     mDetailsWidget->initialLoadingDone();
+    // so that the first dialog opens quickly too
+    QTimer::singleShot(0, this, SLOT(slotPrebuildDetailsDialog()));
+}
+
+void Page::showSnapshot(const QSharedPointer<ClientSnapshot> &snapshot)
+{
+    const ItemsTreeModel::ColumnTypes columns = ItemsTreeModel::columnTypes(mType);
+    if (mInitialLoadingDone || mSnapshotModel ||
+            snapshot->rowCount(mType) == 0 || snapshot->columnCount(mType) != columns.count()) {
+        return;
+    }
+    // The snapshot is read-only, searching and the details need the real items
+    mSnapshotModel = new SnapshotModel(snapshot, mType, this);
+    mUi.treeView->setModels(mSnapshotModel, columns, ItemsTreeModel::defaultVisibleColumns(mType));
+    mUi.treeView->setCurrentIndex(mSnapshotModel->index(0, 0));
+    mUi.searchLE->setEnabled(false);
+    slotVisibleRowCountChanged();
 }
 
 void Page::slotCurrentItemChanged(const QModelIndex &index)
@@ -226,7 +257,25 @@ void Page::slotCurrentItemChanged(const QModelIndex &index)
 
         mCurrentIndex = mUi.treeView->selectionModel()->currentIndex();
         //kDebug() << "mCurrentIndex=" << mCurrentIndex;
+
+        if (mNotesRepository && mType == Opportunity) {
+            prefetchNotes(index);
+        }
+    }
+}
+
+// Fetches the notes of the current opportunity and of its neighbours, which the user is likely to look at next
+void Page::prefetchNotes(const QModelIndex &index)
+{
+    QStringList ids;
+    for (int row = index.row() - 2; row <= index.row() + 2; ++row) {
+        const QModelIndex neighbour = index.sibling(row, 0);
+        const Item item = neighbour.data(EntityTreeModel::ItemRole).value<Item>();
+        if (item.hasPayload<SugarOpportunity>()) {
+            ids.append(item.payload<SugarOpportunity>().id());
+        }
     }
+    mNotesRepository->prefetch(ids);
 }
 
 void Page::slotNewClicked()
@@ -247,7 +296,7 @@ void Page::slotNewClicked()
         item.setParentCollection(mCollection);
         dialog->showNewItem(data, mCollection);
         dialog->show();
-        // cppcheck-suppress memleak as dialog deletes itself
+        // cppcheck-suppress memleak as the page reuses or deletes the dialog once closed
     }
 }
 
@@ -355,76 +404,57 @@ void Page::slotRowsInserted(const QModelIndex &, int start, int end)
 {
     //kDebug() << typeToString(mType) << ": rows inserted from" << start << "to" << end;
 
-    // inserting rows into comboboxes can change the current index, thus marking the data as modified
-    emit ignoreModifications(true);
-
-    const bool emitChanges = mInitialLoadingDone;
-
-    switch (mType) {
-    case Account:
-        addAccountsData(start, end, emitChanges);
-        break;
-    case Campaign:
-        addCampaignsData(start, end, emitChanges);
-        break;
-    case Contact:
-        addContactsData(start, end, emitChanges);
-        break;
-    case Lead:
-        addLeadsData(start, end, emitChanges);
-        break;
-    case Opportunity:
-        addOpportunitiesData(start, end, emitChanges);
-        break;
-    default: // other objects (like Note) not shown in a Page
-        break;
-    }
+    // the referenced data is extracted in the background, and published in order
+    mIngestionPipeline->addItems(IngestionPipeline::Insert, itemsInRows(start, end), mInitialLoadingDone);
+
     // Select the first row; looks nicer than empty fields in the details widget.
     //kDebug() << "model has" << mItemsTreeModel->rowCount()
     //         << "rows, we expect" << mCollection.statistics().count();
     const bool done = !mInitialLoadingDone && mItemsTreeModel->rowCount() == mCollection.statistics().count();
     if (done) {
         //kDebug() << "Finished loading" << typeToString(mType);
+        if (mSnapshotModel) {
+            showModels();
+        }
         if (!mUi.treeView->currentIndex().isValid()) {
             mUi.treeView->setCurrentIndex(mUi.treeView->model()->index(0, 0));
         }
         mInitialLoadingDone = true;
-        // Move to the next model
-        //emit modelLoaded(mType, i18n("%1 %2 loaded", mItemsTreeModel->rowCount(), typeToString(mType)));
-        emit modelLoaded(mType);
+        // Move to the next model, once the referenced data of this one is published
+        mModelLoadedPending = true;
+        if (mIngestionPipeline->isIdle()) {
+            slotIngestionIdle();
+        }
+    }
+}
 
-        if (mType == Account) {
-            ReferencedData::instance(AccountCountryRef)->emitInitialLoadingDone();
+void Page::slotIngestionIdle()
+{
+    if (mModelLoadedPending) {
+        mModelLoadedPending = false;
+        if (mLoadStart != -1) {
+            Tracer::instance()->addEvent("Page::loadModel", "startup", mLoadStart, typeToString(mType));
+            mLoadStart = -1;
         }
+        //emit modelLoaded(mType, i18n("%1 %2 loaded", mItemsTreeModel->rowCount(), typeToString(mType)));
+        emit modelLoaded(mType);
     }
-    emit ignoreModifications(false);
 }
 
 void Page::slotRowsAboutToBeRemoved(const QModelIndex &, int start, int end)
 {
-    // inserting rows into comboboxes can change the current index, thus marking the data as modified
-    emit ignoreModifications(true);
-
-    switch (mType) {
-    case Account:
-        removeAccountsData(start, end, mInitialLoadingDone);
-        break;
-    case Campaign:
-        removeCampaignsData(start, end, mInitialLoadingDone);
-        break;
-    case Contact:
-        removeContactsData(start, end, mInitialLoadingDone);
-        break;
-    case Lead:
-        removeLeadsData(start, end, mInitialLoadingDone);
-        break;
-    case Opportunity:
-        removeOpportunitiesData(start, end, mInitialLoadingDone);
-        break;
-    default: // other objects (like Note) not shown in a Page
-        break;
-    }
-    emit ignoreModifications(false);
+    mIngestionPipeline->addItems(IngestionPipeline::Remove, itemsInRows(start, end), mInitialLoadingDone);
+}
+
+Akonadi::Item::List Page::itemsInRows(int start, int end) const
+{
+    Item::List items;
+    items.reserve(end - start + 1);
+    for (int row = start; row <= end; ++row) {
+        const QModelIndex index = mItemsTreeModel->index(row, 0);
+        items.append(mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>());
+    }
+    return items;
 }
 
 void Page::initialize()
@@ -447,6 +477,12 @@ void Page::initialize()
 
     connect(mUi.clearSearchPB, SIGNAL(clicked()),
             this, SLOT(slotResetSearch()));
+
+    // Don't filter on every keystroke while the user is still typing
+    mSearchTimer = new QTimer(this);
+    mSearchTimer->setSingleShot(true);
+    mSearchTimer->setInterval(150);
+    connect(mSearchTimer, SIGNAL(timeout()), this, SLOT(slotApplySearch()));
     connect(mUi.newPB, SIGNAL(clicked()),
             this, SLOT(slotNewClicked()));
     connect(mUi.removePB, SIGNAL(clicked()),
@@ -470,12 +506,17 @@ void Page::initialize()
     showDetails(ClientSettings::self()->showDetails(typeToString(mType)));
 
     connectToDetails(mDetailsWidget->details());
+
+    // inserting rows into comboboxes can change the current index, thus marking the data as modified
+    connect(mIngestionPipeline, SIGNAL(publishing(bool)), this, SIGNAL(ignoreModifications(bool)));
+    connect(mIngestionPipeline, SIGNAL(idle()), this, SLOT(slotIngestionIdle()));
 }
 
 void Page::setupModel()
 {
     Q_ASSERT(mFilter); // must be set by derived class ctor
 
+    mLoadStart = Tracer::timestamp();
     mItemsTreeModel = new ItemsTreeModel(mType, mChangeRecorder, this);
 
     connect(mItemsTreeModel, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(slotRowsInserted(QModelIndex,int,int)));
@@ -488,12 +529,37 @@ void Page::setupModel()
     mFilterModel->setHeaderGroup(EntityTreeModel::ItemListHeaders);
 
     mFilter->setSourceModel(mFilterModel);
-    mUi.treeView->setModels(mFilter, mItemsTreeModel, mItemsTreeModel->defaultVisibleColumns());
+    if (!mSnapshotModel) {
+        showModels();
+    } // else the snapshot stays visible until the model is loaded
+
+    emit modelCreated(mItemsTreeModel); // give it to the reports page
+}
+
+void Page::showModels()
+{
+    // stay on the item that was current in the snapshot
+    QString currentRemoteId;
+    if (mSnapshotModel) {
+        currentRemoteId = mSnapshotModel->remoteId(mUi.treeView->currentIndex().row());
+    }
+
+    mUi.treeView->setModels(mFilter, mItemsTreeModel->columnTypes(), mItemsTreeModel->defaultVisibleColumns());
 
     connect(mUi.treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)),
             this,  SLOT(slotCurrentItemChanged(QModelIndex)));
 
-    emit modelCreated(mItemsTreeModel); // give it to the reports page
+    if (mSnapshotModel) {
+        delete mSnapshotModel;
+        mSnapshotModel = 0;
+        mUi.searchLE->setEnabled(true);
+        const QModelIndex sourceIndex = mItemsTreeModel->indexForRemoteId(currentRemoteId);
+        if (sourceIndex.isValid()) {
+            const QModelIndex index = mFilter->mapFromSource(mFilterModel->mapFromSource(sourceIndex));
+            mUi.treeView->setCurrentIndex(index);
+            mUi.treeView->scrollTo(index);
+        }
+    }
 }
 
 Details *Page::details() const
@@ -512,13 +578,6 @@ void Page::insertFilterWidget(QWidget *widget)
     mUi.verticalLayout->insertWidget(1, widget);
 }
 
-static QString countryForAccount(const SugarAccount &account)
-{
-    const QString billingCountry = account.billingAddressCountry();
-    const QString country = billingCountry.isEmpty() ? account.shippingAddressCountry() : billingCountry;
-    return country.trimmed();
-}
-
 void Page::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
     kDebug() << typeToString(mType) << topLeft << bottomRight;
@@ -526,6 +585,10 @@ void Page::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottom
     const int end = bottomRight.row();
     const int firstColumn = topLeft.column();
     const int lastColumn = bottomRight.column();
+    const bool referencedDataChanged = mType == Account &&
+            ((firstColumn <= ItemsTreeModel::Country && ItemsTreeModel::Country <= lastColumn) ||
+             (firstColumn <= ItemsTreeModel::Name && ItemsTreeModel::Name <= lastColumn));
+    Item::List changedItems;
     for (int row = start; row <= end; ++row) {
         const QModelIndex index = mItemsTreeModel->index(row, 0, QModelIndex());
         if (!index.isValid()) {
@@ -538,16 +601,12 @@ void Page::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottom
         if (index == mCurrentIndex && mDetailsWidget) {
             mDetailsWidget->setItem(item); // update details widget
         }
-        if (mType == Account && item.hasPayload<SugarAccount>()) {
-            const SugarAccount account = item.payload<SugarAccount>();
-            if (firstColumn <= ItemsTreeModel::Country && ItemsTreeModel::Country <= lastColumn) {
-                ReferencedData::instance(AccountCountryRef)->setReferencedData(account.id(), countryForAccount(account));
-            }
-            if (firstColumn <= ItemsTreeModel::Name && ItemsTreeModel::Name <= lastColumn) {
-                ReferencedData::instance(AccountRef)->setReferencedData(account.id(), account.name());
-            }
+        if (referencedDataChanged) {
+            changedItems.append(item);
         }
     }
+    // queued after the insertions, which might still be pending
+    mIngestionPipeline->addItems(IngestionPipeline::Update, changedItems, true);
 }
 
 bool Page::askSave()
@@ -580,6 +639,7 @@ void Page::readSupportedFields()
             }
         } else {
             mDetailsWidget->details()->setSupportedFields(mSupportedFields);
+            clearDetailsDialogPool();
         }
     }
 }
@@ -588,8 +648,10 @@ void Page::readEnumDefinitionAttributes()
 {
     EnumDefinitionAttribute *enumsAttr = mCollection.attribute<EnumDefinitionAttribute>();
     if (enumsAttr) {
-        mEnumDefinitions = EnumDefinitions::fromString(enumsAttr->value());
+        // shared with the attribute, parsed only once per collection change
+        mEnumDefinitions = enumsAttr->definitions();
         mDetailsWidget->details()->setEnumDefinitions(mEnumDefinitions);
+        clearDetailsDialogPool(); // their comboboxes are filled already
     } else {
         kWarning() << "No EnumDefinitions in collection attribute for" << mCollection.id() << mCollection.name();
         kWarning() << "Collection attributes:";
@@ -610,6 +672,22 @@ void Page::slotResetSearch()
     mUi.searchLE->clear();
 }
 
+void Page::slotSearchTextChanged(const QString &text)
+{
+    // Clearing the search is cheap, apply it right away
+    if (text.isEmpty()) {
+        mSearchTimer->stop();
+        slotApplySearch();
+    } else {
+        mSearchTimer->start();
+    }
+}
+
+void Page::slotApplySearch()
+{
+    mFilter->setFilterString(mUi.searchLE->text());
+}
+
 void Page::slotReloadCollection()
 {
     if (mCollection.isValid()) {
@@ -625,6 +703,9 @@ void Page::slotCollectionChanged(const Akonadi::Collection &collection, const QS
         if (attributeNames.contains(s_supportedFieldsKey)) {
             readSupportedFields();
         }
+        if (attributeNames.contains(EnumDefinitionAttribute().type())) {
+            readEnumDefinitionAttributes();
+        }
     }
 }
 
@@ -692,164 +773,61 @@ void Page::printReport()
 }
 
 
+// Closed dialogs are kept for reuse, building one from the .ui files is slow
+static const int s_detailsDialogPoolSize = 3;
+
 DetailsDialog *Page::createDetailsDialog()
 {
+    TraceScope trace("Page::createDetailsDialog", "details");
+    if (!mDetailsDialogPool.isEmpty()) {
+        return mDetailsDialogPool.takeLast();
+    }
     Details* details = DetailsWidget::createDetailsForType(mType);
-    details->setResourceIdentifier(mResourceIdentifier, mResourceBaseUrl);
+    details->setResourceIdentifier(mResourceIdentifier);
     details->setNotesRepository(mNotesRepository);
     details->setSupportedFields(mSupportedFields);
     details->setEnumDefinitions(mEnumDefinitions);
     connectToDetails(details);
     DetailsDialog *dialog = new DetailsDialog(details, this);
-    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setProperty("poolGeneration", mDetailsDialogGeneration);
+    connect(dialog, SIGNAL(finished(int)), this, SLOT(slotDetailsDialogFinished()));
     return dialog;
 }
 
-void Page::addAccountsData(int start, int end, bool emitChanges)
-{
-    //kDebug() << start << end;
-    // QElapsedTimer dt; dt.start();
-    QMap<QString, QString> accountRefMap, assignedToRefMap, accountCountryRefMap;
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<SugarAccount>()) {
-            const SugarAccount account = item.payload<SugarAccount>();
-            accountRefMap.insert(account.id(), account.name());
-            assignedToRefMap.insert(account.assignedUserId(), account.assignedUserName());
-            accountCountryRefMap.insert(account.id(), countryForAccount(account));
-
-            AccountRepository::instance()->addAccount(account);
-        }
-    }
-    ReferencedData::instance(AccountRef)->addMap(accountRefMap, emitChanges); // renamings are handled in slotDataChanged
-    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges); // we assume user names don't change later
-    ReferencedData::instance(AccountCountryRef)->addMap(accountCountryRefMap, emitChanges); // country changes are handled in slotDataChanged
-    //kDebug() << "done," << dt.elapsed() << "ms";
-}
-
-void Page::removeAccountsData(int start, int end, bool emitChanges)
+void Page::slotDetailsDialogFinished()
 {
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<SugarAccount>()) {
-            const SugarAccount account = item.payload<SugarAccount>();
-            ReferencedData::instance(AccountRef)->removeReferencedData(account.id(), emitChanges);
-            ReferencedData::instance(AccountCountryRef)->removeReferencedData(account.id(), emitChanges);
-
-            AccountRepository::instance()->removeAccount(account);
-        }
-    }
-}
-
-void Page::addCampaignsData(int start, int end, bool emitChanges)
-{
-    //kDebug(); QElapsedTimer dt; dt.start();
-    //QMap<QString, QString> campaignRefMap;
-    QMap<QString, QString> assignedToRefMap;
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<SugarCampaign>()) {
-            const SugarCampaign campaign = item.payload<SugarCampaign>();
-            //campaignRefMap.insert(campaign.id(), campaign.name());
-            assignedToRefMap.insert(campaign.assignedUserId(), campaign.assignedUserName());
-        }
-    }
-    //ReferencedData::instance(CampaignRef)->addMap(campaignRefMap, emitChanges);
-    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges);
-    //kDebug() << "done," << dt.elapsed() << "ms";
-}
-
-void Page::removeCampaignsData(int start, int end, bool emitChanges)
-{
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    Q_UNUSED(emitChanges)
-}
-
-void Page::addContactsData(int start, int end, bool emitChanges)
-{
-    //kDebug(); QElapsedTimer dt; dt.start();
-    QMap<QString, QString> reportsToRefMap, assignedToRefMap;
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<KABC::Addressee>()) {
-            const KABC::Addressee addressee = item.payload<KABC::Addressee>();
-            const QString fullName = addressee.givenName() + ' ' + addressee.familyName();
-            reportsToRefMap.insert(addressee.custom("FATCRM", "X-ContactId"), fullName);
-            assignedToRefMap.insert(addressee.custom("FATCRM", "X-AssignedUserId"), addressee.custom("FATCRM", "X-AssignedUserName"));
-        }
+    DetailsDialog *dialog = qobject_cast<DetailsDialog *>(sender());
+    Q_ASSERT(dialog);
+    if (mDetailsDialogPool.contains(dialog)) { // finished twice
+        return;
     }
-    ReferencedData::instance(ReportsToRef)->addMap(reportsToRefMap, emitChanges); // TODO handle changes in slotDataChanged
-    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges);
-    //kDebug() << "done," << dt.elapsed() << "ms";
-}
+    // the connections made for this use, see slotItemDoubleClicked
+    disconnect(this, SIGNAL(modelItemChanged(Akonadi::Item)), dialog, 0);
+    disconnect(dialog, SIGNAL(itemSaved(Akonadi::Item)), this, 0);
 
-void Page::removeContactsData(int start, int end, bool emitChanges)
-{
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    Q_UNUSED(emitChanges)
-}
-
-void Page::addLeadsData(int start, int end, bool emitChanges)
-{
-    //kDebug();
-    QMap<QString, QString> assignedToRefMap;
-
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<SugarLead>()) {
-            const SugarLead lead = item.payload<SugarLead>();
-            assignedToRefMap.insert(lead.assignedUserId(), lead.assignedUserName());
-        }
+    if (dialog->property("poolGeneration").toInt() == mDetailsDialogGeneration &&
+            mDetailsDialogPool.count() < s_detailsDialogPoolSize) {
+        dialog->reset();
+        mDetailsDialogPool.append(dialog);
+    } else {
+        dialog->deleteLater();
     }
-    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges);
-}
-
-void Page::removeLeadsData(int start, int end, bool emitChanges)
-{
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    Q_UNUSED(emitChanges)
 }
 
-void Page::addOpportunitiesData(int start, int end, bool emitChanges)
+void Page::slotPrebuildDetailsDialog()
 {
-    //kDebug();
-    QMap<QString, QString> assignedToRefMap;
-    for (int row = start; row <= end; ++row) {
-        const QModelIndex index = mItemsTreeModel->index(row, 0);
-        const Item item = mItemsTreeModel->data(index, EntityTreeModel::ItemRole).value<Item>();
-        if (item.hasPayload<SugarOpportunity>()) {
-            const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
-            assignedToRefMap.insert(opportunity.assignedUserId(), opportunity.assignedUserName());
-        }
+    if (mDetailsDialogPool.isEmpty() && mCollection.isValid()) {
+        DetailsDialog *dialog = createDetailsDialog();
+        dialog->ensurePolished();
+        mDetailsDialogPool.append(dialog);
     }
-    ReferencedData::instance(AssignedToRef)->addMap(assignedToRefMap, emitChanges);
 }
 
-void Page::removeOpportunitiesData(int start, int end, bool emitChanges)
+void Page::clearDetailsDialogPool()
 {
-    Q_UNUSED(start)
-    Q_UNUSED(end)
-    Q_UNUSED(emitChanges)
-}
-
-void Page::retrieveResourceUrl()
-{
-    OrgKdeAkonadiSugarCRMSettingsInterface iface(
-                QLatin1String("org.freedesktop.Akonadi.Resource.") + mResourceIdentifier, QLatin1String("/Settings"), QDBusConnection::sessionBus() );
-    QDBusPendingReply<QString> reply = iface.host();
-    reply.waitForFinished();
-    if (reply.isValid()) {
-        mResourceBaseUrl = iface.host();
-        mDetailsWidget->details()->setResourceIdentifier(mResourceIdentifier, mResourceBaseUrl);
-    }
+    qDeleteAll(mDetailsDialogPool);
+    mDetailsDialogPool.clear();
+    ++mDetailsDialogGeneration; // the open ones are deleted when closed
 }
 
 // duplicated in listentriesjob.cpp
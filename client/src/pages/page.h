@@ -31,23 +31,28 @@
 #include "kdcrmdata/enumdefinitions.h"
 
 #include <Akonadi/Collection>
+#include <Akonadi/Item>
 
+#include <QSharedPointer>
 #include <QWidget>
 
 namespace Akonadi
 {
 class ChangeRecorder;
 class EntityMimeTypeFilterModel;
-class Item;
 }
 
+class ClientSnapshot;
 class Details;
 class DetailsDialog;
 class DetailsWidget;
+class IngestionPipeline;
 class KJob;
 class QAction;
 class QModelIndex;
+class QTimer;
 class NotesRepository;
+class SnapshotModel;
 
 class Page : public QWidget
 {
@@ -64,12 +69,15 @@ public:
     void setModificationsIgnored(bool b);
     void initialLoadingDone();
 
+    // Shows the items saved in @p snapshot until the model is loaded
+    void showSnapshot(const QSharedPointer<ClientSnapshot> &snapshot);
+    ItemsTreeModel *itemsTreeModel() const { return mItemsTreeModel; }
+
     QAction *showDetailsAction(const QString &title) const;
     void openDialog(const QString &id);
 
     bool showsDetails() const;
     void printReport();
-    void retrieveResourceUrl();
     KJob *clearTimestamp();
 
 Q_SIGNALS:
@@ -108,6 +116,8 @@ private Q_SLOTS:
     void slotRowsAboutToBeRemoved(const QModelIndex &, int start, int end);
     void slotDataChanged(const QModelIndex &, const QModelIndex &);
     void slotResetSearch();
+    void slotSearchTextChanged(const QString &text);
+    void slotApplySearch();
     void slotReloadCollection();
     void slotCollectionChanged(const Akonadi::Collection &collection, const QSet<QByteArray> &attributeNames);
     void slotEnsureDetailsVisible();
@@ -115,6 +125,9 @@ private Q_SLOTS:
     void slotCreateJobResult(KJob *job);
     void slotModifyJobResult(KJob *job);
     void slotItemSaved(const Akonadi::Item &item);
+    void slotIngestionIdle();
+    void slotDetailsDialogFinished();
+    void slotPrebuildDetailsDialog();
 
 private:
     virtual QString reportTitle() const = 0;
@@ -123,22 +136,16 @@ private:
     void connectToDetails(Details *details);
     virtual QMap<QString, QString> dataForNewObject() { return QMap<QString, QString>(); }
     void initialize();
+    void showModels();
     bool askSave();
     void readSupportedFields();
     void readEnumDefinitionAttributes();
 
-    void addAccountsData(int start, int end, bool emitChanges);
-    void removeAccountsData(int start, int end, bool emitChanges);
-    void addCampaignsData(int start, int end, bool emitChanges);
-    void removeCampaignsData(int start, int end, bool emitChanges);
-    void addContactsData(int start, int end, bool emitChanges);
-    void removeContactsData(int start, int end, bool emitChanges);
-    void addLeadsData(int start, int end, bool emitChanges);
-    void removeLeadsData(int start, int end, bool emitChanges);
-    void addOpportunitiesData(int start, int end, bool emitChanges);
-    void removeOpportunitiesData(int start, int end, bool emitChanges);
+    Akonadi::Item::List itemsInRows(int start, int end) const;
+    void prefetchNotes(const QModelIndex &index);
 
     DetailsDialog *createDetailsDialog();
+    void clearDetailsDialogPool();
 
 private:
     QString mMimeType;
@@ -151,16 +158,22 @@ private:
     QModelIndex mCurrentIndex;
     Ui_page mUi;
     QAction *mShowDetailsAction;
+    QTimer *mSearchTimer;
     QByteArray mResourceIdentifier;
 
     // Things we keep around so we can set them on the details dialog when creating it
-    QString mResourceBaseUrl;
     QStringList mSupportedFields;
     NotesRepository *mNotesRepository;
     EnumDefinitions mEnumDefinitions;
 
     Akonadi::EntityMimeTypeFilterModel *mFilterModel;
+    SnapshotModel *mSnapshotModel;
+    QList<DetailsDialog *> mDetailsDialogPool; // hidden, ready to be reused
+    int mDetailsDialogGeneration; // dialogs of older generations are outdated
+    IngestionPipeline *mIngestionPipeline;
     bool mInitialLoadingDone;
+    bool mModelLoadedPending; // modelLoaded() is emitted once the pipeline is idle
+    qint64 mLoadStart; // for tracing
 };
 
 #endif
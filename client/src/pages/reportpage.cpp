@@ -58,21 +58,23 @@ void ReportPage::on_calculateOppCount_clicked()
     int createdCount = 0;
     int wonCount = 0;
     int lostCount = 0;
+    const qint64 fromSecs = KDCRMUtils::secsSinceEpochFromDate(ui->from->date());
+    const qint64 toSecs = KDCRMUtils::secsSinceEpochFromDate(ui->to->date().addDays(1)); // exclusive
     for (int i = 0; i < mOppModel->rowCount(); ++i) {
         const QModelIndex index = mOppModel->index(i, 0);
         const Akonadi::Item item = mOppModel->data(index, Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
         if (item.hasPayload<SugarOpportunity>()) {
             const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
 
-            const QDate created = KDCRMUtils::dateTimeFromString(opportunity.dateEntered()).date();
-            if (created >= ui->from->date() && created <= ui->to->date()) {
+            const qint64 created = opportunity.dateEnteredSecsSinceEpoch();
+            if (created >= fromSecs && created < toSecs) {
                 ++createdCount;
             }
 
             const QString salesStage = opportunity.salesStage();
             if (salesStage.contains("Closed")) {
-                const QDate dateModified = opportunity.dateModified().date();
-                if (dateModified >= ui->from->date() && dateModified <= ui->to->date()) {
+                const qint64 dateModified = opportunity.dateModifiedSecsSinceEpoch();
+                if (dateModified >= fromSecs && dateModified < toSecs) {
                     if (salesStage.contains("Closed Won") ) {
                         ++wonCount;
                     } else if (salesStage.contains("Closed Lost")) {
@@ -21,6 +21,8 @@
 */
 
 #include "reportgenerator.h"
+#include "tracer.h"
+
 #include <KDReportsReport.h>
 #include <KDReportsHeader.h>
 #include <KDReportsTextElement.h>
@@ -71,27 +73,32 @@ void ReportGenerator::generateListReport(QAbstractItemModel *model, const QStrin
                                          const QString &subTitle, QWidget *parent)
 {
     KDReports::Report report;
-    setupReport(report);
-    addTitle(report, title);
-    addSubTitle(report, subTitle);
+    {
+        TraceScope trace("ReportGenerator::generateListReport", "report");
+        setupReport(report);
+        addTitle(report, title);
+        addSubTitle(report, subTitle);
 
-    report.addVerticalSpacing(5);
+        report.addVerticalSpacing(5);
 
-    report.setParagraphMargins(1, 1, 1, 1);
-    KDReports::AutoTableElement table(model);
-    table.setVerticalHeaderVisible(false);
-    report.addElement(table);
+        report.setParagraphMargins(1, 1, 1, 1);
+        KDReports::AutoTableElement table(model);
+        table.setVerticalHeaderVisible(false);
+        report.addElement(table);
+    }
 
     finalizeReport(report, parent);
 }
 
 void ReportGenerator::finalizeReport(KDReports::Report &report, QWidget *parent)
 {
+    const qint64 traceStart = Tracer::timestamp();
     report.setPageSize(QPrinter::A4);
 
     KDReports::PreviewDialog preview(&report, parent);
     preview.previewWidget()->setShowPageListWidget(false);
     preview.previewWidget()->setShowTableSettingsDialog(false);
     preview.resize(1167, 906);
+    Tracer::instance()->addEvent("ReportGenerator::layoutReport", "report", traceStart);
     preview.exec();
 }
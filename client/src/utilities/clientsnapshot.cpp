@@ -0,0 +1,342 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "clientsnapshot.h"
+#include "itemstreemodel.h"
+#include "referenceddata.h"
+
+#include <Akonadi/Item>
+
+#include <KDebug>
+#include <KSaveFile>
+#include <KStandardDirs>
+
+#include <string.h>
+
+static const char s_magic[8] = { 'F', 'C', 'R', 'M', 'S', 'N', 'A', 'P' };
+static const quint32 s_version = 1;
+static const quint32 s_byteOrderMark = 0x01020304; // the file is only read on the machine that wrote it
+static const quint32 s_nullBlob = 0xffffffff; // size of a null sort key
+
+enum TableKind {
+    ItemsTable = 1, // fields: remote id, then text and sort key of each column
+    ReferencedDataTable = 2 // fields: id, data
+};
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+    quint32 tableCount;
+    quint32 reserved;
+};
+
+struct ClientSnapshot::Table
+{
+    quint32 kind;
+    quint32 type;
+    quint32 rows;
+    quint32 fields;
+    quint64 cellsOffset; // rows * fields cells of (offset, size) in the file
+};
+
+static quint64 alignedTo8(quint64 pos)
+{
+    return (pos + 7) & ~quint64(7);
+}
+
+ClientSnapshot::ClientSnapshot()
+    : mData(0),
+      mSize(0)
+{
+}
+
+ClientSnapshot::~ClientSnapshot()
+{
+    close();
+}
+
+QString ClientSnapshot::fileNameForResource(const QString &resourceIdentifier)
+{
+    return KStandardDirs::locateLocal("appdata", QLatin1String("snapshots/") + resourceIdentifier);
+}
+
+bool ClientSnapshot::open(const QString &fileName)
+{
+    close();
+    mFile.setFileName(fileName);
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    mSize = mFile.size();
+    const uchar *data = mSize >= qint64(sizeof(FileHeader)) ? mFile.map(0, mSize) : 0;
+    if (!data) {
+        mFile.close();
+        return false;
+    }
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    bool valid = memcmp(header->magic, s_magic, sizeof(s_magic)) == 0 &&
+                 header->version == s_version &&
+                 header->byteOrderMark == s_byteOrderMark &&
+                 sizeof(FileHeader) + quint64(header->tableCount) * sizeof(Table) <= quint64(mSize);
+    if (valid) {
+        const Table *tables = reinterpret_cast<const Table *>(data + sizeof(FileHeader));
+        for (quint32 i = 0; i < header->tableCount; ++i) {
+            const Table *table = tables + i;
+            const quint64 cellsSize = quint64(table->rows) * table->fields * 2 * sizeof(quint32);
+            if (table->cellsOffset % sizeof(quint32) != 0 || table->cellsOffset + cellsSize > quint64(mSize)) {
+                valid = false;
+                break;
+            }
+            mTables.append(table);
+        }
+    }
+    if (!valid) {
+        kWarning() << "Ignoring invalid snapshot" << fileName;
+        mTables.clear();
+        mFile.unmap(const_cast<uchar *>(data));
+        mFile.close();
+        return false;
+    }
+    mData = data;
+    return true;
+}
+
+void ClientSnapshot::close()
+{
+    if (mData) {
+        mFile.unmap(const_cast<uchar *>(mData));
+        mFile.close();
+        mData = 0;
+        mSize = 0;
+        mTables.clear();
+    }
+}
+
+const ClientSnapshot::Table *ClientSnapshot::table(int kind, int type) const
+{
+    foreach (const Table *table, mTables) {
+        if (table->kind == quint32(kind) && table->type == quint32(type)) {
+            return table;
+        }
+    }
+    return 0;
+}
+
+QByteArray ClientSnapshot::blob(const Table *table, int row, int field) const
+{
+    const quint32 *cell = reinterpret_cast<const quint32 *>(mData + table->cellsOffset) + 2 * (quint64(row) * table->fields + field);
+    const quint32 offset = cell[0];
+    const quint32 size = cell[1];
+    if (size == s_nullBlob || quint64(offset) + size > quint64(mSize)) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(mData + offset), size);
+}
+
+QString ClientSnapshot::string(const Table *table, int row, int field) const
+{
+    const QByteArray data = blob(table, row, field);
+    if (reinterpret_cast<quintptr>(data.constData()) % sizeof(QChar) != 0) {
+        return QString();
+    }
+    return QString::fromRawData(reinterpret_cast<const QChar *>(data.constData()), data.size() / sizeof(QChar));
+}
+
+int ClientSnapshot::rowCount(DetailsType type) const
+{
+    const Table *items = table(ItemsTable, type);
+    return items ? int(items->rows) : 0;
+}
+
+int ClientSnapshot::columnCount(DetailsType type) const
+{
+    const Table *items = table(ItemsTable, type);
+    return items ? int(items->fields - 1) / 2 : 0;
+}
+
+QString ClientSnapshot::remoteId(DetailsType type, int row) const
+{
+    const Table *items = table(ItemsTable, type);
+    if (!items || row < 0 || quint32(row) >= items->rows) {
+        return QString();
+    }
+    return string(items, row, 0);
+}
+
+QString ClientSnapshot::text(DetailsType type, int row, int column) const
+{
+    const Table *items = table(ItemsTable, type);
+    if (!items || row < 0 || quint32(row) >= items->rows || column < 0 || quint32(2 * column + 1) >= items->fields) {
+        return QString();
+    }
+    return string(items, row, 2 * column + 1);
+}
+
+QByteArray ClientSnapshot::sortKey(DetailsType type, int row, int column) const
+{
+    const Table *items = table(ItemsTable, type);
+    if (!items || row < 0 || quint32(row) >= items->rows || column < 0 || quint32(2 * column + 2) >= items->fields) {
+        return QByteArray();
+    }
+    return blob(items, row, 2 * column + 2);
+}
+
+QMap<QString, QString> ClientSnapshot::referencedData(ReferencedDataType type) const
+{
+    QMap<QString, QString> map;
+    const Table *data = table(ReferencedDataTable, type);
+    if (data && data->fields == 2) {
+        for (quint32 row = 0; row < data->rows; ++row) {
+            // deep copies, they outlive the mapping
+            const QString id = string(data, row, 0);
+            const QString value = string(data, row, 1);
+            map.insert(QString(id.constData(), id.size()), QString(value.constData(), value.size()));
+        }
+    }
+    return map;
+}
+
+void ClientSnapshotWriter::addBlob(PendingTable &table, const char *data, int size)
+{
+    if (table.blobs.size() % 2) {
+        table.blobs.append('\0'); // keep strings aligned
+    }
+    table.cells << quint32(table.blobs.size()) << quint32(size);
+    table.blobs.append(data, size);
+}
+
+void ClientSnapshotWriter::addString(PendingTable &table, const QString &text)
+{
+    addBlob(table, reinterpret_cast<const char *>(text.utf16()), text.size() * sizeof(QChar));
+}
+
+void ClientSnapshotWriter::addItems(DetailsType type, const QAbstractItemModel *model)
+{
+    const int columns = ItemsTreeModel::columnTypes(type).count();
+    PendingTable table;
+    table.kind = ItemsTable;
+    table.type = type;
+    table.rows = 0;
+    table.fields = 1 + 2 * columns;
+    const int rows = model->rowCount();
+    table.cells.reserve(rows * table.fields * 2);
+    for (int row = 0; row < rows; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        if (!item.isValid()) {
+            continue;
+        }
+        addString(table, item.remoteId());
+        for (int column = 0; column < columns; ++column) {
+            const QModelIndex cell = model->index(row, column);
+            addString(table, cell.data(Qt::DisplayRole).toString());
+            const QByteArray key = cell.data(ItemsTreeModel::SortKeyRole).toByteArray();
+            if (key.isNull()) {
+                table.cells << 0 << s_nullBlob;
+            } else {
+                addBlob(table, key.constData(), key.size());
+            }
+        }
+        ++table.rows;
+    }
+    mTables.append(table);
+}
+
+void ClientSnapshotWriter::addReferencedData(ReferencedDataType type)
+{
+    const ReferencedData *data = ReferencedData::instance(type);
+    PendingTable table;
+    table.kind = ReferencedDataTable;
+    table.type = type;
+    table.rows = data->count();
+    table.fields = 2;
+    for (int row = 0; row < data->count(); ++row) {
+        const QPair<QString, QString> pair = data->data(row);
+        addString(table, pair.first);
+        addString(table, pair.second);
+    }
+    mTables.append(table);
+}
+
+static bool writePadding(QIODevice &device)
+{
+    static const char s_zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    const int padding = int(alignedTo8(device.pos()) - device.pos());
+    return padding == 0 || device.write(s_zeros, padding) == padding;
+}
+
+bool ClientSnapshotWriter::save(const QString &fileName) const
+{
+    // Layout: header, table directory, then the cells and blobs of each table
+    QVector<ClientSnapshot::Table> directory;
+    QVector<quint64> blobOffsets;
+    quint64 pos = sizeof(FileHeader) + mTables.count() * sizeof(ClientSnapshot::Table);
+    foreach (const PendingTable &pending, mTables) {
+        pos = alignedTo8(pos);
+        const ClientSnapshot::Table table = { pending.kind, pending.type, pending.rows, pending.fields, pos };
+        directory.append(table);
+        pos = alignedTo8(pos + pending.cells.count() * sizeof(quint32));
+        blobOffsets.append(pos);
+        pos += pending.blobs.size();
+    }
+    if (pos >= s_nullBlob) {
+        kWarning() << "Snapshot too big:" << pos;
+        return false;
+    }
+
+    KSaveFile file(fileName);
+    if (!file.open()) {
+        kWarning() << "Can't write snapshot" << fileName << file.errorString();
+        return false;
+    }
+    FileHeader header;
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = s_version;
+    header.byteOrderMark = s_byteOrderMark;
+    header.tableCount = mTables.count();
+    header.reserved = 0;
+    bool ok = file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+    ok = ok && file.write(reinterpret_cast<const char *>(directory.constData()), directory.count() * sizeof(ClientSnapshot::Table)) ==
+               qint64(directory.count() * sizeof(ClientSnapshot::Table));
+    for (int i = 0; ok && i < mTables.count(); ++i) {
+        const PendingTable &pending = mTables.at(i);
+        QVector<quint32> cells = pending.cells;
+        for (int cell = 0; cell < cells.count(); cell += 2) {
+            if (cells.at(cell + 1) != s_nullBlob) {
+                cells[cell] += blobOffsets.at(i);
+            }
+        }
+        ok = writePadding(file) &&
+             file.write(reinterpret_cast<const char *>(cells.constData()), cells.count() * sizeof(quint32)) == qint64(cells.count() * sizeof(quint32)) &&
+             writePadding(file) &&
+             file.write(pending.blobs) == pending.blobs.size();
+    }
+    if (!ok) {
+        kWarning() << "Error writing snapshot" << fileName << file.errorString();
+        file.abort();
+        return false;
+    }
+    return file.finalize();
+}
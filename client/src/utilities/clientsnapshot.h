@@ -0,0 +1,112 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLIENTSNAPSHOT_H
+#define CLIENTSNAPSHOT_H
+
+#include "enums.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+class QAbstractItemModel;
+
+/**
+ * A memory-mapped copy of the list views and of the ReferencedData tables,
+ * saved by ClientSnapshotWriter, so that they can be shown at startup
+ * while the real models are being loaded from Akonadi.
+ *
+ * The file is a directory of tables, each a matrix of (offset, size) cells
+ * pointing into blobs of UTF-16 text or sort keys. Nothing is parsed when
+ * opening it; the strings returned by text() point into the mapping and
+ * are only valid while the snapshot is open.
+ */
+class ClientSnapshot
+{
+public:
+    ClientSnapshot();
+    ~ClientSnapshot();
+
+    static QString fileNameForResource(const QString &resourceIdentifier);
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return mData != 0; }
+
+    int rowCount(DetailsType type) const;
+    int columnCount(DetailsType type) const;
+    QString remoteId(DetailsType type, int row) const;
+    QString text(DetailsType type, int row, int column) const;
+    QByteArray sortKey(DetailsType type, int row, int column) const;
+
+    QMap<QString, QString> referencedData(ReferencedDataType type) const;
+
+private:
+    friend class ClientSnapshotWriter;
+    struct Table;
+    const Table *table(int kind, int type) const;
+    QByteArray blob(const Table *table, int row, int field) const;
+    QString string(const Table *table, int row, int field) const;
+
+    QFile mFile;
+    const uchar *mData;
+    qint64 mSize;
+    QVector<const Table *> mTables;
+
+    Q_DISABLE_COPY(ClientSnapshot)
+};
+
+/**
+ * Collects the data of a ClientSnapshot and saves it atomically.
+ */
+class ClientSnapshotWriter
+{
+public:
+    /**
+     * Adds the rows of @p model which hold an item, with the ItemsTreeModel columns of @p type
+     */
+    void addItems(DetailsType type, const QAbstractItemModel *model);
+    void addReferencedData(ReferencedDataType type);
+    bool save(const QString &fileName) const;
+
+private:
+    struct PendingTable
+    {
+        quint32 kind;
+        quint32 type;
+        quint32 rows;
+        quint32 fields;
+        QVector<quint32> cells; // (offset, size) in blobs
+        QByteArray blobs;
+    };
+
+    static void addBlob(PendingTable &table, const char *data, int size);
+    static void addString(PendingTable &table, const QString &text);
+
+    QList<PendingTable> mTables;
+};
+
+#endif
@@ -22,6 +22,8 @@
 
 #include "collectionmanager.h"
 
+#include "tracer.h"
+
 #include <Akonadi/CollectionFetchJob>
 #include <Akonadi/CollectionFetchScope>
 
@@ -44,6 +46,7 @@ void CollectionManager::setResource(const QByteArray &identifier)
     CollectionFetchJob *job = new CollectionFetchJob(Collection::root(), CollectionFetchJob::Recursive);
     job->fetchScope().setResource(identifier);
     job->fetchScope().setIncludeStatistics(true);
+    job->setProperty("traceStart", Tracer::timestamp());
     connect(job, SIGNAL(result(KJob*)),
             this, SLOT(slotCollectionFetchResult(KJob*)));
 }
@@ -74,9 +77,9 @@ static bool collectionLessThan(const Collection &c1, const Collection &c2)
     const QString contentMimeType1 = c1.contentMimeTypes().at(0);
     const QString contentMimeType2 = c2.contentMimeTypes().at(0);
 
-    // Now emit them in the right order for fast startup.
-    // We want to see Accounts first (because required by Opportunities),
-    // then Opportunities (because visible on screen), and load Notes/Emails last.
+    // All collections are loaded in parallel (see StartupScheduler), this order only
+    // decides which fetch jobs are queued first: Accounts (because required by Opportunities),
+    // then Opportunities (because visible on screen), and Notes/Emails last.
 
     const int order1 = orderForCollection(contentMimeType1);
     const int order2 = orderForCollection(contentMimeType2);
@@ -87,6 +90,7 @@ static bool collectionLessThan(const Collection &c1, const Collection &c2)
 void CollectionManager::slotCollectionFetchResult(KJob *job)
 {
     CollectionFetchJob *fetchJob = qobject_cast<CollectionFetchJob *>(job);
+    Tracer::instance()->addEvent("CollectionManager::fetchCollections", "startup", job->property("traceStart").toLongLong());
 
     QVector<Collection> collections;
     Q_FOREACH (const Collection &collection, fetchJob->collections()) {
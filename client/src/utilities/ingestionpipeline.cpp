@@ -0,0 +1,211 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ingestionpipeline.h"
+#include "accountrepository.h"
+#include "referenceddata.h"
+#include "tracer.h"
+
+#include "kdcrmdata/sugarcampaign.h"
+#include "kdcrmdata/sugarlead.h"
+#include "kdcrmdata/sugaropportunity.h"
+
+#include <KABC/Addressee>
+
+#include <QtConcurrentRun>
+
+static QString countryForAccount(const SugarAccount &account)
+{
+    const QString billingCountry = account.billingAddressCountry();
+    const QString country = billingCountry.isEmpty() ? account.shippingAddressCountry() : billingCountry;
+    return country.trimmed();
+}
+
+// Runs in a worker thread: only reads the (implicitly shared) payloads of the items
+static IngestionPipeline::Result extractData(DetailsType type, const IngestionPipeline::Batch &batch)
+{
+    TraceScope trace("IngestionPipeline::extractData", "startup");
+    if (trace.isActive()) {
+        trace.setDetail(QString::fromLatin1("%1: %2 items").arg(typeToString(type)).arg(batch.items.count()));
+    }
+    IngestionPipeline::Result result;
+    result.operation = batch.operation;
+    result.emitChanges = batch.emitChanges;
+
+    foreach (const Akonadi::Item &item, batch.items) {
+        switch (type) {
+        case Account:
+            if (item.hasPayload<SugarAccount>()) {
+                const SugarAccount account = item.payload<SugarAccount>();
+                if (batch.operation == IngestionPipeline::Remove) {
+                    result.accountIds.append(account.id());
+                    result.accounts.append(account);
+                    break;
+                }
+                result.accountRefMap.insert(account.id(), account.name()); // renamings are handled as updates
+                result.accountCountryRefMap.insert(account.id(), countryForAccount(account));
+                if (batch.operation == IngestionPipeline::Insert) {
+                    result.assignedToRefMap.insert(account.assignedUserId(), account.assignedUserName()); // we assume user names don't change later
+                    result.accounts.append(account);
+                }
+            }
+            break;
+        case Campaign:
+            if (batch.operation == IngestionPipeline::Insert && item.hasPayload<SugarCampaign>()) {
+                const SugarCampaign campaign = item.payload<SugarCampaign>();
+                result.assignedToRefMap.insert(campaign.assignedUserId(), campaign.assignedUserName());
+            }
+            break;
+        case Contact:
+            if (batch.operation == IngestionPipeline::Insert && item.hasPayload<KABC::Addressee>()) {
+                const KABC::Addressee addressee = item.payload<KABC::Addressee>();
+                const QString fullName = addressee.givenName() + ' ' + addressee.familyName();
+                result.reportsToRefMap.insert(addressee.custom("FATCRM", "X-ContactId"), fullName); // TODO handle changes
+                result.assignedToRefMap.insert(addressee.custom("FATCRM", "X-AssignedUserId"), addressee.custom("FATCRM", "X-AssignedUserName"));
+            }
+            break;
+        case Lead:
+            if (batch.operation == IngestionPipeline::Insert && item.hasPayload<SugarLead>()) {
+                const SugarLead lead = item.payload<SugarLead>();
+                result.assignedToRefMap.insert(lead.assignedUserId(), lead.assignedUserName());
+            }
+            break;
+        case Opportunity:
+            if (batch.operation == IngestionPipeline::Insert && item.hasPayload<SugarOpportunity>()) {
+                const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+                result.assignedToRefMap.insert(opportunity.assignedUserId(), opportunity.assignedUserName());
+            }
+            break;
+        default: // other objects (like Note) not shown in a Page
+            break;
+        }
+    }
+    return result;
+}
+
+IngestionPipeline::IngestionPipeline(DetailsType type, QObject *parent)
+    : QObject(parent),
+      mType(type),
+      mResultPending(false),
+      mDiscardResult(false)
+{
+    connect(&mWatcher, SIGNAL(finished()), this, SLOT(slotBatchDone()));
+}
+
+IngestionPipeline::~IngestionPipeline()
+{
+    mWatcher.waitForFinished();
+}
+
+void IngestionPipeline::addItems(Operation operation, const Akonadi::Item::List &items, bool emitChanges)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+    if (!mQueue.isEmpty() && mQueue.last().operation == operation && mQueue.last().emitChanges == emitChanges) {
+        mQueue.last().items += items;
+    } else {
+        const Batch batch = { operation, emitChanges, items };
+        mQueue.append(batch);
+    }
+    scheduleBatch();
+}
+
+void IngestionPipeline::clear()
+{
+    mQueue.clear();
+    mDiscardResult = mResultPending;
+}
+
+void IngestionPipeline::waitForIdle()
+{
+    while (mResultPending) {
+        mWatcher.waitForFinished();
+        slotBatchDone();
+    }
+}
+
+void IngestionPipeline::scheduleBatch()
+{
+    if (mResultPending || mQueue.isEmpty()) {
+        return;
+    }
+    const Batch batch = mQueue.first();
+    mQueue.remove(0);
+    mResultPending = true;
+    mWatcher.setFuture(QtConcurrent::run(extractData, mType, batch));
+}
+
+void IngestionPipeline::slotBatchDone()
+{
+    if (!mResultPending || !mWatcher.isFinished()) {
+        return;
+    }
+    mResultPending = false;
+    if (mDiscardResult) {
+        mDiscardResult = false;
+    } else {
+        publish(mWatcher.result());
+    }
+    scheduleBatch();
+    if (isIdle()) {
+        emit idle();
+    }
+}
+
+void IngestionPipeline::publish(const Result &result)
+{
+    TraceScope trace("IngestionPipeline::publish", "startup");
+    if (trace.isActive()) {
+        trace.setDetail(typeToString(mType));
+    }
+    emit publishing(true);
+
+    AccountRepository *accounts = AccountRepository::instance();
+    foreach (const SugarAccount &account, result.accounts) {
+        if (result.operation == Remove) {
+            accounts->removeAccount(account);
+        } else {
+            accounts->addAccount(account);
+        }
+    }
+    if (!result.accountIds.isEmpty()) {
+        ReferencedData::instance(AccountRef)->removeReferencedData(result.accountIds, result.emitChanges);
+        ReferencedData::instance(AccountCountryRef)->removeReferencedData(result.accountIds, result.emitChanges);
+    }
+    if (!result.accountRefMap.isEmpty()) {
+        ReferencedData::instance(AccountRef)->addMap(result.accountRefMap, result.emitChanges);
+    }
+    if (!result.assignedToRefMap.isEmpty()) {
+        ReferencedData::instance(AssignedToRef)->addMap(result.assignedToRefMap, result.emitChanges);
+    }
+    if (!result.accountCountryRefMap.isEmpty()) {
+        ReferencedData::instance(AccountCountryRef)->addMap(result.accountCountryRefMap, result.emitChanges);
+    }
+    if (!result.reportsToRefMap.isEmpty()) {
+        ReferencedData::instance(ReportsToRef)->addMap(result.reportsToRefMap, result.emitChanges);
+    }
+
+    emit publishing(false);
+}
+
+#include "ingestionpipeline.moc"
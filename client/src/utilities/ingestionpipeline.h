@@ -0,0 +1,110 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INGESTIONPIPELINE_H
+#define INGESTIONPIPELINE_H
+
+#include "enums.h"
+
+#include "kdcrmdata/sugaraccount.h"
+
+#include <Akonadi/Item>
+
+#include <QFutureWatcher>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Extracts the data derived from the items of a page (the ReferencedData
+ * maps and the accounts of the AccountRepository) in a background thread,
+ * and publishes it in the GUI thread.
+ *
+ * The items are queued in batches, which are processed one at a time and
+ * published in the order they were queued; consecutive batches of the same
+ * kind are merged while a job is running. Publishing a batch only means
+ * applying the prepared maps, i.e. emitting the signals of ReferencedData.
+ */
+class IngestionPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    enum Operation {
+        Insert, // new items
+        Update, // changed items, only updates the ReferencedData
+        Remove  // removed items
+    };
+
+    explicit IngestionPipeline(DetailsType type, QObject *parent = 0);
+    ~IngestionPipeline();
+
+    void addItems(Operation operation, const Akonadi::Item::List &items, bool emitChanges);
+
+    /**
+     * Drops the queued batches and the result of the running job, e.g. when switching resources.
+     */
+    void clear();
+
+    bool isIdle() const { return !mResultPending && mQueue.isEmpty(); }
+
+    /**
+     * Blocks until all queued batches are published. For unittests.
+     */
+    void waitForIdle();
+
+    struct Batch {
+        Operation operation;
+        bool emitChanges;
+        Akonadi::Item::List items;
+    };
+
+    struct Result {
+        Operation operation;
+        bool emitChanges;
+        QMap<QString, QString> accountRefMap;
+        QMap<QString, QString> assignedToRefMap;
+        QMap<QString, QString> accountCountryRefMap;
+        QMap<QString, QString> reportsToRefMap;
+        QStringList accountIds;
+        QVector<SugarAccount> accounts;
+    };
+
+Q_SIGNALS:
+    void publishing(bool inProgress); // around the changes of the referenced data
+    void idle();
+
+private Q_SLOTS:
+    void slotBatchDone();
+
+private:
+    void scheduleBatch();
+    void publish(const Result &result);
+
+    DetailsType mType;
+    QVector<Batch> mQueue;
+    bool mResultPending; // a job was started and its result not processed yet
+    bool mDiscardResult;
+    QFutureWatcher<Result> mWatcher;
+};
+
+#endif
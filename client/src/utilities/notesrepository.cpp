@@ -22,26 +22,56 @@
 
 #include "notesrepository.h"
 
+#include "kdcrmdata/payloadbody.h"
+
 #include <Akonadi/Collection>
 #include <Akonadi/CollectionStatistics>
 #include <Akonadi/ItemFetchJob>
 #include <Akonadi/ItemFetchScope>
 #include <Akonadi/Monitor>
 
+#include <KDebug>
+
+// in bytes, approximately
+static const int s_bodyCacheSize = 8 * 1024 * 1024;
+static const int s_headerSize = 1024;
+
+template <typename T>
+static int bodyCost(const T &noteOrEmail, int maxCost)
+{
+    return qMin(maxCost, s_headerSize + noteOrEmail.description().size() * int(sizeof(QChar)));
+}
+
+// Returns @p item with a copy of @p payload without its body, to keep in the index
+template <typename T>
+static Akonadi::Item headerItem(const Akonadi::Item &item, T payload)
+{
+    payload.setDescription(QString());
+    Akonadi::Item header(item);
+    header.setPayload(payload);
+    return header;
+}
+
 NotesRepository::NotesRepository(QObject *parent) :
     QObject(parent),
     mMonitor(0),
-    mNotesLoaded(0),
-    mEmailsLoaded(0)
+    mNoteBodies(s_bodyCacheSize),
+    mEmailBodies(s_bodyCacheSize)
 {
 }
 
 void NotesRepository::clear()
 {
-    mNotesLoaded = 0;
-    mEmailsLoaded = 0;
-    mNotesHash.clear();
-    mEmailsHash.clear();
+    mNotes.clear();
+    mEmails.clear();
+    mNotesJob = 0; // its items are ignored
+    mEmailsJob = 0;
+    mNotesWithoutHeader.clear();
+    mEmailsWithoutHeader.clear();
+    mNoteBodies.clear();
+    mEmailBodies.clear();
+    mPendingBodies.clear();
+    mBodyJobs.clear(); // their results are ignored
     delete mMonitor;
     mMonitor = 0;
 }
@@ -55,40 +85,92 @@ void NotesRepository::loadNotes()
 {
     //kDebug() << "Loading" << mNotesCollection.statistics().count() << "notes";
 
+    if (mNotesCollection.statistics().count() == 0) {
+        // no itemsReceived to wait for
+        QMetaObject::invokeMethod(this, "notesLoaded", Qt::QueuedConnection, Q_ARG(int, 0));
+        return;
+    }
+
     // load notes
-    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mNotesCollection, this);
-    configureItemFetchScope(job->fetchScope());
-    connect(job, SIGNAL(itemsReceived(Akonadi::Item::List)),
+    mNotesJob = new Akonadi::ItemFetchJob(mNotesCollection, this);
+    configureItemFetchScope(mNotesJob->fetchScope());
+    connect(mNotesJob, SIGNAL(itemsReceived(Akonadi::Item::List)),
             this, SLOT(slotNotesReceived(Akonadi::Item::List)));
+    connect(mNotesJob, SIGNAL(result(KJob*)),
+            this, SLOT(slotNotesJobResult(KJob*)));
 }
 
-QVector<SugarNote> NotesRepository::notesForOpportunity(const QString &id) const
+QVector<SugarNote> NotesRepository::notesForOpportunity(const QString &id)
 {
-    return mNotesHash.value(id);
+    const Akonadi::Item::List items = mNotes.items(id);
+    QVector<SugarNote> notes;
+    notes.reserve(items.count());
+    foreach (const Akonadi::Item &item, items) {
+        const SugarNote *note = mNoteBodies.object(item.id());
+        notes.append(note ? *note : item.payload<SugarNote>());
+    }
+    fetchBodies(missingBodies(id));
+    return notes;
 }
 
 void NotesRepository::slotNotesReceived(const Akonadi::Item::List &items)
 {
-    mNotesLoaded += items.count();
+    if (sender() != mNotesJob) {
+        return; // started before clear()
+    }
+    const bool withBody = mNotesJob->fetchScope().fullPayload();
     foreach(const Akonadi::Item &item, items) {
-        storeNote(item);
+        if (!withBody && !item.loadedPayloadParts().contains(PayloadBody::headerPartName())) {
+            mNotesWithoutHeader.append(Akonadi::Item(item.id()));
+        } else {
+            storeNote(item, withBody);
+        }
+    }
+}
+
+void NotesRepository::slotNotesJobResult(KJob *job)
+{
+    if (job != mNotesJob) {
+        return;
     }
-    //kDebug() << "loaded" << mNotesLoaded << "notes; now hash has" << mNotesHash.count() << "entries";
-    if (mNotesLoaded == mNotesCollection.statistics().count())
-        emit notesLoaded(mNotesLoaded);
+    mNotesJob = 0;
+    if (job->error()) {
+        kWarning() << job->errorString();
+    }
+    if (!mNotesWithoutHeader.isEmpty()) {
+        mNotesJob = new Akonadi::ItemFetchJob(mNotesWithoutHeader, this);
+        configureItemFetchScope(mNotesJob->fetchScope(), true);
+        mNotesWithoutHeader.clear();
+        connect(mNotesJob, SIGNAL(itemsReceived(Akonadi::Item::List)),
+                this, SLOT(slotNotesReceived(Akonadi::Item::List)));
+        connect(mNotesJob, SIGNAL(result(KJob*)),
+                this, SLOT(slotNotesJobResult(KJob*)));
+        return;
+    }
+    // counted in the index, so that items received twice (e.g. also from the monitor) count once
+    //kDebug() << "loaded" << mNotes.count() << "notes";
+    emit notesLoaded(mNotes.count());
 }
 
-void NotesRepository::storeNote(const Akonadi::Item &item)
+void NotesRepository::storeNote(const Akonadi::Item &item, bool withBody)
 {
     //kDebug() << item.id() << item.mimeType() << ;
+    mNoteBodies.remove(item.id()); // outdated if the item changed
     if (item.hasPayload<SugarNote>()) {
         SugarNote note = item.payload<SugarNote>();
         if (note.parentType() == QLatin1String("Opportunities")) {
-            mNotesHash[note.parentId()].append(note);
+            if (withBody) {
+                // the body only goes into the cache, so that it can be evicted
+                mNotes.insert(headerItem(item, note), note.parentId());
+                mNoteBodies.insert(item.id(), new SugarNote(note), bodyCost(note, mNoteBodies.maxCost()));
+            } else {
+                mNotes.insert(item, note.parentId());
+            }
         } else {
             // We also get notes for Accounts and Emails.
             // (well, no longer, we filter this out in the resource)
             //kDebug() << "ignoring notes for" << note.parentType();
+            mNotes.remove(item.id());
         }
     }
 }
@@ -104,11 +186,19 @@ void NotesRepository::loadEmails()
 {
     //kDebug() << "Loading" << mEmailsCollection.statistics().count() << "emails";
 
+    if (mEmailsCollection.statistics().count() == 0) {
+        // no itemsReceived to wait for
+        QMetaObject::invokeMethod(this, "emailsLoaded", Qt::QueuedConnection, Q_ARG(int, 0));
+        return;
+    }
+
     // load emails
-    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mEmailsCollection, this);
-    configureItemFetchScope(job->fetchScope());
-    connect(job, SIGNAL(itemsReceived(Akonadi::Item::List)),
+    mEmailsJob = new Akonadi::ItemFetchJob(mEmailsCollection, this);
+    configureItemFetchScope(mEmailsJob->fetchScope());
+    connect(mEmailsJob, SIGNAL(itemsReceived(Akonadi::Item::List)),
             this, SLOT(slotEmailsReceived(Akonadi::Item::List)));
+    connect(mEmailsJob, SIGNAL(result(KJob*)),
+            this, SLOT(slotEmailsJobResult(KJob*)));
 }
 
 void NotesRepository::monitorChanges()
@@ -117,46 +207,102 @@ void NotesRepository::monitorChanges()
     mMonitor->setCollectionMonitored(mNotesCollection);
     mMonitor->setCollectionMonitored(mEmailsCollection);
     configureItemFetchScope(mMonitor->itemFetchScope());
+    mMonitor->itemFetchScope().setCacheOnly(false); // one changed item at a time, retrieving it is fine
     connect(mMonitor, SIGNAL(itemAdded(Akonadi::Item,Akonadi::Collection)),
             this, SLOT(slotItemAdded(Akonadi::Item,Akonadi::Collection)));
+    connect(mMonitor, SIGNAL(itemChanged(Akonadi::Item,QSet<QByteArray>)),
+            this, SLOT(slotItemChanged(Akonadi::Item)));
+    connect(mMonitor, SIGNAL(itemRemoved(Akonadi::Item)),
+            this, SLOT(slotItemRemoved(Akonadi::Item)));
 }
 
-QVector<SugarEmail> NotesRepository::emailsForOpportunity(const QString &id) const
+QVector<SugarEmail> NotesRepository::emailsForOpportunity(const QString &id)
 {
-    return mEmailsHash.value(id);
+    const Akonadi::Item::List items = mEmails.items(id);
+    QVector<SugarEmail> emails;
+    emails.reserve(items.count());
+    foreach (const Akonadi::Item &item, items) {
+        const SugarEmail *email = mEmailBodies.object(item.id());
+        emails.append(email ? *email : item.payload<SugarEmail>());
+    }
+    fetchBodies(missingBodies(id));
+    return emails;
 }
 
 void NotesRepository::slotEmailsReceived(const Akonadi::Item::List &items)
 {
-    mEmailsLoaded += items.count();
+    if (sender() != mEmailsJob) {
+        return; // started before clear()
+    }
+    const bool withBody = mEmailsJob->fetchScope().fullPayload();
     foreach(const Akonadi::Item &item, items) {
-        storeEmail(item);
+        if (!withBody && !item.loadedPayloadParts().contains(PayloadBody::headerPartName())) {
+            mEmailsWithoutHeader.append(Akonadi::Item(item.id()));
+        } else {
+            storeEmail(item, withBody);
+        }
+    }
+}
+
+void NotesRepository::slotEmailsJobResult(KJob *job)
+{
+    if (job != mEmailsJob) {
+        return;
+    }
+    mEmailsJob = 0;
+    if (job->error()) {
+        kWarning() << job->errorString();
+    }
+    if (!mEmailsWithoutHeader.isEmpty()) {
+        mEmailsJob = new Akonadi::ItemFetchJob(mEmailsWithoutHeader, this);
+        configureItemFetchScope(mEmailsJob->fetchScope(), true);
+        mEmailsWithoutHeader.clear();
+        connect(mEmailsJob, SIGNAL(itemsReceived(Akonadi::Item::List)),
+                this, SLOT(slotEmailsReceived(Akonadi::Item::List)));
+        connect(mEmailsJob, SIGNAL(result(KJob*)),
+                this, SLOT(slotEmailsJobResult(KJob*)));
+        return;
     }
-    //kDebug() << "loaded" << mEmailsLoaded << "emails; now hash has" << mEmailsHash.count() << "entries";
-    if (mEmailsLoaded == mEmailsCollection.statistics().count())
-        emit emailsLoaded(mEmailsLoaded);
+    //kDebug() << "loaded" << mEmails.count() << "emails";
+    emit emailsLoaded(mEmails.count());
 }
 
-void NotesRepository::storeEmail(const Akonadi::Item &item)
+void NotesRepository::storeEmail(const Akonadi::Item &item, bool withBody)
 {
     //kDebug() << item.id() << item.mimeType() << ;
+    mEmailBodies.remove(item.id()); // outdated if the item changed
     if (item.hasPayload<SugarEmail>()) {
         SugarEmail email = item.payload<SugarEmail>();
         if (email.parentType() == QLatin1String("Opportunities")) {
-            mEmailsHash[email.parentId()].append(email);
+            if (withBody) {
+                mEmails.insert(headerItem(item, email), email.parentId());
+                mEmailBodies.insert(item.id(), new SugarEmail(email), bodyCost(email, mEmailBodies.maxCost()));
+            } else {
+                mEmails.insert(item, email.parentId());
+            }
         } else {
             // We also get emails for Accounts and Emails.
             // (well, no longer, we filter this out in the resource)
             //kDebug() << "ignoring emails for" << email.parentType();
+            mEmails.remove(item.id());
         }
     }
 }
 
-void NotesRepository::configureItemFetchScope(Akonadi::ItemFetchScope &scope)
+void NotesRepository::configureItemFetchScope(Akonadi::ItemFetchScope &scope, bool fullPayload)
 {
     scope.setFetchRemoteIdentification(false);
     scope.setIgnoreRetrievalErrors(true);
-    scope.fetchFullPayload(true);
+    if (fullPayload) {
+        scope.fetchFullPayload(true);
+    } else {
+        // The bodies are fetched on demand.
+        // Items stored before the serializer wrote the header part don't have it; asking
+        // the resource for it would be one SOAP request per item, so only the cache is
+        // used and these items are fetched again with their full payload (migration).
+        scope.fetchPayloadPart(PayloadBody::headerPartName());
+        scope.setCacheOnly(true);
+    }
 }
 
 void NotesRepository::slotItemAdded(const Akonadi::Item &item, const Akonadi::Collection &collection)
@@ -171,3 +317,166 @@ void NotesRepository::slotItemAdded(const Akonadi::Item &item, const Akonadi::Co
         return;
     }
 }
+
+void NotesRepository::slotItemChanged(const Akonadi::Item &item)
+{
+    if (item.hasPayload<SugarNote>()) {
+        storeNote(item);
+    } else if (item.hasPayload<SugarEmail>()) {
+        storeEmail(item);
+    }
+}
+
+void NotesRepository::slotItemRemoved(const Akonadi::Item &item)
+{
+    mNoteBodies.remove(item.id());
+    mEmailBodies.remove(item.id());
+    if (!mNotes.remove(item.id())) {
+        mEmails.remove(item.id());
+    }
+}
+
+int NotesRepository::countForOpportunity(const QString &id) const
+{
+    return mNotes.items(id).count() + mEmails.items(id).count();
+}
+
+bool NotesRepository::hasBodies(const QString &id) const
+{
+    return missingBodies(id).isEmpty();
+}
+
+void NotesRepository::prefetch(const QStringList &ids)
+{
+    Akonadi::Item::List items;
+    foreach (const QString &id, ids) {
+        items += missingBodies(id);
+    }
+    fetchBodies(items);
+}
+
+Akonadi::Item::List NotesRepository::missingBodies(const QString &id) const
+{
+    Akonadi::Item::List items;
+    foreach (const Akonadi::Item &item, mNotes.items(id)) {
+        if (!mNoteBodies.contains(item.id())) {
+            items.append(item);
+        }
+    }
+    foreach (const Akonadi::Item &item, mEmails.items(id)) {
+        if (!mEmailBodies.contains(item.id())) {
+            items.append(item);
+        }
+    }
+    return items;
+}
+
+void NotesRepository::fetchBodies(const Akonadi::Item::List &items)
+{
+    Akonadi::Item::List headers;
+    Akonadi::Item::List fetchedItems;
+    foreach (const Akonadi::Item &item, items) {
+        if (!mPendingBodies.contains(item.id())) {
+            mPendingBodies.insert(item.id());
+            headers.append(item);
+            fetchedItems.append(Akonadi::Item(item.id()));
+        }
+    }
+    if (fetchedItems.isEmpty()) {
+        return;
+    }
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(fetchedItems, this);
+    job->fetchScope().setFetchRemoteIdentification(false);
+    job->fetchScope().setIgnoreRetrievalErrors(true);
+    job->fetchScope().fetchFullPayload(true);
+    connect(job, SIGNAL(itemsReceived(Akonadi::Item::List)),
+            this, SLOT(slotBodiesReceived(Akonadi::Item::List)));
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotBodiesJobResult(KJob*)));
+    mBodyJobs.insert(job, headers);
+}
+
+void NotesRepository::slotBodiesReceived(const Akonadi::Item::List &items)
+{
+    if (!mBodyJobs.contains(qobject_cast<KJob *>(sender()))) {
+        return; // started before clear()
+    }
+    foreach (const Akonadi::Item &item, items) {
+        mPendingBodies.remove(item.id());
+        if (item.hasPayload<SugarNote>()) {
+            const SugarNote note = item.payload<SugarNote>();
+            mNoteBodies.insert(item.id(), new SugarNote(note), bodyCost(note, mNoteBodies.maxCost()));
+        } else if (item.hasPayload<SugarEmail>()) {
+            const SugarEmail email = item.payload<SugarEmail>();
+            mEmailBodies.insert(item.id(), new SugarEmail(email), bodyCost(email, mEmailBodies.maxCost()));
+        }
+    }
+}
+
+void NotesRepository::slotBodiesJobResult(KJob *job)
+{
+    if (!mBodyJobs.contains(job)) {
+        return;
+    }
+    if (job->error()) {
+        kWarning() << job->errorString();
+    }
+    // tell about each opportunity of the batch, even if some bodies couldn't be fetched
+    QSet<QString> opportunityIds;
+    foreach (const Akonadi::Item &header, mBodyJobs.take(job)) {
+        mPendingBodies.remove(header.id());
+        if (header.hasPayload<SugarNote>()) {
+            opportunityIds.insert(header.payload<SugarNote>().parentId());
+        } else if (header.hasPayload<SugarEmail>()) {
+            opportunityIds.insert(header.payload<SugarEmail>().parentId());
+        }
+    }
+    foreach (const QString &id, opportunityIds) {
+        emit bodiesLoaded(id);
+    }
+}
+
+void NotesRepository::ItemsIndex::insert(const Akonadi::Item &item, const QString &opportunityId)
+{
+    QHash<Akonadi::Item::Id, Location>::const_iterator it = mLocations.constFind(item.id());
+    if (it != mLocations.constEnd()) {
+        if (it->opportunityId == opportunityId) {
+            mItems[opportunityId][it->slot] = item;
+            return;
+        }
+        remove(item.id()); // moved to another opportunity
+    }
+    Akonadi::Item::List &items = mItems[opportunityId];
+    const Location location = { opportunityId, items.count() };
+    items.append(item);
+    mLocations.insert(item.id(), location);
+}
+
+bool NotesRepository::ItemsIndex::remove(Akonadi::Item::Id id)
+{
+    QHash<Akonadi::Item::Id, Location>::iterator it = mLocations.find(id);
+    if (it == mLocations.end()) {
+        return false;
+    }
+    const Location location = it.value();
+    mLocations.erase(it);
+
+    // move the last item of the opportunity into the free slot
+    QHash<QString, Akonadi::Item::List>::iterator itemsIt = mItems.find(location.opportunityId);
+    Akonadi::Item::List &items = itemsIt.value();
+    const int last = items.count() - 1;
+    if (location.slot != last) {
+        items[location.slot] = items.at(last);
+        mLocations[items.at(location.slot).id()].slot = location.slot;
+    }
+    items.removeLast();
+    if (items.isEmpty()) {
+        mItems.erase(itemsIt);
+    }
+    return true;
+}
+
+void NotesRepository::ItemsIndex::clear()
+{
+    mItems.clear();
+    mLocations.clear();
+}
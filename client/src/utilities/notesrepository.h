@@ -29,14 +29,30 @@
 #include <Akonadi/Item>
 #include <Akonadi/Collection>
 
+#include <QCache>
 #include <QObject>
+#include <QPointer>
+#include <QSet>
 
 namespace Akonadi
 {
-    class Monitor;
+    class ItemFetchJob;
     class ItemFetchScope;
+    class Monitor;
 }
-
+class KJob;
+
+/**
+ * The notes and emails attached to opportunities.
+ *
+ * Only their headers (the "HEAD" payload part, without the description) are
+ * loaded at startup, from the Akonadi cache. Items stored before that part
+ * existed are loaded with their full payload instead. The bodies are fetched on
+ * demand, and kept in a LRU cache bounded by their size.
+ *
+ * Once loaded, added, changed and removed items are applied one by one, using
+ * an index from item id to the position of the item in its opportunity.
+ */
 class NotesRepository : public QObject
 {
     Q_OBJECT
@@ -52,34 +68,84 @@ public:
     void loadEmails();
     void monitorChanges();
 
-    QVector<SugarNote> notesForOpportunity(const QString &id) const;
-    QVector<SugarEmail> emailsForOpportunity(const QString &id) const;
+    /**
+     * Returns the notes of the opportunity @p id, with their body if it is in the cache,
+     * and starts fetching the missing bodies. bodiesLoaded() is emitted once they are available.
+     * The order isn't preserved across changes, NotesDialog sorts them by date.
+     */
+    QVector<SugarNote> notesForOpportunity(const QString &id);
+    QVector<SugarEmail> emailsForOpportunity(const QString &id);
+
+    int countForOpportunity(const QString &id) const; // notes and emails, without fetching anything
+    bool hasBodies(const QString &id) const;
+
+    /**
+     * Fetches the missing bodies of the notes and emails of the opportunities @p ids in the background,
+     * e.g. of those next to the current one in a list.
+     */
+    void prefetch(const QStringList &ids);
 
 signals:
     void notesLoaded(int count);
     void emailsLoaded(int count);
+    void bodiesLoaded(const QString &opportunityId);
 
 private Q_SLOTS:
     void slotNotesReceived(const Akonadi::Item::List &items);
+    void slotNotesJobResult(KJob *job);
     void slotItemAdded(const Akonadi::Item &item, const Akonadi::Collection &collection);
+    void slotItemChanged(const Akonadi::Item &item);
+    void slotItemRemoved(const Akonadi::Item &item);
 
     void slotEmailsReceived(const Akonadi::Item::List &items);
+    void slotEmailsJobResult(KJob *job);
+
+    void slotBodiesReceived(const Akonadi::Item::List &items);
+    void slotBodiesJobResult(KJob *job);
 
 private:
-    void storeNote(const Akonadi::Item &item);
-    void storeEmail(const Akonadi::Item &item);
-    void configureItemFetchScope(Akonadi::ItemFetchScope &scope);
+    void storeNote(const Akonadi::Item &item, bool withBody = false);
+    void storeEmail(const Akonadi::Item &item, bool withBody = false);
+    void configureItemFetchScope(Akonadi::ItemFetchScope &scope, bool fullPayload = false);
+    Akonadi::Item::List missingBodies(const QString &id) const;
+    void fetchBodies(const Akonadi::Item::List &items);
+
+    // The items with a header payload by opportunity id, and where each item is in there.
+    // Removing an item moves the last one of its opportunity into its slot.
+    class ItemsIndex
+    {
+    public:
+        void insert(const Akonadi::Item &item, const QString &opportunityId); // or replace
+        bool remove(Akonadi::Item::Id id);
+        void clear();
+        int count() const { return mLocations.count(); }
+        Akonadi::Item::List items(const QString &opportunityId) const { return mItems.value(opportunityId); }
+
+    private:
+        struct Location {
+            QString opportunityId;
+            int slot;
+        };
+        QHash<QString, Akonadi::Item::List> mItems;
+        QHash<Akonadi::Item::Id, Location> mLocations;
+    };
 
-    Akonadi::Collection mNotesCollection;
     Akonadi::Monitor *mMonitor;
-    typedef QHash<QString, QVector<SugarNote> > NotesHash;
-    NotesHash mNotesHash;
-    int mNotesLoaded;
+
+    Akonadi::Collection mNotesCollection;
+    ItemsIndex mNotes;
+    QPointer<Akonadi::ItemFetchJob> mNotesJob;
+    Akonadi::Item::List mNotesWithoutHeader; // loaded again with their full payload
 
     Akonadi::Collection mEmailsCollection;
-    typedef QHash<QString, QVector<SugarEmail> > EmailsHash;
-    EmailsHash mEmailsHash;
-    int mEmailsLoaded;
+    ItemsIndex mEmails;
+    QPointer<Akonadi::ItemFetchJob> mEmailsJob;
+    Akonadi::Item::List mEmailsWithoutHeader;
+
+    QCache<Akonadi::Item::Id, SugarNote> mNoteBodies;
+    QCache<Akonadi::Item::Id, SugarEmail> mEmailBodies;
+    QSet<Akonadi::Item::Id> mPendingBodies; // being fetched
+    QHash<KJob *, Akonadi::Item::List> mBodyJobs; // the headers of the items fetched by each job
 };
 
 #endif // NOTESREPOSITORY_H
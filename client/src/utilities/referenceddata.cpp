@@ -22,43 +22,47 @@
 
 #include "referenceddata.h"
 
-#include <QVector>
+#include <QHash>
 #include <QMap>
 #include <QPair>
+#include <QStringList>
+#include <QVector>
 
-struct KeyValue
-{
-    explicit KeyValue(const QString &k = QString(), const QString &v = QString())
-        : key(k), value(v) {}
-    QString key;
-    QString value;
-    bool operator<(const KeyValue &other) const { return key < other.key; }
-    static bool lessThan(const KeyValue &first, const KeyValue &other) { return first.key < other.key; }
-};
-
+#include <algorithm>
 
-class KeyValueVector : public QVector<KeyValue>
+class ReferencedData::Private
 {
 public:
-    inline iterator binaryFind(const QString& key) {
-        return qBinaryFind(begin(), end(), KeyValue(key, QString()));
+    explicit Private(ReferencedDataType type)
+        : mType(type),
+          mKeysDirty(false),
+          mInitialLoadingDone(false)
+    {
     }
-    inline const_iterator constBinaryFind(const QString& key) const {
-        return qBinaryFind(constBegin(), constEnd(), KeyValue(key, QString()));
+
+    // Sorts the keys again if they were changed without emitting signals
+    void ensureSorted() const
+    {
+        if (mKeysDirty) {
+            mKeys = mValues.keys().toVector();
+            qSort(mKeys);
+            mKeysDirty = false;
+        }
     }
-};
 
-class ReferencedData::Private
-{
-public:
-    explicit Private(ReferencedDataType type)
-        : mType(type)
+    // The row of @p id, or the row where it would be inserted
+    int lowerBound(const QString &id) const
     {
+        ensureSorted();
+        return qLowerBound(mKeys.constBegin(), mKeys.constEnd(), id) - mKeys.constBegin();
     }
 
 public:
-    KeyValueVector mVector;
+    QHash<QString, QString> mValues; // id -> data, for lookups
+    mutable QVector<QString> mKeys; // sorted ids, the rows
     const ReferencedDataType mType;
+    mutable bool mKeysDirty;
+    bool mInitialLoadingDone;
 };
 
 
@@ -95,8 +99,11 @@ ReferencedData::~ReferencedData()
 
 void ReferencedData::clear()
 {
-    if (!d->mVector.isEmpty()) {
-        d->mVector.clear();
+    d->mInitialLoadingDone = false;
+    if (!d->mValues.isEmpty()) {
+        d->mValues.clear();
+        d->mKeys.clear();
+        d->mKeysDirty = false;
         emit cleared();
     }
 }
@@ -112,24 +119,25 @@ void ReferencedData::setReferencedData(const QString &id, const QString &data)
 
 void ReferencedData::setReferencedDataInternal(const QString &id, const QString &data, bool emitChanges)
 {
-    KeyValueVector::iterator findIt = d->mVector.binaryFind(id);
-    if (findIt != d->mVector.end()) {
-        if (data != findIt->value) {
-            findIt->value = data;
+    QHash<QString, QString>::iterator findIt = d->mValues.find(id);
+    if (findIt != d->mValues.end()) {
+        if (data != findIt.value()) {
+            findIt.value() = data;
             if (emitChanges) {
-                emit dataChanged(findIt - d->mVector.begin());
+                emit dataChanged(d->lowerBound(id));
             }
         }
+    } else if (emitChanges) {
+        const int row = d->lowerBound(id);
+        emit rowsAboutToBeInserted(row, row);
+        d->mValues.insert(id, data);
+        d->mKeys.insert(row, id);
+        emit rowsInserted();
+        emit idsInserted(QStringList() << id);
     } else {
-        findIt = qLowerBound(d->mVector.begin(), d->mVector.end(), KeyValue(id), KeyValue::lessThan);
-        const int row = findIt - d->mVector.begin();
-        if (emitChanges) {
-            emit rowsAboutToBeInserted(row, row);
-        }
-        d->mVector.insert(findIt, KeyValue(id, data));
-        if (emitChanges) {
-            emit rowsInserted();
-        }
+        // nobody is listening, sort the rows later
+        d->mValues.insert(id, data);
+        d->mKeysDirty = true;
     }
 }
 
@@ -137,64 +145,126 @@ void ReferencedData::addMap(const QMap<QString, QString> &idDataMap, bool emitCh
 {
     QMap<QString, QString>::const_iterator it = idDataMap.constBegin();
     const QMap<QString, QString>::const_iterator end = idDataMap.constEnd();
-    if (d->mVector.isEmpty()) {
-        d->mVector.reserve(idDataMap.count());
-        // The vector is currently empty -> fast path
-        // The map is already sorted, we can just copy right away
-        // and emit the signals only once, which is the whole point of this method.
-        if (emitChanges) {
-            emit rowsAboutToBeInserted(0, idDataMap.count() - 1);
-        }
+    if (!emitChanges) {
+        d->mValues.reserve(d->mValues.count() + idDataMap.count());
         for ( ; it != end ; ++it) {
-            d->mVector.append(KeyValue(it.key(), it.value()));
+            setReferencedDataInternal(it.key(), it.value(), false);
         }
-        if (emitChanges) {
-            emit rowsInserted();
+        return;
+    }
+
+    // Update the existing ids, and collect the new ones (sorted, since the map is)
+    QStringList newIds;
+    for ( ; it != end ; ++it) {
+        if (d->mValues.contains(it.key())) {
+            setReferencedDataInternal(it.key(), it.value(), true);
+        } else {
+            newIds.append(it.key());
         }
-    } else {
-        // Append to existing data -> slower code path
-        for ( ; it != end ; ++it) {
-            setReferencedDataInternal(it.key(), it.value(), emitChanges);
+    }
+
+    // Insert the new ids in runs of consecutive rows, with one pair of signals per run,
+    // which is a single run when loading into an empty list
+    d->ensureSorted();
+    int first = 0;
+    while (first < newIds.count()) {
+        const int row = d->lowerBound(newIds.at(first));
+        int last = first + 1;
+        while (last < newIds.count() && (row == d->mKeys.count() || newIds.at(last) < d->mKeys.at(row))) {
+            ++last;
+        }
+        emit rowsAboutToBeInserted(row, row + last - first - 1);
+        d->mKeys.insert(row, last - first, QString());
+        for (int i = first; i < last; ++i) {
+            const QString &id = newIds.at(i);
+            d->mKeys[row + i - first] = id;
+            d->mValues.insert(id, idDataMap.value(id));
         }
+        emit rowsInserted();
+        first = last;
+    }
+    if (!newIds.isEmpty()) {
+        emit idsInserted(newIds);
     }
 }
 
 QString ReferencedData::referencedData(const QString &id) const
 {
-    KeyValueVector::const_iterator findIt = d->mVector.constBinaryFind(id);
-    if (findIt != d->mVector.constEnd()) {
-        return findIt->value;
-    }
-    return QString();
+    return d->mValues.value(id);
 }
 
 void ReferencedData::removeReferencedData(const QString &id, bool emitChanges)
 {
-    KeyValueVector::iterator findIt = d->mVector.binaryFind(id);
-    if (findIt != d->mVector.end()) {
-        const int row = findIt - d->mVector.begin();
-        if (emitChanges) {
-            emit rowsAboutToBeRemoved(row, row);
+    removeReferencedData(QStringList() << id, emitChanges);
+}
+
+void ReferencedData::removeReferencedData(const QStringList &ids, bool emitChanges)
+{
+    if (!emitChanges) {
+        foreach (const QString &id, ids) {
+            if (d->mValues.remove(id)) {
+                d->mKeysDirty = true;
+            }
         }
-        d->mVector.remove(row);
-        if (emitChanges) {
-            emit rowsRemoved();
+        return;
+    }
+
+    QVector<int> rows;
+    rows.reserve(ids.count());
+    QStringList removedIds;
+    foreach (const QString &id, ids) {
+        if (d->mValues.contains(id)) {
+            rows.append(d->lowerBound(id));
+            removedIds.append(id);
         }
     }
+    qSort(rows);
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // Remove runs of consecutive rows, from the bottom so that the other rows don't move
+    int last = rows.count() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && rows.at(first - 1) == rows.at(first) - 1) {
+            --first;
+        }
+        const int startRow = rows.at(first);
+        const int count = last - first + 1;
+        emit rowsAboutToBeRemoved(startRow, startRow + count - 1);
+        for (int row = startRow; row < startRow + count; ++row) {
+            d->mValues.remove(d->mKeys.at(row));
+        }
+        d->mKeys.remove(startRow, count);
+        emit rowsRemoved();
+        last = first - 1;
+    }
+    if (!removedIds.isEmpty()) {
+        removedIds.removeDuplicates();
+        emit idsRemoved(removedIds);
+    }
 }
 
 QPair<QString, QString> ReferencedData::data(int row) const
 {
-    if (row >= 0 && row < d->mVector.count()) {
-        const KeyValue &it = d->mVector.at(row);
-        return qMakePair(it.key, it.value);
+    d->ensureSorted();
+    if (row >= 0 && row < d->mKeys.count()) {
+        const QString &key = d->mKeys.at(row);
+        return qMakePair(key, d->mValues.value(key));
     }
     return qMakePair(QString(), QString());
 }
 
 int ReferencedData::count() const
 {
-    return d->mVector.count();
+    return d->mValues.count();
+}
+
+int ReferencedData::indexOf(const QString &id) const
+{
+    if (!d->mValues.contains(id)) {
+        return -1;
+    }
+    return d->lowerBound(id);
 }
 
 ReferencedDataType ReferencedData::dataType() const
@@ -205,15 +275,17 @@ ReferencedDataType ReferencedData::dataType() const
 void ReferencedData::emitInitialLoadingDoneForAll()
 {
     foreach(ReferencedData *data, s_instances()->map) {
-        if (data->dataType() != AccountCountryRef) { // that one was already done earlier
-            emit data->initialLoadingDone();
-        }
+        data->emitInitialLoadingDone();
     }
 }
 
 void ReferencedData::emitInitialLoadingDone()
 {
-    emit initialLoadingDone();
+    // some types are done earlier than others, only emit once per loading
+    if (!d->mInitialLoadingDone) {
+        d->mInitialLoadingDone = true;
+        emit initialLoadingDone();
+    }
 }
 
 ReferencedData::ReferencedData(ReferencedDataType type, QObject *parent)
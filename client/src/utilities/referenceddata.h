@@ -29,12 +29,17 @@
 
 template <typename K, typename V> struct QPair;
 template <typename K, typename V> class QMap;
+class QStringList;
 
 /**
  * @brief Per-type singleton holding all reference data, for comboboxes
  * (accounts list, assigned-to list, etc.)
  *
  * Used with a ReferencedDataModel on top.
+ *
+ * Lookups by id go through a hash. The rows are the ids in sorted order;
+ * changes made without emitting signals only mark them as unsorted, they
+ * are sorted again on the next access by row.
  */
 class ReferencedData : public QObject
 {
@@ -51,11 +56,13 @@ public:
     void setReferencedData(const QString &id, const QString &data);
     void addMap(const QMap<QString, QString> &idDataMap, bool emitChanges);
     void removeReferencedData(const QString &id, bool emitChanges);
+    void removeReferencedData(const QStringList &ids, bool emitChanges);
 
     QString referencedData(const QString &id) const;
 
     QPair<QString, QString> data(int row) const;
     int count() const;
+    int indexOf(const QString &id) const; // the row of @p id, or -1
 
 
     ReferencedDataType dataType() const;
@@ -70,6 +77,9 @@ Q_SIGNALS:
     void rowsInserted();
     void rowsAboutToBeRemoved(int start, int end);
     void rowsRemoved();
+    // emitted after the row signals, with all the ids added or removed by one call
+    void idsInserted(const QStringList &ids);
+    void idsRemoved(const QStringList &ids);
     void cleared();
 
     void initialLoadingDone();
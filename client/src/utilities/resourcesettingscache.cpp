@@ -0,0 +1,90 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "resourcesettingscache.h"
+#include "sugarresourcesettings.h"
+
+#include <KDebug>
+
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+ResourceSettingsCache *ResourceSettingsCache::instance()
+{
+    static ResourceSettingsCache cache;
+    return &cache;
+}
+
+ResourceSettingsCache::ResourceSettingsCache()
+    : QObject(),
+      mWatcher(0)
+{
+}
+
+void ResourceSettingsCache::setResource(const QByteArray &identifier)
+{
+    if (identifier == mResourceIdentifier && (mWatcher || !mBaseUrl.isEmpty())) {
+        return;
+    }
+    mResourceIdentifier = identifier;
+    setBaseUrl(QString()); // the one of the previous resource
+    refresh();
+}
+
+void ResourceSettingsCache::refresh()
+{
+    delete mWatcher; // outdated
+    mWatcher = 0;
+    if (mResourceIdentifier.isEmpty()) {
+        return;
+    }
+    OrgKdeAkonadiSugarCRMSettingsInterface iface(
+                QLatin1String("org.freedesktop.Akonadi.Resource.") + mResourceIdentifier, QLatin1String("/Settings"), QDBusConnection::sessionBus() );
+    mWatcher = new QDBusPendingCallWatcher(iface.host(), this);
+    connect(mWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(slotHostReceived(QDBusPendingCallWatcher*)));
+}
+
+void ResourceSettingsCache::slotHostReceived(QDBusPendingCallWatcher *watcher)
+{
+    watcher->deleteLater();
+    if (watcher != mWatcher) {
+        return;
+    }
+    mWatcher = 0;
+    const QDBusPendingReply<QString> reply = *watcher;
+    if (reply.isValid()) {
+        setBaseUrl(reply.value());
+    } else {
+        kDebug() << "Cannot read the settings of" << mResourceIdentifier << reply.error().message();
+    }
+}
+
+void ResourceSettingsCache::setBaseUrl(const QString &baseUrl)
+{
+    if (baseUrl != mBaseUrl) {
+        mBaseUrl = baseUrl;
+        emit baseUrlChanged(mBaseUrl);
+    }
+}
+
+#include "resourcesettingscache.moc"
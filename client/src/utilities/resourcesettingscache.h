@@ -0,0 +1,76 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RESOURCESETTINGSCACHE_H
+#define RESOURCESETTINGSCACHE_H
+
+#include <QObject>
+
+class QDBusPendingCallWatcher;
+
+/**
+ * The settings of the selected resource which are needed by the GUI
+ * (currently the base URL of the web interface, for links).
+ *
+ * They are fetched asynchronously over D-Bus once per resource selection
+ * and shared by all pages and details widgets, which get notified when
+ * they change.
+ */
+class ResourceSettingsCache : public QObject
+{
+    Q_OBJECT
+public:
+    static ResourceSettingsCache *instance();
+
+    /**
+     * Fetches the settings of the resource @p identifier, unless already known
+     */
+    void setResource(const QByteArray &identifier);
+
+    /**
+     * Fetches the settings again, e.g. when the resource goes online
+     */
+    void refresh();
+
+    QByteArray resourceIdentifier() const { return mResourceIdentifier; }
+
+    /**
+     * Returns the base URL of the web interface, or an empty string if not known (yet)
+     */
+    QString baseUrl() const { return mBaseUrl; }
+
+Q_SIGNALS:
+    void baseUrlChanged(const QString &baseUrl);
+
+private Q_SLOTS:
+    void slotHostReceived(QDBusPendingCallWatcher *watcher);
+
+private:
+    ResourceSettingsCache();
+    void setBaseUrl(const QString &baseUrl);
+
+    QByteArray mResourceIdentifier;
+    QString mBaseUrl;
+    QDBusPendingCallWatcher *mWatcher; // the running fetch
+};
+
+#endif // RESOURCESETTINGSCACHE_H
@@ -0,0 +1,103 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startupscheduler.h"
+
+StartupScheduler::StartupScheduler(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void StartupScheduler::start(Tasks tasks)
+{
+    mTasks = tasks;
+    mDone = 0;
+    mContinuations.clear();
+    mTimer.start();
+}
+
+void StartupScheduler::whenDone(Tasks dependencies, QObject *receiver, const char *member)
+{
+    if (isDone(dependencies)) {
+        QMetaObject::invokeMethod(receiver, member);
+        return;
+    }
+    Continuation continuation;
+    continuation.dependencies = dependencies;
+    continuation.receiver = receiver;
+    continuation.member = member;
+    mContinuations.append(continuation);
+}
+
+void StartupScheduler::setDone(Tasks tasks)
+{
+    tasks &= mTasks & ~mDone;
+    if (!tasks) {
+        return;
+    }
+    mDone |= tasks;
+    emit progress(taskCount(mDone), taskCount(mTasks));
+
+    // take the ready ones out first, they might register more work
+    QList<Continuation> ready;
+    for (int i = 0; i < mContinuations.count(); ) {
+        if (isDone(mContinuations.at(i).dependencies)) {
+            ready.append(mContinuations.takeAt(i));
+        } else {
+            ++i;
+        }
+    }
+    foreach (const Continuation &continuation, ready) {
+        if (continuation.receiver) {
+            QMetaObject::invokeMethod(continuation.receiver, continuation.member.constData());
+        }
+    }
+
+    if (mDone == mTasks) {
+        emit finished(mTimer.elapsed());
+    }
+}
+
+StartupScheduler::Tasks StartupScheduler::taskForType(DetailsType type)
+{
+    switch (type) {
+    case Account:
+        return Accounts;
+    case Opportunity:
+        return Opportunities;
+    case Contact:
+        return Contacts;
+    case Lead:
+    case Campaign:
+        break; // currently unused
+    }
+    return 0;
+}
+
+int StartupScheduler::taskCount(Tasks tasks)
+{
+    int count = 0;
+    for (int bits = tasks; bits; bits &= bits - 1) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,95 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUPSCHEDULER_H
+#define STARTUPSCHEDULER_H
+
+#include "enums.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+/**
+ * Tracks the initial loading of the models after selecting a resource.
+ *
+ * All collections are loaded at the same time; only the work that needs
+ * data from other models (e.g. resolving account names in opportunities)
+ * is registered with whenDone() and runs once those models are loaded.
+ */
+class StartupScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Task {
+        Accounts = 0x01,
+        Opportunities = 0x02,
+        Contacts = 0x04,
+        Notes = 0x08,
+        Emails = 0x10
+    };
+    Q_DECLARE_FLAGS(Tasks, Task)
+
+    explicit StartupScheduler(QObject *parent = 0);
+
+    /**
+     * Starts (or restarts) loading @p tasks, forgetting the pending work.
+     */
+    void start(Tasks tasks);
+
+    /**
+     * Calls the slot @p member of @p receiver once all @p dependencies are done,
+     * immediately if they already are.
+     */
+    void whenDone(Tasks dependencies, QObject *receiver, const char *member);
+
+    void setDone(Tasks tasks);
+
+    Tasks pendingTasks() const { return mTasks & ~mDone; }
+    bool isDone(Tasks tasks) const { return (mDone & tasks & mTasks) == (tasks & mTasks); }
+
+    static Tasks taskForType(DetailsType type);
+
+Q_SIGNALS:
+    void progress(int done, int total);
+    void finished(qint64 msecs);
+
+private:
+    struct Continuation
+    {
+        Tasks dependencies;
+        QPointer<QObject> receiver;
+        QByteArray member;
+    };
+
+    static int taskCount(Tasks tasks);
+
+    Tasks mTasks;
+    Tasks mDone;
+    QList<Continuation> mContinuations;
+    QElapsedTimer mTimer;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(StartupScheduler::Tasks)
+
+#endif
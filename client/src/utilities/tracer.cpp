@@ -0,0 +1,187 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tracer.h"
+
+#include <KDebug>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QThread>
+
+static const int s_defaultCapacity = 20000;
+
+QAtomicInt Tracer::s_enabled(0);
+
+Tracer::Tracer()
+    : mNext(0),
+      mCount(0)
+{
+    mClock.start();
+    mEvents.resize(s_defaultCapacity);
+}
+
+Tracer *Tracer::instance()
+{
+    static Tracer *s_instance = 0;
+    if (!s_instance) {
+        // from main(), before any other thread could call this
+        s_instance = new Tracer;
+        if (!qgetenv("FATCRM_TRACE").isEmpty()) {
+            s_instance->setEnabled(true);
+        }
+    }
+    return s_instance;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    s_enabled = enabled ? 1 : 0;
+}
+
+void Tracer::addEvent(const char *name, const char *category, qint64 start, const QString &detail)
+{
+    if (start == -1) {
+        return;
+    }
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.detail = detail;
+    event.start = start;
+    event.duration = now() - start;
+    event.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    QMutexLocker locker(&mMutex);
+    mEvents[mNext] = event;
+    mNext = (mNext + 1) % mEvents.count();
+    mCount = qMin(mCount + 1, mEvents.count());
+}
+
+void Tracer::setCapacity(int capacity)
+{
+    Q_ASSERT(capacity > 0);
+    const QVector<Event> previous = events();
+    QMutexLocker locker(&mMutex);
+    mEvents = QVector<Event>(capacity);
+    mCount = qMin(previous.count(), capacity);
+    // keep the most recent events
+    for (int i = 0; i < mCount; ++i) {
+        mEvents[i] = previous.at(previous.count() - mCount + i);
+    }
+    mNext = mCount % capacity;
+}
+
+int Tracer::capacity() const
+{
+    QMutexLocker locker(&mMutex);
+    return mEvents.count();
+}
+
+QVector<Tracer::Event> Tracer::events() const
+{
+    QMutexLocker locker(&mMutex);
+    QVector<Event> result;
+    result.reserve(mCount);
+    const int first = (mNext - mCount + mEvents.count()) % mEvents.count();
+    for (int i = 0; i < mCount; ++i) {
+        result.append(mEvents.at((first + i) % mEvents.count()));
+    }
+    return result;
+}
+
+int Tracer::eventCount() const
+{
+    QMutexLocker locker(&mMutex);
+    return mCount;
+}
+
+void Tracer::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mEvents = QVector<Event>(mEvents.count());
+    mNext = 0;
+    mCount = 0;
+}
+
+static QByteArray jsonString(const QString &str)
+{
+    QByteArray result;
+    result.reserve(str.size() + 2);
+    result += '"';
+    foreach (const QChar ch, str) {
+        const ushort c = ch.unicode();
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += char(c);
+        } else if (c < 0x20 || c > 0x7e) {
+            result += "\\u" + QByteArray::number(c, 16).rightJustified(4, '0');
+        } else {
+            result += char(c);
+        }
+    }
+    result += '"';
+    return result;
+}
+
+QByteArray Tracer::toChromeTrace() const
+{
+    const QVector<Event> allEvents = events();
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QHash<quintptr, int> threadNumbers; // small numbers are easier to read than thread handles
+
+    QByteArray json = "{\"traceEvents\":[";
+    for (int i = 0; i < allEvents.count(); ++i) {
+        const Event &event = allEvents.at(i);
+        QHash<quintptr, int>::const_iterator it = threadNumbers.constFind(event.thread);
+        if (it == threadNumbers.constEnd()) {
+            it = threadNumbers.insert(event.thread, threadNumbers.count() + 1);
+        }
+        if (i > 0) {
+            json += ",\n";
+        }
+        json += "{\"name\":" + jsonString(QString::fromLatin1(event.name));
+        json += ",\"cat\":" + jsonString(QString::fromLatin1(event.category));
+        json += ",\"ph\":\"X\",\"ts\":" + QByteArray::number(event.start);
+        json += ",\"dur\":" + QByteArray::number(event.duration);
+        json += ",\"pid\":" + pid;
+        json += ",\"tid\":" + QByteArray::number(it.value());
+        if (!event.detail.isEmpty()) {
+            json += ",\"args\":{\"detail\":" + jsonString(event.detail) + '}';
+        }
+        json += '}';
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+bool Tracer::exportChromeTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        kWarning() << "Cannot write" << fileName << file.errorString();
+        return false;
+    }
+    return file.write(toChromeTrace()) != -1;
+}
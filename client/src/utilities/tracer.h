@@ -0,0 +1,137 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/**
+ * Records timed events for diagnosing slow startup and interactions.
+ *
+ * Events are kept in a fixed size ring buffer, so that only the most recent
+ * ones are kept, and can be exported in the Chrome trace event format
+ * (to be opened in chrome://tracing).
+ *
+ * Recording is disabled by default (set FATCRM_TRACE in the environment to
+ * trace the startup), and costs a single test when disabled.
+ * Events can be added from any thread.
+ */
+class Tracer
+{
+public:
+    struct Event
+    {
+        const char *name; // string literals, not copied
+        const char *category;
+        QString detail;
+        qint64 start; // in microseconds since the tracer was created
+        qint64 duration;
+        quintptr thread;
+    };
+
+    static Tracer *instance();
+
+    static bool isEnabled() { return s_enabled; }
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns the current time for a later addEvent(), or -1 if disabled.
+     */
+    static qint64 timestamp() { return isEnabled() ? instance()->now() : -1; }
+
+    /**
+     * Records an event which started at @p start (from timestamp()) and ends now.
+     * Does nothing if @p start is -1, i.e. tracing was disabled then.
+     */
+    void addEvent(const char *name, const char *category, qint64 start, const QString &detail = QString());
+
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    /**
+     * Returns the recorded events, oldest first
+     */
+    QVector<Event> events() const;
+    int eventCount() const;
+    void clear();
+
+    QByteArray toChromeTrace() const;
+    bool exportChromeTrace(const QString &fileName) const;
+
+private:
+    Tracer();
+    qint64 now() const { return mClock.nsecsElapsed() / 1000; }
+
+    static QAtomicInt s_enabled;
+
+    QElapsedTimer mClock;
+    mutable QMutex mMutex;
+    QVector<Event> mEvents; // ring buffer
+    int mNext; // where the next event goes
+    int mCount;
+};
+
+/**
+ * Records an event for the lifetime of the object, if tracing is enabled.
+ *
+ * @code
+ * TraceScope trace("FilterProxyModel::refilter", "filter");
+ * @endcode
+ */
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category)
+        : mName(name), mCategory(category), mStart(Tracer::timestamp())
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (mStart != -1) {
+            Tracer::instance()->addEvent(mName, mCategory, mStart, mDetail);
+        }
+    }
+
+    bool isActive() const { return mStart != -1; }
+
+    /**
+     * Sets a text shown with the event, e.g. the number of rows.
+     * Only call this if isActive(), to avoid creating the string for nothing.
+     */
+    void setDetail(const QString &detail) { mDetail = detail; }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char *mName;
+    const char *mCategory;
+    qint64 mStart;
+    QString mDetail;
+};
+
+#endif
@@ -30,8 +30,7 @@
 #include <QMenu>
 
 ItemsTreeView::ItemsTreeView(QWidget *parent) :
-    Akonadi::EntityTreeView(parent),
-    mItemsTreeModel(0)
+    Akonadi::EntityTreeView(parent)
 {
     setRootIsDecorated(false);
     header()->setResizeMode(QHeaderView::ResizeToContents);
@@ -46,20 +45,20 @@ void ItemsTreeView::setViewName(const QString &name)
     setObjectName(name);
 }
 
-void ItemsTreeView::setModels(QAbstractItemModel *model, ItemsTreeModel *sourceModel, const ItemsTreeModel::ColumnTypes &defaultColumns)
+void ItemsTreeView::setModels(QAbstractItemModel *model, const ItemsTreeModel::ColumnTypes &columns, const ItemsTreeModel::ColumnTypes &defaultColumns)
 {
+    mColumns = columns;
     setModel(model);
-    mItemsTreeModel = sourceModel;
 
     QStringList defaultColumnNames;
     foreach(ItemsTreeModel::ColumnType ct, defaultColumns)
         defaultColumnNames.append(ItemsTreeModel::columnNameFromType(ct));
 
-    const QStringList columns = ClientSettings::self()->visibleColumns(objectName(), defaultColumnNames);
-    //kDebug() << "wanted columns:" << columns;
+    const QStringList visibleColumns = ClientSettings::self()->visibleColumns(objectName(), defaultColumnNames);
+    //kDebug() << "wanted columns:" << visibleColumns;
     for (int i = 0; i < header()->count(); ++i) {
-        const QString name = mItemsTreeModel->columnName(i);
-        header()->setSectionHidden(i, !columns.contains(name));
+        const QString name = ItemsTreeModel::columnNameFromType(mColumns.at(i));
+        header()->setSectionHidden(i, !visibleColumns.contains(name));
     }
 }
 
@@ -91,7 +90,7 @@ void ItemsTreeView::slotHeaderContextMenu(const QPoint &point)
         menu.addAction(showHideAction);
     }
 
-    const ItemsTreeModel::ColumnType columnType = mItemsTreeModel->columnTypes().at(section);
+    const ItemsTreeModel::ColumnType columnType = mColumns.at(section);
     switch (columnType) {
     case ItemsTreeModel::NextStepDate:
     case ItemsTreeModel::CreationDate:
@@ -119,7 +118,7 @@ void ItemsTreeView::saveVisibleColumns()
     QStringList columns;
     for (int i = 0; i < header()->count(); ++i) {
         if (!header()->isSectionHidden(i)) {
-            const QString name = mItemsTreeModel->columnName(i);
+            const QString name = ItemsTreeModel::columnNameFromType(mColumns.at(i));
             columns.append(name);
         }
     }
@@ -34,7 +34,8 @@ public:
 
     void setViewName(const QString &name);
 
-    void setModels(QAbstractItemModel *model, ItemsTreeModel *sourceModel, const ItemsTreeModel::ColumnTypes &defaultColumns);
+    // @p columns are the columns of @p model, e.g. ItemsTreeModel::columnTypes()
+    void setModels(QAbstractItemModel *model, const ItemsTreeModel::ColumnTypes &columns, const ItemsTreeModel::ColumnTypes &defaultColumns);
 
 signals:
     void returnPressed(const Akonadi::Item &item);
@@ -50,7 +51,7 @@ private slots:
 private:
     void saveVisibleColumns();
 
-    ItemsTreeModel* mItemsTreeModel;
+    ItemsTreeModel::ColumnTypes mColumns;
 };
 
 #endif // ITEMSTREEVIEW_H
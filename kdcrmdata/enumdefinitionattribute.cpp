@@ -30,14 +30,24 @@ EnumDefinitionAttribute::EnumDefinitionAttribute()
 {
 }
 
+void EnumDefinitionAttribute::setDefinitions(const EnumDefinitions &definitions)
+{
+    mDefinitions = definitions;
+}
+
+EnumDefinitions EnumDefinitionAttribute::definitions() const
+{
+    return mDefinitions;
+}
+
 void EnumDefinitionAttribute::setValue(const QString &value)
 {
-    mValue = value;
+    mDefinitions = EnumDefinitions::fromString(value);
 }
 
 QString EnumDefinitionAttribute::value() const
 {
-    return mValue;
+    return mDefinitions.toString();
 }
 
 QByteArray EnumDefinitionAttribute::type() const
@@ -48,17 +58,20 @@ QByteArray EnumDefinitionAttribute::type() const
 Akonadi::Attribute *EnumDefinitionAttribute::clone() const
 {
     EnumDefinitionAttribute *attr = new EnumDefinitionAttribute;
-    attr->setValue(mValue);
+    attr->setDefinitions(mDefinitions);
     return attr;
 }
 
 QByteArray EnumDefinitionAttribute::serialized() const
 {
-    const QByteArray result = mValue.toUtf8();
-    return result;
+    return mDefinitions.toByteArray();
 }
 
 void EnumDefinitionAttribute::deserialize(const QByteArray &data)
 {
-    mValue = QString::fromUtf8(data);
+    if (EnumDefinitions::isByteArrayFormat(data)) {
+        mDefinitions = EnumDefinitions::fromByteArray(data);
+    } else { // written by an older resource
+        mDefinitions = EnumDefinitions::fromString(QString::fromUtf8(data));
+    }
 }
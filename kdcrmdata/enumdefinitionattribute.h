@@ -23,6 +23,8 @@
 #ifndef ENUMDEFINITIONATTRIBUTE_H
 #define ENUMDEFINITIONATTRIBUTE_H
 
+#include "enumdefinitions.h"
+
 #include <Akonadi/Attribute>
 #include <QMap>
 #include <QString>
@@ -33,6 +35,9 @@ namespace Akonadi {
 
 /**
  * An attribute for letting the resource store the definition of enums, that FatCRM can use.
+ *
+ * The definitions are parsed once when the attribute is deserialized, and shared
+ * (implicitly) by all the copies of the collection and by the users of definitions().
  */
 class AKONADI_EXPORT EnumDefinitionAttribute : public Akonadi::Attribute
 {
@@ -43,6 +48,10 @@ public:
     // to reuse the attribute class, but AttributeFactory::registerAttribute expects
     // a default ctor and a constant type()....
 
+    void setDefinitions(const EnumDefinitions &definitions);
+    EnumDefinitions definitions() const;
+
+    // compat API, using EnumDefinitions::toString() format
     void setValue(const QString &value);
     QString value() const;
 
@@ -52,7 +61,7 @@ public:
     void deserialize(const QByteArray &data) Q_DECL_OVERRIDE;
 
 private:
-    QString mValue;
+    EnumDefinitions mDefinitions;
 };
 
 #endif
@@ -20,7 +20,17 @@
 
 #include "enumdefinitions.h"
 
-#include <QStringList>
+#include <QHash>
+#include <QSharedData>
+
+#include <vector>
+
+class EnumDefinitions::Private : public QSharedData
+{
+public:
+    std::vector<Enum> mDefinitions;
+    QHash<QString, int> mIndexByName; // first definition with a given name
+};
 
 QString EnumDefinitions::Enum::toString() const
 {
@@ -36,48 +46,81 @@ QString EnumDefinitions::Enum::toString() const
     return ret;
 }
 
-EnumDefinitions::Enum EnumDefinitions::Enum::fromString(const QString &str)
+// Parses one enum in str, from pos to end (exclusive)
+static EnumDefinitions::Enum parseEnum(const QString &str, int pos, int end)
 {
-    const int nameSep = str.indexOf('|');
-    Q_ASSERT(nameSep > -1);
-    Enum ret(str.left(nameSep));
-    int pos = nameSep + 1;
-    while (pos < str.length()) {
+    const int nameSep = str.indexOf('|', pos);
+    Q_ASSERT(nameSep > -1 && nameSep < end);
+    EnumDefinitions::Enum ret(str.mid(pos, nameSep - pos));
+    pos = nameSep + 1;
+    while (pos < end) {
         const int sep = str.indexOf(':', pos);
         Q_ASSERT(sep > -1);
-        const int end = str.indexOf('|', sep + 1);
-        Q_ASSERT(end > -1);
+        const int valueEnd = str.indexOf('|', sep + 1);
+        Q_ASSERT(valueEnd > -1);
         const QString key = str.mid(pos, sep - pos);
-        const QString value = str.mid(sep + 1, end - sep - 1);
+        const QString value = str.mid(sep + 1, valueEnd - sep - 1);
         ret.mEnumValues.insert(key, value);
-        pos = end + 1;
+        pos = valueEnd + 1;
     }
-
     return ret;
 }
 
+EnumDefinitions::Enum EnumDefinitions::Enum::fromString(const QString &str)
+{
+    return parseEnum(str, 0, str.length());
+}
 
 EnumDefinitions::EnumDefinitions()
+    : d(new Private)
 {
 }
 
-int EnumDefinitions::indexOf(const QString &enumName) const
+EnumDefinitions::EnumDefinitions(const EnumDefinitions &other)
+    : d(other.d)
 {
-    for (size_t i = 0; i < mDefinitions.size(); ++i) {
-        if (mDefinitions.at(i).mEnumName == enumName) {
-            return i;
-        }
+}
+
+EnumDefinitions::~EnumDefinitions()
+{
+}
+
+EnumDefinitions &EnumDefinitions::operator=(const EnumDefinitions &other)
+{
+    d = other.d;
+    return *this;
+}
+
+void EnumDefinitions::append(const Enum &e)
+{
+    if (!d->mIndexByName.contains(e.mEnumName)) {
+        d->mIndexByName.insert(e.mEnumName, d->mDefinitions.size());
     }
-    return -1;
+    d->mDefinitions.push_back(e);
+}
+
+int EnumDefinitions::count() const
+{
+    return d->mDefinitions.size();
+}
+
+const EnumDefinitions::Enum &EnumDefinitions::at(int i) const
+{
+    return d->mDefinitions.at(i);
+}
+
+int EnumDefinitions::indexOf(const QString &enumName) const
+{
+    return d->mIndexByName.value(enumName, -1);
 }
 
 // E.g. "lead_source|Key1:Value1|Key2:Value2|Key3:Value3|%another_enum|K:V"
 QString EnumDefinitions::toString() const
 {
     QString ret;
-    for (size_t i = 0; i < mDefinitions.size(); ++i) {
-        ret += mDefinitions.at(i).toString();
-        if (i + 1 < mDefinitions.size()) {
+    for (size_t i = 0; i < d->mDefinitions.size(); ++i) {
+        ret += d->mDefinitions.at(i).toString();
+        if (i + 1 < d->mDefinitions.size()) {
             ret += '%';
         }
     }
@@ -87,10 +130,116 @@ QString EnumDefinitions::toString() const
 EnumDefinitions EnumDefinitions::fromString(const QString &str)
 {
     EnumDefinitions ret;
-    // a bit slow but I'm lazy
-    foreach (const QString &s, str.split('%', QString::SkipEmptyParts)) {
-        ret.append(EnumDefinitions::Enum::fromString(s));
+    int pos = 0;
+    while (pos < str.length()) {
+        int end = str.indexOf('%', pos);
+        if (end == -1) {
+            end = str.length();
+        }
+        if (end > pos) {
+            ret.append(parseEnum(str, pos, end));
+        }
+        pos = end + 1;
+    }
+
+    return ret;
+}
+
+// Compact format: a marker (a leading NUL byte, which the text format can't start with),
+// then the number of enums, and for each enum its name, its number of values and the values.
+// Numbers are variable-length encoded (7 bits per byte), strings are UTF-8 prefixed with their length.
+
+static const char s_byteArrayMarker[] = { '\0', 'E', 'D', '2' };
+
+static void writeNumber(QByteArray &out, quint32 number)
+{
+    while (number >= 0x80) {
+        out += char((number & 0x7f) | 0x80);
+        number >>= 7;
+    }
+    out += char(number);
+}
+
+static void writeString(QByteArray &out, const QString &str)
+{
+    const QByteArray utf8 = str.toUtf8();
+    writeNumber(out, utf8.size());
+    out += utf8;
+}
+
+static bool readNumber(const char *&p, const char *end, quint32 *number)
+{
+    *number = 0;
+    for (int shift = 0; p != end && shift < 32; shift += 7) {
+        const uchar byte = *p++;
+        *number |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool readString(const char *&p, const char *end, QString *str)
+{
+    quint32 length;
+    if (!readNumber(p, end, &length) || length > quint32(end - p)) {
+        return false;
     }
+    *str = QString::fromUtf8(p, length);
+    p += length;
+    return true;
+}
+
+QByteArray EnumDefinitions::toByteArray() const
+{
+    QByteArray ret(s_byteArrayMarker, sizeof(s_byteArrayMarker));
+    writeNumber(ret, d->mDefinitions.size());
+    for (size_t i = 0; i < d->mDefinitions.size(); ++i) {
+        const Enum &e = d->mDefinitions.at(i);
+        writeString(ret, e.mEnumName);
+        writeNumber(ret, e.mEnumValues.size());
+        for (Enum::Map::const_iterator it = e.mEnumValues.constBegin(); it != e.mEnumValues.constEnd(); ++it) {
+            writeString(ret, it.key());
+            writeString(ret, it.value());
+        }
+    }
+    return ret;
+}
+
+bool EnumDefinitions::isByteArrayFormat(const QByteArray &data)
+{
+    return data.startsWith(QByteArray::fromRawData(s_byteArrayMarker, sizeof(s_byteArrayMarker)));
+}
 
+EnumDefinitions EnumDefinitions::fromByteArray(const QByteArray &data)
+{
+    EnumDefinitions ret;
+    if (!isByteArrayFormat(data)) {
+        return ret;
+    }
+    const char *p = data.constData() + sizeof(s_byteArrayMarker);
+    const char *end = data.constData() + data.size();
+    quint32 enumCount;
+    if (!readNumber(p, end, &enumCount)) {
+        return ret;
+    }
+    for (quint32 i = 0; i < enumCount; ++i) {
+        QString name;
+        quint32 valueCount;
+        if (!readString(p, end, &name) || !readNumber(p, end, &valueCount)) {
+            return EnumDefinitions();
+        }
+        Enum e(name);
+        for (quint32 j = 0; j < valueCount; ++j) {
+            QString key;
+            QString value;
+            if (!readString(p, end, &key) || !readString(p, end, &value)) {
+                return EnumDefinitions();
+            }
+            e.mEnumValues.insert(key, value);
+        }
+        ret.append(e);
+    }
     return ret;
 }
@@ -23,10 +23,9 @@
 
 #include "kdcrmdata_export.h"
 
-#include <vector>
-
 #include <QMap>
 #include <QMetaType>
+#include <QSharedDataPointer>
 #include <QString>
 
 /**
@@ -37,11 +36,17 @@
  * Each enum definition contains a list of values (ID and display string).
  * E.g. one of the values in the 'lead source' definition is:
  *   ID="QtDevDays", DisplayString="Qt Developer Days"
+ *
+ * The data of this class is implicitly shared, so the definitions parsed
+ * from a collection attribute can be passed around by value.
  */
 class KDCRMDATA_EXPORT EnumDefinitions
 {
 public:
     EnumDefinitions();
+    EnumDefinitions(const EnumDefinitions &other);
+    ~EnumDefinitions();
+    EnumDefinitions &operator=(const EnumDefinitions &other);
 
     struct KDCRMDATA_EXPORT Enum
     {
@@ -54,19 +59,25 @@ public:
         Map mEnumValues; // ID, display string
     };
 
-    void append(const Enum &e) { mDefinitions.push_back(e); }
-    EnumDefinitions &operator<<(const Enum &e) { mDefinitions.push_back(e); return *this; }
+    void append(const Enum &e);
+    EnumDefinitions &operator<<(const Enum &e) { append(e); return *this; }
 
-    int count() const { return mDefinitions.size(); }
-    const Enum & at(int i) const { return mDefinitions.at(i); }
-    int indexOf(const QString &enumName) const;
+    int count() const;
+    const Enum & at(int i) const;
+    int indexOf(const QString &enumName) const; // hashed lookup
 
-    // serialization
+    // serialization, human readable
     QString toString() const;
     static EnumDefinitions fromString(const QString &str);
 
+    // serialization, compact (length-prefixed UTF-8), used by EnumDefinitionAttribute
+    QByteArray toByteArray() const;
+    static bool isByteArrayFormat(const QByteArray &data);
+    static EnumDefinitions fromByteArray(const QByteArray &data);
+
 private:
-    std::vector<Enum> mDefinitions;
+    class Private;
+    QSharedDataPointer<Private> d;
 };
 
 Q_DECLARE_METATYPE(EnumDefinitions)
@@ -27,13 +27,127 @@
 
 #include <QDateTime>
 
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define TIMESTAMPFORMAT QLatin1String( "yyyy-MM-dd hh:mm:ss" )
 
 QDateTime KDCRMUtils::dateTimeFromString(const QString &serverTimestamp)
 {
-    QDateTime dt = QDateTime::fromString(serverTimestamp, TIMESTAMPFORMAT);
-    dt.setTimeSpec(Qt::UTC);
-    return dt;
+    return dateTimeFromSecsSinceEpoch(secsSinceEpochFromDateTimeString(serverTimestamp));
+}
+
+// Hand-written parser for the fixed server formats, much faster than QDateTime::fromString,
+// which has to interpret the format string for every call.
+
+static const qint64 s_secsPerDay = 86400;
+static const int s_julianDayOfEpoch = 2440588; // 1970-01-01
+
+static inline int parseDigits(const ushort *p, int count, bool *ok)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const uint digit = uint(p[i]) - '0';
+        if (digit > 9) {
+            *ok = false;
+            return 0;
+        }
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar (Howard Hinnant's days_from_civil)
+static qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = year - era * 400;
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return qint64(era) * 146097 + dayOfEra - 719468;
+}
+
+static qint64 parseSecsSinceEpoch(const QString &str, bool withTime)
+{
+    // yyyy-MM-dd hh:mm:ss
+    // 0123456789012345678
+    if (str.size() != (withTime ? 19 : 10)) {
+        return KDCRMUtils::InvalidSecsSinceEpoch;
+    }
+    const ushort *p = str.utf16();
+    if (p[4] != '-' || p[7] != '-') {
+        return KDCRMUtils::InvalidSecsSinceEpoch;
+    }
+    bool ok = true;
+    const int year = parseDigits(p, 4, &ok);
+    const int month = parseDigits(p + 5, 2, &ok);
+    const int day = parseDigits(p + 8, 2, &ok);
+    int hours = 0;
+    int minutes = 0;
+    int seconds = 0;
+    if (withTime) {
+        if (p[10] != ' ' || p[13] != ':' || p[16] != ':') {
+            return KDCRMUtils::InvalidSecsSinceEpoch;
+        }
+        hours = parseDigits(p + 11, 2, &ok);
+        minutes = parseDigits(p + 14, 2, &ok);
+        seconds = parseDigits(p + 17, 2, &ok);
+    }
+    if (!ok || month < 1 || month > 12 || day < 1 || hours > 23 || minutes > 59 || seconds > 59) {
+        return KDCRMUtils::InvalidSecsSinceEpoch;
+    }
+    static const int daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (day > daysInMonth[month - 1] + (month == 2 && leapYear ? 1 : 0)) {
+        return KDCRMUtils::InvalidSecsSinceEpoch;
+    }
+    return daysFromCivil(year, month, day) * s_secsPerDay + hours * 3600 + minutes * 60 + seconds;
+}
+
+qint64 KDCRMUtils::secsSinceEpochFromDateTimeString(const QString &dateTimeString)
+{
+    return parseSecsSinceEpoch(dateTimeString, true);
+}
+
+qint64 KDCRMUtils::secsSinceEpochFromDateString(const QString &dateString)
+{
+    return parseSecsSinceEpoch(dateString, false);
+}
+
+qint64 KDCRMUtils::secsSinceEpochFromDate(const QDate &date)
+{
+    if (!date.isValid()) {
+        return InvalidSecsSinceEpoch;
+    }
+    return (date.toJulianDay() - s_julianDayOfEpoch) * s_secsPerDay;
+}
+
+// floor division, so that times before 1970 end up on the right day
+static inline qint64 daysSinceEpoch(qint64 secs)
+{
+    return secs >= 0 ? secs / s_secsPerDay : (secs - s_secsPerDay + 1) / s_secsPerDay;
+}
+
+QDateTime KDCRMUtils::dateTimeFromSecsSinceEpoch(qint64 secs)
+{
+    if (secs == InvalidSecsSinceEpoch) {
+        return QDateTime();
+    }
+    const qint64 days = daysSinceEpoch(secs);
+    const int secsOfDay = secs - days * s_secsPerDay;
+    return QDateTime(QDate::fromJulianDay(days + s_julianDayOfEpoch), QTime(0, 0).addSecs(secsOfDay), Qt::UTC);
+}
+
+QDate KDCRMUtils::dateFromSecsSinceEpoch(qint64 secs)
+{
+    if (secs == InvalidSecsSinceEpoch) {
+        return QDate();
+    }
+    return QDate::fromJulianDay(daysSinceEpoch(secs) + s_julianDayOfEpoch);
 }
 
 void KDCRMUtils::incrementTimeStamp(QString &serverTimestamp)
@@ -95,25 +209,186 @@ QString KDCRMUtils::formatDateTime(const QDateTime &dt)
 // and we get &amp;gt; for '>', etc.
 // And strangely enough, it uses &#039; instead of &apos;
 
+// Both functions are called for every field of every entry during a sync,
+// so they first look for a character needing work (using SSE2 when available),
+// return the input unchanged (no allocation) if there is none, and otherwise
+// build the result in a single pass.
+
+static inline bool needsEncoding(ushort c)
+{
+    // '"' (34), '&' (38), '\'' (39), '<' (60), '>' (62)
+    static const quint64 mask = (Q_UINT64_C(1) << '"') | (Q_UINT64_C(1) << '&') | (Q_UINT64_C(1) << '\'')
+                                | (Q_UINT64_C(1) << '<') | (Q_UINT64_C(1) << '>');
+    return c < 64 && (mask & (Q_UINT64_C(1) << c));
+}
+
+static const ushort *findCharToEncode(const ushort *p, const ushort *end)
+{
+#ifdef __SSE2__
+    const __m128i quot = _mm_set1_epi16('"');
+    const __m128i amp = _mm_set1_epi16('&');
+    const __m128i apos = _mm_set1_epi16('\'');
+    const __m128i lt = _mm_set1_epi16('<');
+    const __m128i gt = _mm_set1_epi16('>');
+    for (; end - p >= 8; p += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chunk, quot), _mm_cmpeq_epi16(chunk, amp)),
+                                           _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chunk, apos), _mm_cmpeq_epi16(chunk, lt)),
+                                                        _mm_cmpeq_epi16(chunk, gt)));
+        const int bits = _mm_movemask_epi8(match);
+        if (bits) {
+            return p + __builtin_ctz(bits) / 2;
+        }
+    }
+#endif
+    for (; p != end; ++p) {
+        if (needsEncoding(*p)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static const ushort *findAmpersand(const ushort *p, const ushort *end)
+{
+#ifdef __SSE2__
+    const __m128i amp = _mm_set1_epi16('&');
+    for (; end - p >= 8; p += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int bits = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, amp));
+        if (bits) {
+            return p + __builtin_ctz(bits) / 2;
+        }
+    }
+#endif
+    for (; p != end; ++p) {
+        if (*p == '&') {
+            return p;
+        }
+    }
+    return end;
+}
+
+static inline QChar *appendLatin1(QChar *out, const char *str)
+{
+    while (*str) {
+        *out++ = QLatin1Char(*str++);
+    }
+    return out;
+}
+
 QString KDCRMUtils::encodeXML(const QString &str)
 {
-    QString encoded = str;
-    encoded.replace('&', "&amp;");
-    encoded.replace('<', "&lt;");
-    encoded.replace('>', "&gt;");
-    encoded.replace('\'', "&#039;");
-    encoded.replace('"', "&quot;");
+    const ushort *begin = str.utf16();
+    const ushort *end = begin + str.size();
+    const ushort *p = findCharToEncode(begin, end);
+    if (p == end) {
+        return str;
+    }
+
+    static const int maxEntityLength = 6; // "&#039;"
+    QString encoded;
+    encoded.resize(str.size() + 8 * maxEntityLength);
+    int written = 0;
+    const ushort *runStart = begin;
+    for (;;) {
+        const int runLength = p - runStart;
+        if (written + runLength + maxEntityLength > encoded.size()) {
+            encoded.resize(qMax(2 * encoded.size(), written + runLength + maxEntityLength));
+        }
+        QChar *out = encoded.data() + written;
+        memcpy(out, runStart, runLength * sizeof(QChar));
+        out += runLength;
+        if (p == end) {
+            written = out - encoded.constData();
+            break;
+        }
+        switch (*p) {
+        case '&': out = appendLatin1(out, "&amp;"); break;
+        case '<': out = appendLatin1(out, "&lt;"); break;
+        case '>': out = appendLatin1(out, "&gt;"); break;
+        case '\'': out = appendLatin1(out, "&#039;"); break;
+        default: out = appendLatin1(out, "&quot;"); break;
+        }
+        written = out - encoded.constData();
+        runStart = ++p;
+        p = findCharToEncode(p, end);
+    }
+    encoded.resize(written);
     return encoded;
 }
 
+// Returns the length of the entity starting at @p p (pointing to '&'), 0 if it's none of ours
+static inline int matchEntity(const ushort *p, const ushort *end, QChar *decoded)
+{
+    static const struct {
+        const char *name;
+        int length;
+        char ch;
+    } entities[] = {
+        { "&quot;", 6, '"' },
+        { "&#039;", 6, '\'' },
+        { "&gt;", 4, '>' },
+        { "&lt;", 4, '<' },
+        { "&amp;", 5, '&' }
+    };
+    for (uint i = 0; i < sizeof(entities) / sizeof(*entities); ++i) {
+        const int length = entities[i].length;
+        if (end - p < length) {
+            continue;
+        }
+        int j = 1; // p[0] is '&'
+        while (j < length && p[j] == ushort(entities[i].name[j])) {
+            ++j;
+        }
+        if (j == length) {
+            *decoded = QLatin1Char(entities[i].ch);
+            return length;
+        }
+    }
+    return 0;
+}
+
 QString KDCRMUtils::decodeXML(const QString &str)
 {
-    QString decoded = str;
-    decoded.replace("&quot;", QChar('"'));
-    decoded.replace("&#039;", QChar('\''));
-    decoded.replace("&gt;", QChar('>'));
-    decoded.replace("&lt;", QChar('<'));
-    decoded.replace("&amp;", QChar('&'));
     // While at it, remove trailing spaces, they can be confusing with e.g. country filtering.
-    return decoded.trimmed();
+    // Entities never decode to whitespace, so trimming before decoding gives the same result.
+    const ushort *begin = str.utf16();
+    const ushort *end = begin + str.size();
+    const ushort *p = findAmpersand(begin, end);
+    if (p == end) {
+        return str.trimmed();
+    }
+    while (begin != p && QChar(*begin).isSpace()) {
+        ++begin;
+    }
+    while (end != begin && QChar(end[-1]).isSpace()) {
+        --end;
+    }
+
+    // decoding never makes the string longer
+    QString decoded;
+    decoded.resize(end - begin);
+    QChar *out = decoded.data();
+    const ushort *runStart = begin;
+    while (p != end) {
+        const int runLength = p - runStart;
+        memcpy(out, runStart, runLength * sizeof(QChar));
+        out += runLength;
+        const int entityLength = matchEntity(p, end, out);
+        if (entityLength > 0) {
+            p += entityLength;
+        } else {
+            *out = QLatin1Char('&');
+            ++p;
+        }
+        ++out;
+        runStart = p;
+        p = findAmpersand(p, end);
+    }
+    const int runLength = end - runStart;
+    memcpy(out, runStart, runLength * sizeof(QChar));
+    out += runLength;
+    decoded.resize(out - decoded.constData());
+    return decoded;
 }
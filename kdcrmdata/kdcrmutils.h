@@ -45,6 +45,14 @@ KDCRMDATA_EXPORT QString dateTimeToString(const QDateTime &dateTime); // using y
 KDCRMDATA_EXPORT QString formatDate(const QDate &date); // locale
 KDCRMDATA_EXPORT QString formatDateTime(const QDateTime &dt); // locale
 
+// Timestamps stored as seconds since 1970-01-01 00:00 UTC, see e.g. SugarAccount::dateModifiedSecsSinceEpoch()
+const qint64 InvalidSecsSinceEpoch = Q_INT64_C(-0x7fffffffffffffff) - 1;
+KDCRMDATA_EXPORT qint64 secsSinceEpochFromDateTimeString(const QString &dateTimeString); // using yyyy-MM-dd hh:mm:ss
+KDCRMDATA_EXPORT qint64 secsSinceEpochFromDateString(const QString &dateString); // using yyyy-MM-dd, at 00:00
+KDCRMDATA_EXPORT qint64 secsSinceEpochFromDate(const QDate &date); // at 00:00
+KDCRMDATA_EXPORT QDateTime dateTimeFromSecsSinceEpoch(qint64 secs); // UTC, invalid for InvalidSecsSinceEpoch
+KDCRMDATA_EXPORT QDate dateFromSecsSinceEpoch(qint64 secs); // invalid for InvalidSecsSinceEpoch
+
 KDCRMDATA_EXPORT QString encodeXML(const QString &str);
 KDCRMDATA_EXPORT QString decodeXML(const QString &str);
 }
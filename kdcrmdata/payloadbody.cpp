@@ -0,0 +1,156 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "payloadbody.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QXmlStreamReader>
+
+QString PayloadBody::elementName()
+{
+    return QLatin1String("body");
+}
+
+QByteArray PayloadBody::headerPartName()
+{
+    return QByteArray("HEAD");
+}
+
+QByteArray PayloadBody::extract(const QByteArray &data)
+{
+    // Special characters are escaped in the field values, so the first "<body>"
+    // and the last "</body>" are necessarily the markup written by the IO classes.
+    static const char startTag[] = "<body>";
+    static const char endTag[] = "</body>";
+    const int start = data.indexOf(startTag);
+    if (start < 0) {
+        return QByteArray();
+    }
+    const int end = data.lastIndexOf(endTag);
+    if (end < start) {
+        return QByteArray();
+    }
+    return data.mid(start, end + int(sizeof(endTag)) - 1 - start);
+}
+
+QHash<QString, QString> PayloadBody::decode(const QByteArray &body)
+{
+    QHash<QString, QString> fields;
+    QXmlStreamReader xml(body);
+    if (xml.readNextStartElement() && xml.name() == elementName()) {
+        while (xml.readNextStartElement()) {
+            const QString name = xml.name().toString();
+            fields.insert(name, xml.readElementText());
+        }
+    }
+    return fields;
+}
+
+Q_GLOBAL_STATIC(QMutex, s_mutex)
+
+QMutex *PayloadBody::mutex()
+{
+    return s_mutex();
+}
+
+// Qt 4 has no loadAcquire()/storeRelease(), these are their equivalents
+static inline int loadAcquire(QAtomicInt &value)
+{
+    return value.fetchAndAddAcquire(0);
+}
+
+static inline void storeRelease(QAtomicInt &value, int newValue)
+{
+    value.fetchAndStoreRelease(newValue);
+}
+
+PayloadBody::LazyField::LazyField(const QString &elementName)
+    : mElementName(elementName),
+      mPending(0)
+{
+}
+
+PayloadBody::LazyField::LazyField(const LazyField &other)
+    : mElementName(other.mElementName),
+      mPending(0)
+{
+    *this = other;
+}
+
+PayloadBody::LazyField &PayloadBody::LazyField::operator=(const LazyField &other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    mElementName = other.mElementName;
+    if (loadAcquire(other.mPending) == 0) {
+        mValue = other.mValue;
+        mSerializedBody.clear();
+        storeRelease(mPending, 0);
+        return *this;
+    }
+    // other may be decoded by another thread meanwhile, copy a consistent state
+    QMutexLocker locker(mutex());
+    mValue = other.mValue;
+    mSerializedBody = other.mSerializedBody;
+    storeRelease(mPending, int(other.mPending));
+    return *this;
+}
+
+QString PayloadBody::LazyField::value() const
+{
+    if (loadAcquire(mPending) != 0) {
+        decode();
+    }
+    return mValue;
+}
+
+void PayloadBody::LazyField::setValue(const QString &value)
+{
+    mValue = value;
+    mSerializedBody.clear();
+    storeRelease(mPending, 0);
+}
+
+void PayloadBody::LazyField::setSerializedBody(const QByteArray &body)
+{
+    mValue.clear();
+    mSerializedBody = body;
+    storeRelease(mPending, body.isEmpty() ? 0 : 1);
+}
+
+bool PayloadBody::LazyField::isPending() const
+{
+    return loadAcquire(mPending) != 0;
+}
+
+void PayloadBody::LazyField::decode() const
+{
+    QMutexLocker locker(mutex());
+    if (mPending == 0) { // another thread was faster
+        return;
+    }
+    mValue = PayloadBody::decode(mSerializedBody).value(mElementName);
+    mSerializedBody.clear();
+    storeRelease(mPending, 0);
+}
@@ -0,0 +1,89 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PAYLOADBODY_H
+#define PAYLOADBODY_H
+
+#include "kdcrmdata_export.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+class QMutex;
+
+/**
+  Helpers for the lazily decoded body of the serialized payloads.
+
+  Since version 2.0, the note, email and opportunity payloads start with the fields needed
+  by the list views, followed by a <body> element with the large fields (e.g. the description).
+  When reading a payload, the body is kept as raw UTF-8 and only decoded once one of its fields
+  is actually used.
+ */
+namespace PayloadBody
+{
+KDCRMDATA_EXPORT QString elementName(); // "body"
+
+// the name of the payload part written without the body, for fetching only what the lists need
+KDCRMDATA_EXPORT QByteArray headerPartName(); // "HEAD"
+
+// returns the "<body>...</body>" section of a serialized payload, or an empty array
+KDCRMDATA_EXPORT QByteArray extract(const QByteArray &data);
+
+// returns the fields of a section returned by extract(), by element name
+KDCRMDATA_EXPORT QHash<QString, QString> decode(const QByteArray &body);
+
+// protects the on-demand decoding, since payloads are shared between threads
+KDCRMDATA_EXPORT QMutex *mutex();
+
+/**
+  A field of the body, decoded from the serialized body on first access.
+
+  Payloads are implicitly shared and read from several threads (e.g. the ingestion
+  pipeline), so the decoding and the copies made when detaching happen under mutex().
+ */
+class KDCRMDATA_EXPORT LazyField
+{
+public:
+    explicit LazyField(const QString &elementName);
+    LazyField(const LazyField &other);
+    LazyField &operator=(const LazyField &other);
+
+    QString value() const;
+    void setValue(const QString &value);
+
+    // stores a section returned by extract(), to be decoded by the next call to value()
+    void setSerializedBody(const QByteArray &body);
+    bool isPending() const;
+
+private:
+    void decode() const;
+
+    QString mElementName;
+    mutable QString mValue;
+    mutable QByteArray mSerializedBody;
+    mutable QAtomicInt mPending;
+};
+}
+
+#endif
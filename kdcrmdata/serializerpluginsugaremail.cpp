@@ -24,6 +24,7 @@
 
 #include "sugaremail.h"
 #include "sugaremailio.h"
+#include "payloadbody.h"
 
 #include <Akonadi/Item>
 
@@ -35,9 +36,13 @@ bool SerializerPluginSugarEmail::deserialize(Item &item, const QByteArray &label
 {
     Q_UNUSED(version);
 
-    if (label != Item::FullPayload) {
+    const bool header = label == PayloadBody::headerPartName();
+    if (label != Item::FullPayload && !header) {
         return false;
     }
+    if (header && item.hasPayload<SugarEmail>()) {
+        return true; // don't replace the full payload, when fetching both parts
+    }
 
     SugarEmail sugarEmail;
     SugarEmailIO io;
@@ -54,13 +59,24 @@ void SerializerPluginSugarEmail::serialize(const Item &item, const QByteArray &l
 {
     Q_UNUSED(version);
 
-    if (label != Item::FullPayload || !item.hasPayload<SugarEmail>()) {
+    const bool header = label == PayloadBody::headerPartName();
+    if ((label != Item::FullPayload && !header) || !item.hasPayload<SugarEmail>()) {
         return;
     }
 
     const SugarEmail sugarEmail = item.payload<SugarEmail>();
     SugarEmailIO io;
-    io.writeSugarEmail(sugarEmail, &data);
+    io.writeSugarEmail(sugarEmail, &data, !header);
+}
+
+QSet<QByteArray> SerializerPluginSugarEmail::parts(const Item &item) const
+{
+    // the header part lets the emails be listed without transferring their bodies
+    QSet<QByteArray> set;
+    if (item.hasPayload<SugarEmail>()) {
+        set << Item::FullPayload << PayloadBody::headerPartName();
+    }
+    return set;
 }
 
 Q_EXPORT_PLUGIN2(akonadi_serializer_sugaremail, Akonadi::SerializerPluginSugarEmail)
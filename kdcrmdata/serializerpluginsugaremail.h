@@ -38,6 +38,7 @@ class SerializerPluginSugarEmail : public QObject, public ItemSerializerPlugin
 public:
     bool deserialize(Item &item, const QByteArray &label, QIODevice &data, int version);
     void serialize(const Item &item, const QByteArray &label, QIODevice &data, int &version);
+    QSet<QByteArray> parts(const Item &item) const;
 };
 
 }
@@ -24,6 +24,7 @@
 
 #include "sugarnote.h"
 #include "sugarnoteio.h"
+#include "payloadbody.h"
 
 #include <Akonadi/Item>
 
@@ -35,9 +36,13 @@ bool SerializerPluginSugarNote::deserialize(Item &item, const QByteArray &label,
 {
     Q_UNUSED(version);
 
-    if (label != Item::FullPayload) {
+    const bool header = label == PayloadBody::headerPartName();
+    if (label != Item::FullPayload && !header) {
         return false;
     }
+    if (header && item.hasPayload<SugarNote>()) {
+        return true; // don't replace the full payload, when fetching both parts
+    }
 
     SugarNote sugarNote;
     SugarNoteIO io;
@@ -54,13 +59,24 @@ void SerializerPluginSugarNote::serialize(const Item &item, const QByteArray &la
 {
     Q_UNUSED(version);
 
-    if (label != Item::FullPayload || !item.hasPayload<SugarNote>()) {
+    const bool header = label == PayloadBody::headerPartName();
+    if ((label != Item::FullPayload && !header) || !item.hasPayload<SugarNote>()) {
         return;
     }
 
     const SugarNote sugarNote = item.payload<SugarNote>();
     SugarNoteIO io;
-    io.writeSugarNote(sugarNote, &data);
+    io.writeSugarNote(sugarNote, &data, !header);
+}
+
+QSet<QByteArray> SerializerPluginSugarNote::parts(const Item &item) const
+{
+    // the header part lets the notes be listed without transferring their bodies
+    QSet<QByteArray> set;
+    if (item.hasPayload<SugarNote>()) {
+        set << Item::FullPayload << PayloadBody::headerPartName();
+    }
+    return set;
 }
 
 Q_EXPORT_PLUGIN2(akonadi_serializer_sugarnote, Akonadi::SerializerPluginSugarNote)
@@ -21,6 +21,7 @@
 */
 
 #include "sugaraccount.h"
+#include "kdcrmutils.h"
 
 #include <KLocalizedString>
 
@@ -28,12 +29,19 @@
 #include <QMap>
 #include <QSharedData>
 #include <QString>
+#include <QVector>
+
+#include <string.h>
+
+static QString computeCleanAccountName(const QString &name);
 
 class SugarAccount::Private : public QSharedData
 {
 public:
     Private()
-        : mEmpty(true)
+        : mEmpty(true),
+          mDateEnteredSecs(KDCRMUtils::InvalidSecsSinceEpoch),
+          mDateModifiedSecs(KDCRMUtils::InvalidSecsSinceEpoch)
     {
 
     }
@@ -45,8 +53,11 @@ public:
 
         mId = other.mId;
         mName = other.mName;
+        mCleanAccountName = other.mCleanAccountName;
         mDateEntered = other.mDateEntered;
+        mDateEnteredSecs = other.mDateEnteredSecs;
         mDateModified = other.mDateModified;
+        mDateModifiedSecs = other.mDateModifiedSecs;
         mModifiedUserId = other.mModifiedUserId;
         mModifiedByName = other.mModifiedByName;
         mCreatedBy = other.mCreatedBy;
@@ -89,8 +100,11 @@ public:
 
     QString mId;
     QString mName;
+    QString mCleanAccountName; // cached, see cleanAccountName()
     QString mDateEntered;
     QString mDateModified;
+    qint64 mDateEnteredSecs; // parsed once, for sorting and filtering
+    qint64 mDateModifiedSecs;
     QString mModifiedUserId;
     QString mModifiedByName;
     QString mCreatedBy;
@@ -165,6 +179,120 @@ static const char* s_extensions[] = {
 };
 static const int s_extensionCount = sizeof(s_extensions) / sizeof(*s_extensions);
 
+// A trie of all the variants of the extensions, i.e. ", Inc.", ", Inc", " Inc." and " Inc",
+// so that a name can be cleaned up in a single pass.
+class ExtensionMatcher
+{
+public:
+    ExtensionMatcher()
+    {
+        mNodes.append(Node());
+        for (int i = 0; i < s_extensionCount; ++i) {
+            const QString extension = QString::fromUtf8(s_extensions[i]);
+            addPattern(QLatin1String(", ") + extension + QLatin1Char('.'));
+            addPattern(QLatin1String(", ") + extension);
+            addPattern(QLatin1Char(' ') + extension + QLatin1Char('.'));
+            addPattern(QLatin1Char(' ') + extension);
+        }
+    }
+
+    // Returns the length of the longest variant starting at @p p, 0 if none
+    int longestMatch(const QChar *p, const QChar *end) const
+    {
+        int node = 0;
+        int longest = 0;
+        for (const QChar *c = p; c != end; ++c) {
+            node = child(node, c->unicode());
+            if (node < 0) {
+                break;
+            }
+            if (mNodes.at(node).terminal) {
+                longest = c - p + 1;
+            }
+        }
+        return longest;
+    }
+
+private:
+    struct Transition {
+        ushort ch;
+        int node;
+    };
+    struct Node {
+        Node() : terminal(false) {}
+        QVector<Transition> transitions;
+        bool terminal;
+    };
+
+    int child(int node, ushort ch) const
+    {
+        const QVector<Transition> &transitions = mNodes.at(node).transitions;
+        for (int i = 0; i < transitions.count(); ++i) {
+            if (transitions.at(i).ch == ch) {
+                return transitions.at(i).node;
+            }
+        }
+        return -1;
+    }
+
+    void addPattern(const QString &pattern)
+    {
+        int node = 0;
+        for (int i = 0; i < pattern.size(); ++i) {
+            const ushort ch = pattern.at(i).unicode();
+            int next = child(node, ch);
+            if (next < 0) {
+                next = mNodes.count();
+                mNodes.append(Node());
+                const Transition transition = { ch, next };
+                mNodes[node].transitions.append(transition);
+            }
+            node = next;
+        }
+        mNodes[node].terminal = true;
+    }
+
+    QVector<Node> mNodes;
+};
+
+Q_GLOBAL_STATIC(ExtensionMatcher, s_extensionMatcher)
+
+// Removes all the extensions from the name, in one pass, longest match first
+// (so that "GmbH & Co. KG" wins over "GmbH").
+static QString computeCleanAccountName(const QString &name)
+{
+    const ExtensionMatcher *matcher = s_extensionMatcher();
+    const QChar *begin = name.constData();
+    const QChar *end = begin + name.size();
+    const QChar *runStart = begin;
+    QString result;
+    int written = 0;
+    for (const QChar *p = begin; p != end;) {
+        // all variants start with a space or a comma
+        const int matchLength = (*p == QLatin1Char(' ') || *p == QLatin1Char(','))
+                                ? matcher->longestMatch(p, end) : 0;
+        if (matchLength == 0) {
+            ++p;
+            continue;
+        }
+        if (result.isNull()) {
+            result.resize(name.size());
+        }
+        const int runLength = p - runStart;
+        memcpy(result.data() + written, runStart, runLength * sizeof(QChar));
+        written += runLength;
+        p += matchLength;
+        runStart = p;
+    }
+    if (result.isNull()) {
+        return name;
+    }
+    const int runLength = end - runStart;
+    memcpy(result.data() + written, runStart, runLength * sizeof(QChar));
+    result.resize(written + runLength);
+    return result;
+}
+
 // The rule is: one account of a given name, in a given city.
 // E.g. HP (city: Barcelona) != HP (city: Chicago) != HP (city: London)
 bool SugarAccount::isSameAccount(const SugarAccount &other) const
@@ -195,15 +323,7 @@ QString SugarAccount::key() const
 
 QString SugarAccount::cleanAccountName() const
 {
-    QString result = d->mName;
-    for (int i = 0; i < s_extensionCount; ++i) {
-        const QString extension = s_extensions[i];
-        result.remove(", " + extension + '.');
-        result.remove(", " + extension);
-        result.remove(QChar(' ') + extension + '.');
-        result.remove(QChar(' ') + extension);
-    }
-    return result;
+    return d->mCleanAccountName;
 }
 
 #if 0
@@ -361,6 +481,7 @@ void SugarAccount::setName(const QString &name)
 {
     d->mEmpty = false;
     d->mName = name;
+    d->mCleanAccountName = computeCleanAccountName(name);
 }
 
 QString SugarAccount::name() const
@@ -372,6 +493,7 @@ void SugarAccount::setDateEntered(const QString &value)
 {
     d->mEmpty = false;
     d->mDateEntered = value;
+    d->mDateEnteredSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarAccount::dateEntered() const
@@ -379,10 +501,16 @@ QString SugarAccount::dateEntered() const
     return d->mDateEntered;
 }
 
+qint64 SugarAccount::dateEnteredSecsSinceEpoch() const
+{
+    return d->mDateEnteredSecs;
+}
+
 void SugarAccount::setDateModified(const QString &value)
 {
     d->mEmpty = false;
     d->mDateModified = value;
+    d->mDateModifiedSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarAccount::dateModified() const
@@ -390,6 +518,11 @@ QString SugarAccount::dateModified() const
     return d->mDateModified;
 }
 
+qint64 SugarAccount::dateModifiedSecsSinceEpoch() const
+{
+    return d->mDateModifiedSecs;
+}
+
 void SugarAccount::setModifiedUserId(const QString &value)
 {
     d->mEmpty = false;
@@ -81,6 +81,7 @@ public:
     /**
       Returns the canonical name of the account.
       E.g. "KDAB, Inc." has a canonical name of "KDAB".
+      It is computed once, when setting the name.
     */
     QString cleanAccountName() const;
 
@@ -138,6 +139,11 @@ public:
       Return Creation date.
      */
     QString dateEntered() const;
+    /**
+      Return Creation date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateEnteredSecsSinceEpoch() const;
 
     /**
       Set Modification date.
@@ -147,6 +153,11 @@ public:
       Return Modification date.
      */
     QString dateModified() const;
+    /**
+      Return Modification date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateModifiedSecsSinceEpoch() const;
 
     /**
       Set Modified User id.
@@ -21,6 +21,7 @@
 */
 
 #include "sugaremail.h"
+#include "payloadbody.h"
 #include "kdcrmfields.h"
 
 #include <QSharedData>
@@ -32,13 +33,15 @@ class SugarEmail::Private : public QSharedData
 {
 public:
     Private()
-        : mEmpty(true)
+        : mEmpty(true),
+          mDescription(QLatin1String("description"))
     {
 
     }
 
     Private(const Private &other)
-        : QSharedData(other)
+        : QSharedData(other),
+          mDescription(other.mDescription) // under the lock, other may be decoded meanwhile
     {
         mEmpty = other.mEmpty;
 
@@ -61,7 +64,6 @@ public:
         mFromAddrName = other.mFromAddrName;
         mToAddrNAmes = other.mToAddrNAmes;
         mCcAddrNames = other.mCcAddrNames;
-        mDescription = other.mDescription;
     }
 
     bool mEmpty;
@@ -87,7 +89,8 @@ public:
     QString mToAddrNAmes;
     QString mCcAddrNames;
 
-    QString mDescription;
+    // body
+    PayloadBody::LazyField mDescription;
 };
 
 SugarEmail::SugarEmail()
@@ -169,7 +172,7 @@ bool SugarEmail::operator==(const SugarEmail &other) const
     if (d->mCcAddrNames != other.d->mCcAddrNames) {
         return false;
     }
-    if (d->mDescription != other.d->mDescription) {
+    if (d->mDescription.value() != other.d->mDescription.value()) {
         return false;
     }
     return true;
@@ -391,12 +394,12 @@ QString SugarEmail::ccAddrNames() const
 void SugarEmail::setDescription(const QString &value)
 {
     d->mEmpty = false;
-    d->mDescription = value;
+    d->mDescription.setValue(value);
 }
 
 QString SugarEmail::description() const
 {
-    return d->mDescription;
+    return d->mDescription.value();
 }
 
 void SugarEmail::setData(const QMap<QString, QString>& data)
@@ -438,6 +441,22 @@ QMap<QString, QString> SugarEmail::data() const
     return data;
 }
 
+void SugarEmail::setSerializedBody(const QByteArray &body)
+{
+    d->mEmpty = false;
+    d->mDescription.setSerializedBody(body);
+}
+
+bool SugarEmail::hasPendingBody() const
+{
+    return d->mDescription.isPending();
+}
+
+bool SugarEmail::isBodyField(const QString &key)
+{
+    return key == QLatin1String("description");
+}
+
 QString SugarEmail::mimeType()
 {
     return QLatin1String("application/x-vnd.kdab.crm.email");
@@ -22,6 +22,7 @@
 
 #include "sugaremailio.h"
 #include "sugaremail.h"
+#include "payloadbody.h"
 
 #include <KLocalizedString>
 
@@ -41,13 +42,17 @@ bool SugarEmailIO::readSugarEmail(QIODevice *device, SugarEmail &email)
     }
 
     email = SugarEmail();
-    xml.setDevice(device);
+    // read everything at once, so that the body can be kept undecoded
+    const QByteArray data = device->readAll();
+    xml.clear();
+    xml.addData(data);
     if (xml.readNextStartElement()) {
+        const QString version = xml.attributes().value("version").toString();
         if (xml.name() == "sugarEmail"
-                && xml.attributes().value("version") == "1.0") {
-            readEmail(email);
+                && (version == QLatin1String("2.0") || version == QLatin1String("1.0"))) {
+            readEmail(email, data);
         } else {
-            xml.raiseError(i18n("It is not a sugarEmail version 1.0 data."));
+            xml.raiseError(i18n("It is not a sugarEmail version 1.0 or 2.0 data."));
         }
 
     }
@@ -62,13 +67,19 @@ QString SugarEmailIO::errorString() const
            .arg(xml.columnNumber());
 }
 
-void SugarEmailIO::readEmail(SugarEmail &email)
+void SugarEmailIO::readEmail(SugarEmail &email, const QByteArray &data)
 {
     const SugarEmail::AccessorHash accessors = SugarEmail::accessorHash();
     Q_ASSERT(xml.isStartElement() && xml.name() == "sugarEmail");
 
     while (xml.readNextStartElement()) {
 
+        if (xml.name() == PayloadBody::elementName()) {
+            // Version 2.0: the body comes last and is only decoded on demand
+            email.setSerializedBody(PayloadBody::extract(data));
+            break;
+        }
+
         const SugarEmail::AccessorHash::const_iterator accessIt = accessors.constFind(xml.name().toString());
         if (accessIt != accessors.constEnd()) {
             (email.*(accessIt.value().setter))(xml.readElementText());
@@ -79,7 +90,7 @@ void SugarEmailIO::readEmail(SugarEmail &email)
     }
 }
 
-bool SugarEmailIO::writeSugarEmail(const SugarEmail &email, QIODevice *device)
+bool SugarEmailIO::writeSugarEmail(const SugarEmail &email, QIODevice *device, bool withBody)
 {
     if (device == 0 || !device->isWritable()) {
         return false;
@@ -90,14 +101,29 @@ bool SugarEmailIO::writeSugarEmail(const SugarEmail &email, QIODevice *device)
     writer.writeStartDocument();
     writer.writeDTD("<!DOCTYPE sugarEmail>");
     writer.writeStartElement("sugarEmail");
-    writer.writeAttribute("version", "1.0");
+    writer.writeAttribute("version", "2.0");
 
     const SugarEmail::AccessorHash accessors = SugarEmail::accessorHash();
     SugarEmail::AccessorHash::const_iterator it    = accessors.constBegin();
     SugarEmail::AccessorHash::const_iterator endIt = accessors.constEnd();
+    // header: the fields needed for list views, decoded right away
     for (; it != endIt; ++it) {
-        const SugarEmail::valueGetter getter = (*it).getter;
-        writer.writeTextElement(it.key(), (email.*getter)());
+        if (!SugarEmail::isBodyField(it.key())) {
+            const SugarEmail::valueGetter getter = (*it).getter;
+            writer.writeTextElement(it.key(), (email.*getter)());
+        }
+    }
+
+    // body: large fields, decoded only when used
+    if (withBody) {
+        writer.writeStartElement(PayloadBody::elementName());
+        for (it = accessors.constBegin(); it != endIt; ++it) {
+            if (SugarEmail::isBodyField(it.key())) {
+                const SugarEmail::valueGetter getter = (*it).getter;
+                writer.writeTextElement(it.key(), (email.*getter)());
+            }
+        }
+        writer.writeEndElement();
     }
     writer.writeEndDocument();
 
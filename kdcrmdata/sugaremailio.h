@@ -34,12 +34,12 @@ class KDCRMDATA_EXPORT SugarEmailIO
 public:
     SugarEmailIO();
     bool readSugarEmail(QIODevice *device, SugarEmail &email);
-    bool writeSugarEmail(const SugarEmail &email, QIODevice *device);
+    bool writeSugarEmail(const SugarEmail &email, QIODevice *device, bool withBody = true);
     QString errorString() const;
 
 private:
     QXmlStreamReader xml;
-    void readEmail(SugarEmail &email);
+    void readEmail(SugarEmail &email, const QByteArray &data);
 
 };
 #endif
@@ -21,6 +21,7 @@
 */
 
 #include "sugarlead.h"
+#include "kdcrmutils.h"
 #include "kdcrmfields.h"
 
 #include <QMap>
@@ -31,7 +32,9 @@ class SugarLead::Private : public QSharedData
 {
 public:
     Private()
-        : mEmpty(true)
+        : mEmpty(true),
+          mDateEnteredSecs(KDCRMUtils::InvalidSecsSinceEpoch),
+          mDateModifiedSecs(KDCRMUtils::InvalidSecsSinceEpoch)
     {
 
     }
@@ -43,7 +46,9 @@ public:
 
         mId = other.mId;
         mDateEntered = other.mDateEntered;
+        mDateEnteredSecs = other.mDateEnteredSecs;
         mDateModified = other.mDateModified;
+        mDateModifiedSecs = other.mDateModifiedSecs;
         mModifiedUserId = other.mModifiedUserId;
         mModifiedByName = other.mModifiedByName;
         mCreatedBy = other.mCreatedBy;
@@ -106,6 +111,8 @@ public:
     QString mId;
     QString mDateEntered;
     QString mDateModified;
+    qint64 mDateEnteredSecs; // parsed once, for sorting and filtering
+    qint64 mDateModifiedSecs;
     QString mModifiedUserId;
     QString mModifiedByName;
     QString mCreatedBy;
@@ -393,6 +400,7 @@ void SugarLead::setDateEntered(const QString &value)
 {
     d->mEmpty = false;
     d->mDateEntered = value;
+    d->mDateEnteredSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarLead::dateEntered() const
@@ -400,10 +408,16 @@ QString SugarLead::dateEntered() const
     return d->mDateEntered;
 }
 
+qint64 SugarLead::dateEnteredSecsSinceEpoch() const
+{
+    return d->mDateEnteredSecs;
+}
+
 void SugarLead::setDateModified(const QString &value)
 {
     d->mEmpty = false;
     d->mDateModified = value;
+    d->mDateModifiedSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarLead::dateModified() const
@@ -411,6 +425,11 @@ QString SugarLead::dateModified() const
     return d->mDateModified;
 }
 
+qint64 SugarLead::dateModifiedSecsSinceEpoch() const
+{
+    return d->mDateModifiedSecs;
+}
+
 void SugarLead::setModifiedUserId(const QString &value)
 {
     d->mEmpty = false;
@@ -1020,8 +1039,8 @@ void SugarLead::setData(const QMap<QString, QString>& data)
 {
     d->mEmpty = false;
     d->mId = data.value("id");
-    d->mDateEntered = data.value(KDCRMFields::dateEntered());
-    d->mDateModified = data.value(KDCRMFields::dateModified());
+    setDateEntered(data.value(KDCRMFields::dateEntered()));
+    setDateModified(data.value(KDCRMFields::dateModified()));
     d->mModifiedUserId = data.value(KDCRMFields::modifiedUserId());
     d->mModifiedByName = data.value(KDCRMFields::modifiedByName());
     d->mCreatedBy = data.value(KDCRMFields::createdBy());
@@ -105,6 +105,11 @@ public:
       Return Creation date.
      */
     QString dateEntered() const;
+    /**
+      Return Creation date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateEnteredSecsSinceEpoch() const;
 
     /**
       Set Modification date.
@@ -114,6 +119,11 @@ public:
       Return Modification date.
      */
     QString dateModified() const;
+    /**
+      Return Modification date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateModifiedSecsSinceEpoch() const;
 
     /**
       Set Modified User id.
@@ -22,6 +22,7 @@
 
 #include "sugarnote.h"
 #include "kdcrmfields.h"
+#include "payloadbody.h"
 
 #include <QSharedData>
 #include <QString>
@@ -32,13 +33,15 @@ class SugarNote::Private : public QSharedData
 {
 public:
     Private()
-        : mEmpty(true)
+        : mEmpty(true),
+          mDescription(QLatin1String("description"))
     {
 
     }
 
     Private(const Private &other)
-        : QSharedData(other)
+        : QSharedData(other),
+          mDescription(other.mDescription) // under the lock, other may be decoded meanwhile
     {
         mEmpty = other.mEmpty;
 
@@ -60,7 +63,6 @@ public:
         mParentId = other.mParentId;
         mContactId = other.mContactId;
         mContactName = other.mContactName;
-        mDescription = other.mDescription;
     }
 
     bool mEmpty;
@@ -83,8 +85,9 @@ public:
     QString mParentId;
     QString mContactId;
     QString mContactName;
-    QString mDescription;
 
+    // body
+    PayloadBody::LazyField mDescription;
 };
 
 SugarNote::SugarNote()
@@ -163,7 +166,7 @@ bool SugarNote::operator==(const SugarNote &other) const
     if (d->mContactName != other.d->mContactName) {
         return false;
     }
-    if (d->mDescription != other.d->mDescription) {
+    if (d->mDescription.value() != other.d->mDescription.value()) {
         return false;
     }
     return true;
@@ -374,12 +377,12 @@ QString SugarNote::contactName() const
 void SugarNote::setDescription(const QString &value)
 {
     d->mEmpty = false;
-    d->mDescription = value;
+    d->mDescription.setValue(value);
 }
 
 QString SugarNote::description() const
 {
-    return d->mDescription;
+    return d->mDescription.value();
 }
 
 void SugarNote::setData(const QMap<QString, QString>& data)
@@ -421,6 +424,22 @@ QMap<QString, QString> SugarNote::data() const
     return data;
 }
 
+void SugarNote::setSerializedBody(const QByteArray &body)
+{
+    d->mEmpty = false;
+    d->mDescription.setSerializedBody(body);
+}
+
+bool SugarNote::hasPendingBody() const
+{
+    return d->mDescription.isPending();
+}
+
+bool SugarNote::isBodyField(const QString &key)
+{
+    return key == QLatin1String("description");
+}
+
 QString SugarNote::mimeType()
 {
     return QLatin1String("application/x-vnd.kdab.crm.note");
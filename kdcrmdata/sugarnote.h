@@ -212,6 +212,22 @@ public:
      */
     QMap<QString, QString> data() const;
 
+    /**
+      Set the serialized body section of the payload, see SugarNoteIO.
+      It is only decoded once one of the body fields is accessed.
+     */
+    void setSerializedBody(const QByteArray &body);
+
+    /**
+      Return true if the serialized body hasn't been decoded yet. For unittests.
+     */
+    bool hasPendingBody() const;
+
+    /**
+      Return true if the field @p key is stored in the body section of the payload.
+     */
+    static bool isBodyField(const QString &key);
+
     /**
        Return the Mime type
      */
@@ -22,6 +22,7 @@
 
 #include "sugarnoteio.h"
 #include "sugarnote.h"
+#include "payloadbody.h"
 
 #include <KLocalizedString>
 #include <QHash>
@@ -39,13 +40,17 @@ bool SugarNoteIO::readSugarNote(QIODevice *device, SugarNote &note)
     }
 
     note = SugarNote();
-    xml.setDevice(device);
+    // read everything at once, so that the body can be kept undecoded
+    const QByteArray data = device->readAll();
+    xml.clear();
+    xml.addData(data);
     if (xml.readNextStartElement()) {
+        const QString version = xml.attributes().value("version").toString();
         if (xml.name() == "sugarNote"
-                && xml.attributes().value("version") == "1.0") {
-            readNote(note);
+                && (version == QLatin1String("2.0") || version == QLatin1String("1.0"))) {
+            readNote(note, data);
         } else {
-            xml.raiseError(i18n("It is not a sugarNote version 1.0 data."));
+            xml.raiseError(i18n("It is not a sugarNote version 1.0 or 2.0 data."));
         }
 
     }
@@ -60,13 +65,19 @@ QString SugarNoteIO::errorString() const
            xml.columnNumber());
 }
 
-void SugarNoteIO::readNote(SugarNote &note)
+void SugarNoteIO::readNote(SugarNote &note, const QByteArray &data)
 {
     const SugarNote::AccessorHash accessors = SugarNote::accessorHash();
     Q_ASSERT(xml.isStartElement() && xml.name() == "sugarNote");
 
     while (xml.readNextStartElement()) {
 
+        if (xml.name() == PayloadBody::elementName()) {
+            // Version 2.0: the body comes last and is only decoded on demand
+            note.setSerializedBody(PayloadBody::extract(data));
+            break;
+        }
+
         const SugarNote::AccessorHash::const_iterator accessIt = accessors.constFind(xml.name().toString());
         if (accessIt != accessors.constEnd()) {
             (note.*(accessIt.value().setter))(xml.readElementText());
@@ -76,7 +87,7 @@ void SugarNoteIO::readNote(SugarNote &note)
     }
 }
 
-bool SugarNoteIO::writeSugarNote(const SugarNote &note, QIODevice *device)
+bool SugarNoteIO::writeSugarNote(const SugarNote &note, QIODevice *device, bool withBody)
 {
     if (device == 0 || !device->isWritable()) {
         return false;
@@ -87,14 +98,29 @@ bool SugarNoteIO::writeSugarNote(const SugarNote &note, QIODevice *device)
     writer.writeStartDocument();
     writer.writeDTD("<!DOCTYPE sugarNote>");
     writer.writeStartElement("sugarNote");
-    writer.writeAttribute("version", "1.0");
+    writer.writeAttribute("version", "2.0");
 
     const SugarNote::AccessorHash accessors = SugarNote::accessorHash();
     SugarNote::AccessorHash::const_iterator it    = accessors.constBegin();
     SugarNote::AccessorHash::const_iterator endIt = accessors.constEnd();
+    // header: the fields needed for list views, decoded right away
     for (; it != endIt; ++it) {
-        const SugarNote::valueGetter getter = (*it).getter;
-        writer.writeTextElement(it.key(), (note.*getter)());
+        if (!SugarNote::isBodyField(it.key())) {
+            const SugarNote::valueGetter getter = (*it).getter;
+            writer.writeTextElement(it.key(), (note.*getter)());
+        }
+    }
+
+    // body: large fields, decoded only when used
+    if (withBody) {
+        writer.writeStartElement(PayloadBody::elementName());
+        for (it = accessors.constBegin(); it != endIt; ++it) {
+            if (SugarNote::isBodyField(it.key())) {
+                const SugarNote::valueGetter getter = (*it).getter;
+                writer.writeTextElement(it.key(), (note.*getter)());
+            }
+        }
+        writer.writeEndElement();
     }
     writer.writeEndDocument();
 
@@ -34,12 +34,12 @@ class KDCRMDATA_EXPORT SugarNoteIO
 public:
     SugarNoteIO();
     bool readSugarNote(QIODevice *device, SugarNote &note);
-    bool writeSugarNote(const SugarNote &note, QIODevice *device);
+    bool writeSugarNote(const SugarNote &note, QIODevice *device, bool withBody = true);
     QString errorString() const;
 
 private:
     QXmlStreamReader xml;
-    void readNote(SugarNote &note);
+    void readNote(SugarNote &note, const QByteArray &data);
 
 };
 #endif
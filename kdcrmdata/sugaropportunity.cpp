@@ -23,6 +23,7 @@
 #include "sugaropportunity.h"
 #include "kdcrmutils.h"
 #include "kdcrmfields.h"
+#include "payloadbody.h"
 
 #include <KLocalizedString>
 
@@ -35,7 +36,11 @@ class SugarOpportunity::Private : public QSharedData
 {
 public:
     Private()
-        : mEmpty(true)
+        : mEmpty(true),
+          mDateEnteredSecs(KDCRMUtils::InvalidSecsSinceEpoch),
+          mDateModifiedSecs(KDCRMUtils::InvalidSecsSinceEpoch),
+          mDescription(KDCRMFields::description()),
+          mDateClosedSecs(KDCRMUtils::InvalidSecsSinceEpoch)
     {
     }
 
@@ -44,12 +49,13 @@ public:
     QString mId;
     QString mName;
     QString mDateEntered;
-    QDateTime mDateModified;
+    qint64 mDateEnteredSecs; // parsed once, for sorting and filtering
+    qint64 mDateModifiedSecs;
     QString mModifiedUserId;
     QString mModifiedByName;
     QString mCreatedBy;
     QString mCreatedByName;
-    QString mDescription;
+    PayloadBody::LazyField mDescription; // body
     QString mDeleted;
     QString mAssignedUserId;
     QString mAssignedUserName;
@@ -65,10 +71,12 @@ public:
     QString mCurrencyName;
     QString mCurrencySymbol;
     QString mDateClosed;
+    qint64 mDateClosedSecs;
     QString mNextStep;
     QString mSalesStage;
     QString mProbability;
     QDate mNextCallDate;
+
 };
 
 SugarOpportunity::SugarOpportunity()
@@ -105,7 +113,7 @@ bool SugarOpportunity::operator==(const SugarOpportunity &other) const
     if (d->mDateEntered != other.d->mDateEntered) {
         return false;
     }
-    if (d->mDateModified != other.d->mDateModified) {
+    if (d->mDateModifiedSecs != other.d->mDateModifiedSecs) {
         return false;
     }
     if (d->mModifiedUserId != other.d->mModifiedUserId) {
@@ -120,7 +128,7 @@ bool SugarOpportunity::operator==(const SugarOpportunity &other) const
     if (d->mCreatedByName != other.d->mCreatedByName) {
         return false;
     }
-    if (d->mDescription != other.d->mDescription) {
+    if (d->mDescription.value() != other.d->mDescription.value()) {
         return false;
     }
     if (d->mDeleted != other.d->mDeleted) {
@@ -225,6 +233,7 @@ void SugarOpportunity::setDateEntered(const QString &value)
 {
     d->mEmpty = false;
     d->mDateEntered = value;
+    d->mDateEnteredSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarOpportunity::dateEntered() const
@@ -232,20 +241,30 @@ QString SugarOpportunity::dateEntered() const
     return d->mDateEntered;
 }
 
+qint64 SugarOpportunity::dateEnteredSecsSinceEpoch() const
+{
+    return d->mDateEnteredSecs;
+}
+
 QDateTime SugarOpportunity::dateModified() const
 {
-    return d->mDateModified;
+    return KDCRMUtils::dateTimeFromSecsSinceEpoch(d->mDateModifiedSecs);
+}
+
+qint64 SugarOpportunity::dateModifiedSecsSinceEpoch() const
+{
+    return d->mDateModifiedSecs;
 }
 
 void SugarOpportunity::setDateModifiedRaw(const QString &value)
 {
     d->mEmpty = false;
-    d->mDateModified = KDCRMUtils::dateTimeFromString(value);
+    d->mDateModifiedSecs = KDCRMUtils::secsSinceEpochFromDateTimeString(value);
 }
 
 QString SugarOpportunity::dateModifiedRaw() const
 {
-    return KDCRMUtils::dateTimeToString(d->mDateModified);
+    return KDCRMUtils::dateTimeToString(dateModified());
 }
 
 void SugarOpportunity::setModifiedUserId(const QString &value)
@@ -295,12 +314,12 @@ QString SugarOpportunity::createdByName() const
 void SugarOpportunity::setDescription(const QString &value)
 {
     d->mEmpty = false;
-    d->mDescription = value;
+    d->mDescription.setValue(value);
 }
 
 QString SugarOpportunity::description() const
 {
-    return d->mDescription;
+    return d->mDescription.value();
 }
 
 void SugarOpportunity::setDeleted(const QString &value)
@@ -461,6 +480,7 @@ void SugarOpportunity::setDateClosed(const QString &value)
 {
     d->mEmpty = false;
     d->mDateClosed = value;
+    d->mDateClosedSecs = KDCRMUtils::secsSinceEpochFromDateString(value);
 }
 
 QString SugarOpportunity::dateClosed() const
@@ -468,6 +488,11 @@ QString SugarOpportunity::dateClosed() const
     return d->mDateClosed;
 }
 
+qint64 SugarOpportunity::dateClosedSecsSinceEpoch() const
+{
+    return d->mDateClosedSecs;
+}
+
 void SugarOpportunity::setNextStep(const QString &value)
 {
     d->mEmpty = false;
@@ -523,13 +548,13 @@ void SugarOpportunity::setData(const QMap<QString, QString>& data)
 
     d->mId = data.value(KDCRMFields::id());
     d->mName = data.value("name");
-    d->mDateEntered = data.value(KDCRMFields::dateEntered());
-    d->mDateModified = KDCRMUtils::dateTimeFromString(data.value(KDCRMFields::dateModified()));
+    setDateEntered(data.value(KDCRMFields::dateEntered()));
+    setDateModifiedRaw(data.value(KDCRMFields::dateModified()));
     d->mModifiedUserId =  data.value(KDCRMFields::modifiedUserId());
     d->mModifiedByName = data.value(KDCRMFields::modifiedByName());
     d->mCreatedBy = data.value(KDCRMFields::createdBy());
     d->mCreatedByName = data.value(KDCRMFields::createdByName());
-    d->mDescription = data.value(KDCRMFields::description());
+    d->mDescription.setValue(data.value(KDCRMFields::description()));
     d->mDeleted = data.value(KDCRMFields::deleted());
     d->mAssignedUserId = data.value(KDCRMFields::assignedUserId());
     d->mAssignedUserName = data.value(KDCRMFields::assignedUserName());
@@ -544,7 +569,7 @@ void SugarOpportunity::setData(const QMap<QString, QString>& data)
     d->mCurrencyId = data.value(KDCRMFields::currencyId());
     d->mCurrencyName = data.value(KDCRMFields::currencyName());
     d->mCurrencySymbol = data.value(KDCRMFields::currencySymbol());
-    d->mDateClosed = data.value(KDCRMFields::dateClosed());
+    setDateClosed(data.value(KDCRMFields::dateClosed()));
     d->mNextStep = data.value(KDCRMFields::nextStep());
     d->mSalesStage = data.value(KDCRMFields::salesStage());
     d->mProbability = data.value(KDCRMFields::probability());
@@ -557,12 +582,12 @@ QMap<QString, QString> SugarOpportunity::data()
     data[KDCRMFields::id()] = d->mId;
     data["name"] = d->mName;
     data[KDCRMFields::dateEntered()] = d->mDateEntered;
-    data[KDCRMFields::dateModified()] = KDCRMUtils::dateTimeToString(d->mDateModified);
+    data[KDCRMFields::dateModified()] = dateModifiedRaw();
     data[KDCRMFields::modifiedUserId()] = d->mModifiedUserId;
     data[KDCRMFields::modifiedByName()] = d->mModifiedByName;
     data[KDCRMFields::createdBy()] = d->mCreatedBy;
     data[KDCRMFields::createdByName()] = d->mCreatedByName;
-    data[KDCRMFields::description()] = d->mDescription;
+    data[KDCRMFields::description()] = d->mDescription.value();
     data[KDCRMFields::deleted()] = d->mDeleted;
     data[KDCRMFields::assignedUserId()] = d->mAssignedUserId;
     data[KDCRMFields::assignedUserName()] = d->mAssignedUserName;
@@ -585,6 +610,22 @@ QMap<QString, QString> SugarOpportunity::data()
     return data;
 }
 
+void SugarOpportunity::setSerializedBody(const QByteArray &body)
+{
+    d->mEmpty = false;
+    d->mDescription.setSerializedBody(body);
+}
+
+bool SugarOpportunity::hasPendingBody() const
+{
+    return d->mDescription.isPending();
+}
+
+bool SugarOpportunity::isBodyField(const QString &key)
+{
+    return key == KDCRMFields::description();
+}
+
 QString SugarOpportunity::mimeType()
 {
     return QLatin1String("application/x-vnd.kdab.crm.opportunity");
@@ -114,11 +114,21 @@ public:
       Return Creation date.
      */
     QString dateEntered() const;
+    /**
+      Return Creation date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateEnteredSecsSinceEpoch() const;
 
     /**
       Return Modification date.
      */
     QDateTime dateModified() const;
+    /**
+      Return Modification date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateModifiedSecsSinceEpoch() const;
 
     void setDateModifiedRaw(const QString &name);
     QString dateModifiedRaw() const;
@@ -305,6 +315,11 @@ public:
       Return the Closed Date.
      */
     QString dateClosed() const;
+    /**
+      Return the Closed Date, in seconds since 1970-01-01 00:00 UTC,
+      or KDCRMUtils::InvalidSecsSinceEpoch.
+     */
+    qint64 dateClosedSecsSinceEpoch() const;
 
     /**
       Set the Next Step.
@@ -351,6 +366,22 @@ public:
      */
     QMap<QString, QString> data();
 
+    /**
+      Set the serialized body section of the payload, see SugarOpportunityIO.
+      It is only decoded once one of the body fields is accessed.
+     */
+    void setSerializedBody(const QByteArray &body);
+
+    /**
+      Return true if the serialized body hasn't been decoded yet. For unittests.
+     */
+    bool hasPendingBody() const;
+
+    /**
+      Return true if the field @p key is stored in the body section of the payload.
+     */
+    static bool isBodyField(const QString &key);
+
     /**
        Return the Mime type
      */
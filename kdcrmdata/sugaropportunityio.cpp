@@ -22,6 +22,7 @@
 
 #include "sugaropportunityio.h"
 #include "sugaropportunity.h"
+#include "payloadbody.h"
 #include "kdcrmutils.h"
 #include "kdcrmfields.h"
 
@@ -44,13 +45,17 @@ bool SugarOpportunityIO::readSugarOpportunity(QIODevice *device, SugarOpportunit
     }
 
     opportunity = SugarOpportunity();
-    xml.setDevice(device);
+    // read everything at once, so that the body can be kept undecoded
+    const QByteArray data = device->readAll();
+    xml.clear();
+    xml.addData(data);
     if (xml.readNextStartElement()) {
+        const QString version = xml.attributes().value("version").toString();
         if (xml.name() == "sugarOpportunity"
-                && xml.attributes().value("version") == "1.0") {
-            readOpportunity(opportunity);
+                && (version == QLatin1String("2.0") || version == QLatin1String("1.0"))) {
+            readOpportunity(opportunity, data);
         } else {
-            xml.raiseError(i18n("It is not a sugarOpportunity version 1.0 data."));
+            xml.raiseError(i18n("It is not a sugarOpportunity version 1.0 or 2.0 data."));
         }
 
     }
@@ -65,13 +70,19 @@ QString SugarOpportunityIO::errorString() const
            .arg(xml.columnNumber());
 }
 
-void SugarOpportunityIO::readOpportunity(SugarOpportunity &opportunity)
+void SugarOpportunityIO::readOpportunity(SugarOpportunity &opportunity, const QByteArray &data)
 {
     const SugarOpportunity::AccessorHash accessors = SugarOpportunity::accessorHash();
     Q_ASSERT(xml.isStartElement() && xml.name() == "sugarOpportunity");
 
     while (xml.readNextStartElement()) {
 
+        if (xml.name() == PayloadBody::elementName()) {
+            // Version 2.0: the body comes last and is only decoded on demand
+            opportunity.setSerializedBody(PayloadBody::extract(data));
+            break;
+        }
+
         const SugarOpportunity::AccessorHash::const_iterator accessIt = accessors.constFind(xml.name().toString());
         if (accessIt != accessors.constEnd()) {
             (opportunity.*(accessIt.value().setter))(xml.readElementText());
@@ -98,15 +109,28 @@ bool SugarOpportunityIO::writeSugarOpportunity(const SugarOpportunity &opportuni
     writer.writeStartDocument();
     writer.writeDTD("<!DOCTYPE sugarOpportunity>");
     writer.writeStartElement("sugarOpportunity");
-    writer.writeAttribute("version", "1.0");
+    writer.writeAttribute("version", "2.0");
 
     const SugarOpportunity::AccessorHash accessors = SugarOpportunity::accessorHash();
     SugarOpportunity::AccessorHash::const_iterator it    = accessors.constBegin();
     SugarOpportunity::AccessorHash::const_iterator endIt = accessors.constEnd();
+    // header: the fields needed for list views, decoded right away
     for (; it != endIt; ++it) {
-        const SugarOpportunity::valueGetter getter = (*it).getter;
-        writer.writeTextElement(it.key(), (opportunity.*getter)());
+        if (!SugarOpportunity::isBodyField(it.key())) {
+            const SugarOpportunity::valueGetter getter = (*it).getter;
+            writer.writeTextElement(it.key(), (opportunity.*getter)());
+        }
+    }
+
+    // body: large fields, decoded only when used
+    writer.writeStartElement(PayloadBody::elementName());
+    for (it = accessors.constBegin(); it != endIt; ++it) {
+        if (SugarOpportunity::isBodyField(it.key())) {
+            const SugarOpportunity::valueGetter getter = (*it).getter;
+            writer.writeTextElement(it.key(), (opportunity.*getter)());
+        }
     }
+    writer.writeEndElement();
 
     writer.writeEndDocument();
 
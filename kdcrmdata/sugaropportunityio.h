@@ -39,7 +39,7 @@ public:
 
 private:
     QXmlStreamReader xml;
-    void readOpportunity(SugarOpportunity &opportunity);
+    void readOpportunity(SugarOpportunity &opportunity, const QByteArray &data);
 
 };
 
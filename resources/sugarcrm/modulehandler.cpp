@@ -195,9 +195,8 @@ void ModuleHandler::parseFieldList(const TNS__Field_list &fields)
         // Notes: <none>
         Akonadi::Collection coll = collection();
         EnumDefinitionAttribute *attr = coll.attribute<EnumDefinitionAttribute>(Akonadi::Entity::AddIfMissing);
-        const QString serialized = mEnumDefinitions.toString();
-        if (attr->value() != serialized) {
-            attr->setValue(serialized);
+        if (attr->serialized() != mEnumDefinitions.toByteArray()) {
+            attr->setDefinitions(mEnumDefinitions);
             modifyCollection(coll);
         }
     }
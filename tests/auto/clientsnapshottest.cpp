@@ -0,0 +1,205 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "clientsnapshot.h"
+#include "itemstreemodel.h"
+#include "referenceddata.h"
+#include "snapshotmodel.h"
+
+#include <Akonadi/EntityTreeModel>
+#include <Akonadi/Item>
+
+#include <QtTest/QtTestGui>
+#include <QDir>
+#include <QFile>
+#include <QStandardItemModel>
+
+class ClientSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        mFileName = QDir::tempPath() + QLatin1String("/clientsnapshottest-") + QString::number(QCoreApplication::applicationPid());
+    }
+
+    void cleanupTestCase()
+    {
+        QFile::remove(mFileName);
+    }
+
+    void testReferencedData()
+    {
+        ReferencedData *accounts = ReferencedData::instance(AccountRef);
+        accounts->clear();
+        QMap<QString, QString> map;
+        map.insert("a", "KDAB");
+        map.insert("b", QString::fromUtf8("Klarälvdalens Datakonsult"));
+        map.insert("c", QString());
+        accounts->addMap(map, false);
+        ReferencedData::instance(ReportsToRef)->clear();
+
+        ClientSnapshotWriter writer;
+        writer.addReferencedData(AccountRef);
+        writer.addReferencedData(ReportsToRef);
+        QVERIFY(writer.save(mFileName));
+
+        ClientSnapshot snapshot;
+        QVERIFY(snapshot.open(mFileName));
+        QVERIFY(snapshot.isOpen());
+        QCOMPARE(snapshot.referencedData(AccountRef), map);
+        QVERIFY(snapshot.referencedData(ReportsToRef).isEmpty());
+        QVERIFY(snapshot.referencedData(AssignedToRef).isEmpty()); // not saved
+        QCOMPARE(snapshot.rowCount(Account), 0);
+        QCOMPARE(snapshot.text(Account, 0, 0), QString());
+        snapshot.close();
+        QVERIFY(!snapshot.isOpen());
+        accounts->clear();
+    }
+
+    void testItems()
+    {
+        QStandardItemModel model;
+        fillModel(&model);
+
+        ClientSnapshotWriter writer;
+        writer.addItems(Account, &model);
+        QVERIFY(writer.save(mFileName));
+
+        ClientSnapshot snapshot;
+        QVERIFY(snapshot.open(mFileName));
+        QCOMPARE(snapshot.rowCount(Account), 3); // the row without an item is skipped
+        QCOMPARE(snapshot.columnCount(Account), ItemsTreeModel::columnTypes(Account).count());
+        QCOMPARE(snapshot.rowCount(Contact), 0);
+        QCOMPARE(snapshot.remoteId(Account, 0), QString("r-b"));
+        QCOMPARE(snapshot.remoteId(Account, 1), QString("r-a"));
+        QCOMPARE(snapshot.remoteId(Account, 2), QString("r-c"));
+        QCOMPARE(snapshot.remoteId(Account, 3), QString());
+
+        // the strings following odd-sized sort keys are still aligned
+        QCOMPARE(snapshot.text(Account, 0, 0), QString("Beta"));
+        QCOMPARE(snapshot.text(Account, 0, 1), QString("Berlin"));
+        QCOMPARE(snapshot.text(Account, 1, 0), QString::fromUtf8("Älpha"));
+        QCOMPARE(snapshot.text(Account, 1, 1), QString("Athens"));
+        QCOMPARE(snapshot.text(Account, 2, 1), QString("Copenhagen"));
+        QVERIFY(snapshot.text(Account, 2, 2).isEmpty());
+        QCOMPARE(snapshot.text(Account, 0, 6), QString()); // no such column
+
+        QCOMPARE(snapshot.sortKey(Account, 0, 0), QByteArray("\x02"));
+        QCOMPARE(snapshot.sortKey(Account, 1, 0), QByteArray("\x01\x05\x07"));
+        QVERIFY(snapshot.sortKey(Account, 0, 1).isNull()); // no sort key, compared by text
+        QVERIFY(snapshot.referencedData(AccountRef).isEmpty());
+    }
+
+    void testSnapshotModel()
+    {
+        QStandardItemModel model;
+        fillModel(&model);
+        ClientSnapshotWriter writer;
+        writer.addItems(Account, &model);
+        QVERIFY(writer.save(mFileName));
+        QSharedPointer<ClientSnapshot> snapshot(new ClientSnapshot);
+        QVERIFY(snapshot->open(mFileName));
+
+        SnapshotModel snapshotModel(snapshot, Account);
+        QCOMPARE(snapshotModel.rowCount(), 3);
+        QCOMPARE(snapshotModel.columnCount(), ItemsTreeModel::columnTypes(Account).count());
+        QCOMPARE(snapshotModel.index(0, 0).data().toString(), QString("Beta"));
+        QCOMPARE(snapshotModel.index(0, 0).data(ItemsTreeModel::SortKeyRole).toByteArray(), QByteArray("\x02"));
+        QVERIFY(!snapshotModel.index(0, 1).data(ItemsTreeModel::SortKeyRole).isValid());
+        QCOMPARE(snapshotModel.remoteId(3), QString());
+        const QPersistentModelIndex current = snapshotModel.index(1, 0); // r-a
+
+        // by sort keys
+        snapshotModel.sort(0, Qt::DescendingOrder);
+        QCOMPARE(remoteIds(snapshotModel), QStringList() << "r-c" << "r-b" << "r-a");
+        QCOMPARE(current.row(), 2);
+        snapshotModel.sort(0, Qt::AscendingOrder);
+        QCOMPARE(remoteIds(snapshotModel), QStringList() << "r-a" << "r-b" << "r-c");
+        QCOMPARE(current.row(), 0);
+
+        // by text, without sort keys
+        snapshotModel.sort(1, Qt::DescendingOrder);
+        QCOMPARE(remoteIds(snapshotModel), QStringList() << "r-c" << "r-b" << "r-a");
+        QCOMPARE(snapshotModel.index(0, 1).data().toString(), QString("Copenhagen"));
+        QCOMPARE(current.row(), 2);
+
+        // invalid columns are ignored
+        snapshotModel.sort(6);
+        QCOMPARE(remoteIds(snapshotModel), QStringList() << "r-c" << "r-b" << "r-a");
+    }
+
+    void testInvalidFile()
+    {
+        QFile file(mFileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("FCRMSNAP but truncated");
+        file.close();
+
+        ClientSnapshot snapshot;
+        QVERIFY(!snapshot.open(mFileName));
+        QVERIFY(!snapshot.isOpen());
+        QVERIFY(!snapshot.open(mFileName + QLatin1String("-missing")));
+    }
+
+private:
+    static void addRow(QStandardItemModel *model, const QString &remoteId, const QString &name, const QByteArray &nameKey, const QString &city)
+    {
+        QList<QStandardItem *> row;
+        row << new QStandardItem(name) << new QStandardItem(city);
+        const int columns = ItemsTreeModel::columnTypes(Account).count();
+        while (row.count() < columns) {
+            row << new QStandardItem;
+        }
+        if (!remoteId.isEmpty()) {
+            Akonadi::Item item(model->rowCount() + 1);
+            item.setRemoteId(remoteId);
+            row.first()->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+        }
+        if (!nameKey.isNull()) {
+            row.first()->setData(nameKey, ItemsTreeModel::SortKeyRole);
+        }
+        model->appendRow(row);
+    }
+
+    static void fillModel(QStandardItemModel *model)
+    {
+        addRow(model, "r-b", "Beta", QByteArray("\x02"), "Berlin");
+        addRow(model, QString(), "Collection", QByteArray(), QString()); // not an item
+        addRow(model, "r-a", QString::fromUtf8("Älpha"), QByteArray("\x01\x05\x07"), "Athens");
+        addRow(model, "r-c", "Charlie", QByteArray("\x03"), "Copenhagen");
+    }
+
+    static QStringList remoteIds(const SnapshotModel &model)
+    {
+        QStringList ids;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            ids << model.remoteId(row);
+        }
+        return ids;
+    }
+
+    QString mFileName;
+};
+
+QTEST_MAIN(ClientSnapshotTest)
+#include "clientsnapshottest.moc"
@@ -0,0 +1,80 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "accountdetails.h"
+
+#include "kdcrmdata/kdcrmfields.h"
+
+#include <QtTest/QtTest>
+
+typedef QMap<QString, QString> DataMap;
+
+static DataMap accountData(const QString &id, const QString &name)
+{
+    DataMap data;
+    data.insert(KDCRMFields::id(), id);
+    data.insert(KDCRMFields::name(), name);
+    data.insert("website", "http://www." + name.toLower() + ".com");
+    data.insert(KDCRMFields::billingAddressCity(), "Berlin");
+    data.insert("accounting_c", name + " pays on time");
+    return data;
+}
+
+class DetailsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSetGetData()
+    {
+        AccountDetails details;
+        QWidget createdModifiedContainer;
+        const DataMap data = accountData("1", "KDAB");
+        details.setData(data, &createdModifiedContainer);
+
+        const DataMap result = details.getData();
+        QCOMPARE(result.value(KDCRMFields::id()), QString("1"));
+        QCOMPARE(result.value(KDCRMFields::name()), QString("KDAB"));
+        QCOMPARE(result.value("website"), QString("http://www.kdab.com"));
+        QCOMPARE(result.value("accounting_c"), QString("KDAB pays on time")); // a QPlainTextEdit
+        QVERIFY(!result.contains(KDCRMFields::phoneFax())); // not in the expected keys
+
+        details.clear();
+        QVERIFY(details.getData().value(KDCRMFields::name()).isEmpty());
+    }
+
+    // Switching the current item in a list
+    void benchmarkSetData()
+    {
+        AccountDetails details;
+        QWidget createdModifiedContainer;
+        const DataMap first = accountData("1", "KDAB");
+        const DataMap second = accountData("2", "Qt");
+        int i = 0;
+        QBENCHMARK {
+            details.setData((++i % 2) ? first : second, &createdModifiedContainer);
+        }
+    }
+};
+
+QTEST_MAIN(DetailsTest)
+#include "detailstest.moc"
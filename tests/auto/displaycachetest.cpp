@@ -0,0 +1,340 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "displaycache.h"
+#include "filterproxymodel.h"
+#include "itemstreemodel.h"
+#include "referenceddata.h"
+#include "referenceindex.h"
+
+#include "sugaraccount.h"
+
+#include <QtTest/QtTest>
+#include <QAbstractTableModel>
+
+// A table of accounts, similar to what ItemsTreeModel shows:
+// either computing the values from the payload on each call, or reading them from a DisplayCache,
+// optionally with sort keys
+class AccountTableModel : public QAbstractTableModel
+{
+public:
+    enum Column { Name, City, Country, Email, ColumnCount };
+    enum Mode { Payload, Cached, SortKeys };
+
+    AccountTableModel(const QList<SugarAccount> &accounts, Mode mode)
+        : mAccounts(accounts), mCache(ColumnCount), mMode(mode)
+    {
+        if (mMode != Payload) {
+            for (int row = 0; row < mAccounts.count(); ++row) {
+                const int slot = mCache.insert(row);
+                for (int column = 0; column < ColumnCount; ++column) {
+                    mCache.setValue(slot, column, accountData(mAccounts.at(row), column));
+                }
+            }
+        }
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : mAccounts.count();
+    }
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : int(ColumnCount);
+    }
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const
+    {
+        if (role == ItemsTreeModel::SortKeyRole && mMode == SortKeys)
+            return mCache.sortKey(mCache.slot(index.row()), index.column());
+        if (role != Qt::DisplayRole && role != Qt::EditRole)
+            return QVariant();
+        if (mMode != Payload)
+            return mCache.value(mCache.slot(index.row()), index.column(), role);
+        const SugarAccount account = mAccounts.at(index.row());
+        return accountData(account, index.column());
+    }
+
+private:
+    static QVariant accountData(const SugarAccount &account, int column)
+    {
+        switch (column) {
+        case Name:
+            return account.name();
+        case City:
+            return account.shippingAddressCity().isEmpty() ? account.billingAddressCity() : account.shippingAddressCity();
+        case Country:
+            return account.shippingAddressCountry().isEmpty() ? account.billingAddressCountry() : account.shippingAddressCountry();
+        case Email:
+            return account.email1();
+        }
+        return QVariant();
+    }
+
+    QList<SugarAccount> mAccounts;
+    DisplayCache mCache;
+    Mode mMode;
+};
+
+Q_DECLARE_METATYPE(AccountTableModel::Mode)
+
+// The account names of opportunities, cached and refreshed like ItemsTreeModel does
+class OpportunityAccountNames : public QObject
+{
+    Q_OBJECT
+public:
+    OpportunityAccountNames()
+        : mCache(1), mRefs(ReferencedData::instance(AccountRef))
+    {
+        connect(&mRefs, SIGNAL(itemsChanged(QSet<qint64>)), this, SLOT(refresh(QSet<qint64>)));
+    }
+
+    void insert(qint64 id, const QString &accountId)
+    {
+        mAccountIds.insert(id, accountId);
+        mRefs.insert(id, accountId);
+        cacheItem(id);
+    }
+
+    QString name(qint64 id) const { return mCache.value(mCache.slot(id), 0, Qt::DisplayRole).toString(); }
+
+    QSet<qint64> mRefreshed;
+
+private Q_SLOTS:
+    void refresh(const QSet<qint64> &ids)
+    {
+        mRefreshed += ids;
+        foreach (qint64 id, ids) {
+            cacheItem(id);
+        }
+    }
+
+private:
+    void cacheItem(qint64 id)
+    {
+        mCache.setValue(mCache.insert(id), 0, ReferencedData::instance(AccountRef)->referencedData(mAccountIds.value(id)));
+    }
+
+    DisplayCache mCache;
+    ReferenceIndex mRefs;
+    QHash<qint64, QString> mAccountIds;
+};
+
+class DisplayCacheTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void testValues()
+    {
+        DisplayCache cache(2);
+        QCOMPARE(cache.columnCount(), 2);
+        QCOMPARE(cache.slot(42), -1);
+
+        const int slot = cache.insert(42);
+        QCOMPARE(cache.insert(42), slot);
+        QVERIFY(cache.contains(42));
+        cache.setValue(slot, 0, QString("Name"));
+        cache.setValue(slot, 1, QString("2015-03-01"), QDate(2015, 3, 1));
+
+        QCOMPARE(cache.value(slot, 0, Qt::DisplayRole).toString(), QString("Name"));
+        QCOMPARE(cache.value(slot, 0, Qt::EditRole).toString(), QString("Name"));
+        QCOMPARE(cache.value(slot, 1, Qt::DisplayRole).toString(), QString("2015-03-01"));
+        QCOMPARE(cache.value(slot, 1, Qt::EditRole).toDate(), QDate(2015, 3, 1));
+
+        // dropping the edit value falls back to the display value
+        cache.setValue(slot, 1, QString("none"));
+        QCOMPARE(cache.value(slot, 1, Qt::EditRole).toString(), QString("none"));
+    }
+
+    void testSlotReuse()
+    {
+        DisplayCache cache(1);
+        const int first = cache.insert(1);
+        const int second = cache.insert(2);
+        QVERIFY(first != second);
+        cache.setValue(first, 0, QString("one"));
+        cache.setValue(second, 0, QString("two"));
+
+        cache.remove(1);
+        cache.remove(1); // no-op
+        QCOMPARE(cache.count(), 1);
+        QCOMPARE(cache.slot(1), -1);
+
+        const int third = cache.insert(3);
+        QCOMPARE(third, first);
+        QVERIFY(!cache.value(third, 0, Qt::DisplayRole).isValid());
+        QCOMPARE(cache.value(second, 0, Qt::DisplayRole).toString(), QString("two"));
+
+        cache.clear();
+        QCOMPARE(cache.count(), 0);
+        QCOMPARE(cache.slot(2), -1);
+    }
+
+    void testAccountAddedAfterItem()
+    {
+        ReferencedData *accounts = ReferencedData::instance(AccountRef);
+        accounts->clear();
+        OpportunityAccountNames names;
+
+        // opportunities loaded before their account
+        names.insert(1, "acc1");
+        names.insert(2, "acc2");
+        QVERIFY(names.name(1).isEmpty());
+
+        accounts->setReferencedData("acc1", "KDAB");
+        QCOMPARE(names.mRefreshed, QSet<qint64>() << 1);
+        QCOMPARE(names.name(1), QString("KDAB"));
+
+        // a batch, as from the ingestion pipeline
+        names.mRefreshed.clear();
+        QMap<QString, QString> map;
+        map.insert("acc2", "Acme");
+        map.insert("acc3", "Other");
+        accounts->addMap(map, true);
+        QCOMPARE(names.mRefreshed, QSet<qint64>() << 2);
+        QCOMPARE(names.name(2), QString("Acme"));
+
+        // renamed
+        names.mRefreshed.clear();
+        accounts->setReferencedData("acc2", "Acme Corp");
+        QCOMPARE(names.mRefreshed, QSet<qint64>() << 2);
+        QCOMPARE(names.name(2), QString("Acme Corp"));
+
+        // moved to another account: only that one matters now
+        names.mRefreshed.clear();
+        names.insert(2, "acc3");
+        accounts->setReferencedData("acc2", "Acme Inc");
+        QVERIFY(names.mRefreshed.isEmpty());
+        accounts->setReferencedData("acc3", "Other Inc");
+        QCOMPARE(names.mRefreshed, QSet<qint64>() << 2);
+        QCOMPARE(names.name(2), QString("Other Inc"));
+
+        // removed accounts don't leave their name behind
+        names.mRefreshed.clear();
+        accounts->removeReferencedData(QStringList() << "acc1" << "acc2", true);
+        QCOMPARE(names.mRefreshed, QSet<qint64>() << 1);
+        QVERIFY(names.name(1).isEmpty());
+        QCOMPARE(names.name(2), QString("Other Inc"));
+    }
+
+    void testSortKeys()
+    {
+        // invalid first, then chronological
+        const QByteArray invalid = DisplayCache::makeSortKey(QVariant());
+        const QByteArray noDate = DisplayCache::makeSortKey(QDate());
+        const QByteArray oldDate = DisplayCache::makeSortKey(QDate(1969, 7, 20));
+        const QByteArray newDate = DisplayCache::makeSortKey(QDate(2015, 3, 1));
+        QVERIFY(DisplayCache::compareSortKeys(invalid, noDate) < 0);
+        QVERIFY(DisplayCache::compareSortKeys(noDate, oldDate) < 0);
+        QVERIFY(DisplayCache::compareSortKeys(oldDate, newDate) < 0);
+        const QByteArray morning = DisplayCache::makeSortKey(QDateTime(QDate(2015, 3, 1), QTime(9, 0)));
+        const QByteArray evening = DisplayCache::makeSortKey(QDateTime(QDate(2015, 3, 1), QTime(21, 0)));
+        QVERIFY(DisplayCache::compareSortKeys(morning, evening) < 0);
+        QCOMPARE(DisplayCache::compareSortKeys(morning, morning), 0);
+    }
+
+    void testSortKeysOrder()
+    {
+        // Same order as QString::localeAwareCompare(), ties in source order
+        const QList<SugarAccount> accounts = accountCorpus().mid(0, 2000);
+        for (int column = 0; column < AccountTableModel::ColumnCount; ++column) {
+            AccountTableModel compareModel(accounts, AccountTableModel::Cached);
+            FilterProxyModel compareProxy(Account);
+            compareProxy.setSourceModel(&compareModel);
+            compareProxy.setSortRole(Qt::EditRole);
+            compareProxy.sort(column);
+
+            AccountTableModel keyModel(accounts, AccountTableModel::SortKeys);
+            if (keyModel.index(0, column).data(ItemsTreeModel::SortKeyRole).toByteArray().isNull()) {
+                QSKIP("No collation keys on this platform", SkipAll);
+            }
+            FilterProxyModel keyProxy(Account);
+            keyProxy.setSourceModel(&keyModel);
+            keyProxy.setSortRole(Qt::EditRole);
+            keyProxy.sort(column);
+
+            for (int row = 0; row < accounts.count(); ++row) {
+                QCOMPARE(keyProxy.mapToSource(keyProxy.index(row, column)).row(),
+                         compareProxy.mapToSource(compareProxy.index(row, column)).row());
+            }
+        }
+    }
+
+    void benchmarkSort_data()
+    {
+        QTest::addColumn<AccountTableModel::Mode>("mode");
+        QTest::addColumn<int>("column");
+
+        QTest::newRow("payload_name") << AccountTableModel::Payload << int(AccountTableModel::Name);
+        QTest::newRow("cached_name") << AccountTableModel::Cached << int(AccountTableModel::Name);
+        QTest::newRow("sortkeys_name") << AccountTableModel::SortKeys << int(AccountTableModel::Name);
+        QTest::newRow("payload_city") << AccountTableModel::Payload << int(AccountTableModel::City);
+        QTest::newRow("cached_city") << AccountTableModel::Cached << int(AccountTableModel::City);
+        QTest::newRow("sortkeys_city") << AccountTableModel::SortKeys << int(AccountTableModel::City);
+    }
+
+    // Re-sorting 50k accounts, as when clicking on a column header of the accounts page
+    void benchmarkSort()
+    {
+        QFETCH(AccountTableModel::Mode, mode);
+        QFETCH(int, column);
+
+        AccountTableModel model(accountCorpus(), mode);
+        FilterProxyModel proxy(Account);
+        proxy.setSourceModel(&model);
+        proxy.setSortRole(Qt::EditRole);
+        proxy.setDynamicSortFilter(false);
+
+        QBENCHMARK {
+            proxy.sort(column, Qt::AscendingOrder);
+            proxy.sort(column, Qt::DescendingOrder);
+        }
+        QCOMPARE(proxy.rowCount(), 50000);
+    }
+
+private:
+    // 50k accounts, as in a large SugarCRM installation
+    static QList<SugarAccount> accountCorpus()
+    {
+        static const char *cities[] = { "Berlin", "Stockholm", "Paris", "Houston", "Oslo", "Torino" };
+        const int cityCount = sizeof(cities) / sizeof(*cities);
+        QList<SugarAccount> accounts;
+        accounts.reserve(50000);
+        for (int i = 0; i < 50000; ++i) {
+            SugarAccount account;
+            // spread the names so that the sort isn't trivially presorted
+            account.setName(QString::fromLatin1("Account %1").arg((i * 7919) % 50000));
+            if (i % 2)
+                account.setShippingAddressCity(QLatin1String(cities[i % cityCount]));
+            account.setBillingAddressCity(QLatin1String(cities[(i / 3) % cityCount]));
+            account.setBillingAddressCountry(QLatin1String("Germany"));
+            account.setEmail1(QString::fromLatin1("info%1@example.com").arg(i));
+            accounts.append(account);
+        }
+        return accounts;
+    }
+};
+
+QTEST_MAIN(DisplayCacheTest)
+#include "displaycachetest.moc"
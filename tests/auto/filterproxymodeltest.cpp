@@ -0,0 +1,163 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filterproxymodel.h"
+
+#include "sugaraccount.h"
+
+#include <Akonadi/EntityTreeModel>
+#include <Akonadi/Item>
+
+#include <QtTest/QtTestGui>
+#include <QStandardItemModel>
+
+static const char *s_cities[] = { "Berlin", "Stockholm", "Paris", "Houston", "Oslo", "Torino" };
+
+class FilterProxyModelTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testAsyncFilter_data()
+    {
+        QTest::addColumn<QStringList>("filters"); // set one after the other, without waiting
+        QTest::addColumn<QString>("finalFilter");
+
+        QTest::newRow("name") << QStringList() << "Account 12";
+        QTest::newRow("city") << QStringList() << "berlin";
+        QTest::newRow("no_match") << QStringList() << "nowhere";
+        QTest::newRow("extended_during_job") << (QStringList() << "acc") << "account 3";
+        QTest::newRow("shortened_during_job") << (QStringList() << "account 42") << "account 4";
+        QTest::newRow("replaced_during_job") << (QStringList() << "paris") << "oslo";
+        QTest::newRow("cleared_during_job") << (QStringList() << "houston") << "";
+    }
+
+    void testAsyncFilter()
+    {
+        QFETCH(QStringList, filters);
+        QFETCH(QString, finalFilter);
+
+        // a few chunks of rows
+        QStandardItemModel sourceModel;
+        fillModel(&sourceModel, 5000);
+
+        FilterProxyModel syncProxy(Account);
+        syncProxy.setSourceModel(&sourceModel);
+        syncProxy.setFilterString(finalFilter);
+
+        FilterProxyModel asyncProxy(Account);
+        asyncProxy.setAsyncFilterThreshold(0);
+        asyncProxy.setSourceModel(&sourceModel);
+        foreach (const QString &filter, filters) {
+            asyncProxy.setFilterString(filter);
+        }
+        asyncProxy.setFilterString(finalFilter);
+        asyncProxy.waitForFilter();
+
+        QCOMPARE(acceptedRows(asyncProxy), acceptedRows(syncProxy));
+        QCOMPARE(asyncProxy.rowCount(), expectedCount(sourceModel, finalFilter));
+    }
+
+    void testAsyncFilterWithChanges()
+    {
+        QStandardItemModel sourceModel;
+        fillModel(&sourceModel, 5000);
+        FilterProxyModel asyncProxy(Account);
+        asyncProxy.setAsyncFilterThreshold(0);
+        asyncProxy.setSourceModel(&sourceModel);
+        asyncProxy.setFilterString("stockholm");
+
+        // rows changed, inserted and removed while the job is running are evaluated directly
+        sourceModel.item(0)->setData(QVariant::fromValue(accountItem(0, "Stockholm")), Akonadi::EntityTreeModel::ItemRole);
+        sourceModel.appendRow(accountRow(5000, "Stockholm"));
+        sourceModel.insertRow(0, accountRow(5001, "Stockholm"));
+        sourceModel.removeRows(10, 20);
+        asyncProxy.waitForFilter();
+
+        FilterProxyModel syncProxy(Account);
+        syncProxy.setSourceModel(&sourceModel);
+        syncProxy.setFilterString("stockholm");
+        QCOMPARE(acceptedRows(asyncProxy), acceptedRows(syncProxy));
+        QCOMPARE(asyncProxy.rowCount(), expectedCount(sourceModel, "stockholm"));
+
+        // and after the result was applied, including moved rows
+        sourceModel.removeRows(100, 50);
+        sourceModel.insertRow(7, accountRow(5002, "Stockholm"));
+        sourceModel.sort(0, Qt::DescendingOrder);
+        QCOMPARE(acceptedRows(asyncProxy), acceptedRows(syncProxy));
+        QCOMPARE(asyncProxy.rowCount(), expectedCount(sourceModel, "stockholm"));
+    }
+
+private:
+    static Akonadi::Item accountItem(int i, const char *city)
+    {
+        SugarAccount account;
+        account.setName(QString::fromLatin1("Account %1").arg(i));
+        account.setBillingAddressCity(QLatin1String(city));
+        Akonadi::Item item(i + 1);
+        item.setMimeType(SugarAccount::mimeType());
+        item.setPayload<SugarAccount>(account);
+        return item;
+    }
+
+    static QStandardItem *accountRow(int i, const char *city)
+    {
+        const Akonadi::Item item = accountItem(i, city);
+        QStandardItem *row = new QStandardItem(item.payload<SugarAccount>().name());
+        row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+        row->setData(item.id(), Akonadi::EntityTreeModel::ItemIdRole);
+        return row;
+    }
+
+    static void fillModel(QStandardItemModel *model, int count)
+    {
+        const int cityCount = sizeof(s_cities) / sizeof(*s_cities);
+        for (int i = 0; i < count; ++i) {
+            model->appendRow(accountRow(i, s_cities[i % cityCount]));
+        }
+    }
+
+    static QList<int> acceptedRows(const FilterProxyModel &proxy)
+    {
+        QList<int> rows;
+        for (int row = 0; row < proxy.rowCount(); ++row) {
+            rows.append(proxy.mapToSource(proxy.index(row, 0)).row());
+        }
+        qSort(rows);
+        return rows;
+    }
+
+    // The filter, evaluated naively
+    static int expectedCount(const QStandardItemModel &model, const QString &filter)
+    {
+        int count = 0;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            const Akonadi::Item item = model.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            const SugarAccount account = item.payload<SugarAccount>();
+            if (account.name().contains(filter, Qt::CaseInsensitive) || account.billingAddressCity().contains(filter, Qt::CaseInsensitive))
+                ++count;
+        }
+        return count;
+    }
+};
+
+QTEST_MAIN(FilterProxyModelTest)
+#include "filterproxymodeltest.moc"
@@ -0,0 +1,96 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ingestionpipeline.h"
+#include "accountrepository.h"
+#include "referenceddata.h"
+
+#include "sugaraccount.h"
+
+#include <QtTest/QtTest>
+
+class IngestionPipelineTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        ReferencedData::clearAll();
+        AccountRepository::instance()->clear();
+    }
+
+    void testInsertAndRemove()
+    {
+        IngestionPipeline pipeline(Account);
+        QSignalSpy spyIdle(&pipeline, SIGNAL(idle()));
+        QSignalSpy spyPublishing(&pipeline, SIGNAL(publishing(bool)));
+
+        pipeline.addItems(IngestionPipeline::Insert, Akonadi::Item::List() << accountItem("a", "KDAB", "Sweden") << accountItem("b", "Acme", "France"), false);
+        pipeline.addItems(IngestionPipeline::Insert, Akonadi::Item::List() << accountItem("c", "Foo", " Germany "), false); // queued while the first batch is running
+        QVERIFY(!pipeline.isIdle());
+        pipeline.waitForIdle();
+        QVERIFY(pipeline.isIdle());
+        QCOMPARE(spyIdle.count(), 1);
+        QVERIFY(spyPublishing.count() >= 2);
+        QCOMPARE(spyPublishing.last().at(0).toBool(), false);
+
+        QCOMPARE(ReferencedData::instance(AccountRef)->count(), 3);
+        QCOMPARE(ReferencedData::instance(AccountRef)->referencedData("b"), QString("Acme"));
+        QCOMPARE(ReferencedData::instance(AccountCountryRef)->referencedData("c"), QString("Germany"));
+        QCOMPARE(AccountRepository::instance()->accountById("a").name(), QString("KDAB"));
+
+        // published in the order they were queued
+        pipeline.addItems(IngestionPipeline::Update, Akonadi::Item::List() << accountItem("a", "KDAB AB", "Sweden"), true);
+        pipeline.addItems(IngestionPipeline::Remove, Akonadi::Item::List() << accountItem("b", "Acme", "France"), true);
+        pipeline.addItems(IngestionPipeline::Insert, Akonadi::Item::List() << accountItem("b", "Acme Corp", "France"), true);
+        pipeline.waitForIdle();
+        QCOMPARE(ReferencedData::instance(AccountRef)->referencedData("a"), QString("KDAB AB"));
+        QCOMPARE(ReferencedData::instance(AccountRef)->referencedData("b"), QString("Acme Corp"));
+        QCOMPARE(AccountRepository::instance()->accountById("b").name(), QString("Acme Corp"));
+    }
+
+    void testClear()
+    {
+        IngestionPipeline pipeline(Account);
+        pipeline.addItems(IngestionPipeline::Insert, Akonadi::Item::List() << accountItem("a", "KDAB", "Sweden"), false);
+        pipeline.clear();
+        pipeline.waitForIdle();
+        QCOMPARE(ReferencedData::instance(AccountRef)->count(), 0);
+        QVERIFY(AccountRepository::instance()->accountById("a").id().isEmpty());
+    }
+
+private:
+    static Akonadi::Item accountItem(const QString &id, const QString &name, const QString &country)
+    {
+        SugarAccount account;
+        account.setId(id);
+        account.setName(name);
+        account.setBillingAddressCountry(country);
+        Akonadi::Item item;
+        item.setMimeType(SugarAccount::mimeType());
+        item.setPayload<SugarAccount>(account);
+        return item;
+    }
+};
+
+QTEST_MAIN(IngestionPipelineTest)
+#include "ingestionpipelinetest.moc"
@@ -24,6 +24,7 @@
 
 #include <QtTest/QtTest>
 #include <QDebug>
+#include <QStringList>
 
 class KDCRMUtilsTest : public QObject
 {
@@ -50,6 +51,146 @@ private Q_SLOTS:
         KDCRMUtils::incrementTimeStamp(str);
         QCOMPARE(str, output);
     }
+
+    void testSecsSinceEpoch_data()
+    {
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<bool>("valid");
+
+        QTest::newRow("epoch") << "1970-01-01 00:00:00" << true;
+        QTest::newRow("normal") << "2015-06-26 21:39:28" << true;
+        QTest::newRow("leap_day") << "2016-02-29 23:59:59" << true;
+        QTest::newRow("before_epoch") << "1969-12-31 23:59:59" << true;
+        QTest::newRow("no_leap_day") << "2015-02-29 10:00:00" << false;
+        QTest::newRow("bad_month") << "2015-13-01 10:00:00" << false;
+        QTest::newRow("bad_hour") << "2015-06-26 24:00:00" << false;
+        QTest::newRow("iso") << "2015-06-26T21:39:28" << false;
+        QTest::newRow("date_only") << "2015-06-26" << false;
+        QTest::newRow("empty") << "" << false;
+    }
+
+    void testSecsSinceEpoch()
+    {
+        QFETCH(QString, input);
+        QFETCH(bool, valid);
+
+        const qint64 secs = KDCRMUtils::secsSinceEpochFromDateTimeString(input);
+        QDateTime expected = QDateTime::fromString(input, QLatin1String("yyyy-MM-dd hh:mm:ss"));
+        expected.setTimeSpec(Qt::UTC);
+        QCOMPARE(secs != KDCRMUtils::InvalidSecsSinceEpoch, valid);
+        QCOMPARE(expected.isValid(), valid);
+        QCOMPARE(KDCRMUtils::dateTimeFromSecsSinceEpoch(secs), expected);
+        QCOMPARE(KDCRMUtils::dateFromSecsSinceEpoch(secs), expected.date());
+        if (valid) {
+            if (secs >= 0) {
+                QCOMPARE(secs, qint64(expected.toTime_t()));
+            }
+            QCOMPARE(KDCRMUtils::secsSinceEpochFromDateString(input.left(10)),
+                     KDCRMUtils::secsSinceEpochFromDate(expected.date()));
+        }
+    }
+
+    void testEncodeXML_data()
+    {
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<QString>("output");
+
+        QTest::newRow("empty") << "" << "";
+        QTest::newRow("plain") << "KDAB, Inc." << "KDAB, Inc.";
+        QTest::newRow("all") << "&<>'\"" << "&amp;&lt;&gt;&#039;&quot;";
+        QTest::newRow("mixed") << "Foo & Bar <bar> \"it's\"" << "Foo &amp; Bar &lt;bar&gt; &quot;it&#039;s&quot;";
+        QTest::newRow("long") << QString(100, QLatin1Char('a')) + '<' + QString(100, QLatin1Char('b'))
+                              << QString(100, QLatin1Char('a')) + "&lt;" + QString(100, QLatin1Char('b'));
+        QTest::newRow("many") << QString(50, QLatin1Char('&')) << QString("&amp;").repeated(50);
+    }
+
+    void testEncodeXML()
+    {
+        QFETCH(QString, input);
+        QFETCH(QString, output);
+
+        QCOMPARE(KDCRMUtils::encodeXML(input), output);
+        QCOMPARE(KDCRMUtils::decodeXML(output), input.trimmed());
+    }
+
+    void testDecodeXML_data()
+    {
+        QTest::addColumn<QString>("input");
+        QTest::addColumn<QString>("output");
+
+        QTest::newRow("empty") << "" << "";
+        QTest::newRow("plain") << "  Germany " << "Germany";
+        QTest::newRow("all") << "&quot;&#039;&gt;&lt;&amp;" << "\"'><&";
+        QTest::newRow("double_escaped") << "&amp;gt;" << "&gt;";
+        QTest::newRow("unknown_entity") << "&apos; &nbsp;" << "&apos; &nbsp;";
+        QTest::newRow("truncated") << "a &am" << "a &am";
+        QTest::newRow("trim") << " &lt;b&gt; " << "<b>";
+    }
+
+    void testDecodeXML()
+    {
+        QFETCH(QString, input);
+        QFETCH(QString, output);
+
+        QCOMPARE(KDCRMUtils::decodeXML(input), output);
+    }
+
+    void benchmarkEncodeXML_data()
+    {
+        QTest::addColumn<bool>("escaping");
+
+        QTest::newRow("nothing_to_escape") << false;
+        QTest::newRow("escaping") << true;
+    }
+
+    void benchmarkEncodeXML()
+    {
+        QFETCH(bool, escaping);
+        const QStringList values = sampleValues(escaping);
+        QBENCHMARK {
+            foreach (const QString &value, values) {
+                KDCRMUtils::encodeXML(value);
+            }
+        }
+    }
+
+    void benchmarkDecodeXML_data()
+    {
+        QTest::addColumn<bool>("escaping");
+
+        QTest::newRow("nothing_to_unescape") << false;
+        QTest::newRow("unescaping") << true;
+    }
+
+    void benchmarkDecodeXML()
+    {
+        QFETCH(bool, escaping);
+        QStringList values = sampleValues(escaping);
+        for (int i = 0; i < values.count(); ++i) {
+            values[i] = KDCRMUtils::encodeXML(values.at(i));
+        }
+        QBENCHMARK {
+            foreach (const QString &value, values) {
+                KDCRMUtils::decodeXML(value);
+            }
+        }
+    }
+
+private:
+    // Typical field values of a sync, e.g. names, ids and dates
+    static QStringList sampleValues(bool withSpecialChars)
+    {
+        QStringList values;
+        for (int i = 0; i < 10000; ++i) {
+            values << QString::fromLatin1("Customer %1 GmbH").arg(i)
+                   << QString::fromLatin1("1c2b3a4d-%1-5e6f-7a8b-9c0d1e2f3a4b").arg(i, 4, 10, QLatin1Char('0'))
+                   << QString::fromLatin1("2015-06-26 21:39:28");
+            if (withSpecialChars) {
+                values << QString::fromLatin1("Smith & Sons <sales@example.com> \"it's %1\"").arg(i);
+            }
+        }
+        return values;
+    }
 };
 
 QTEST_MAIN(KDCRMUtilsTest)
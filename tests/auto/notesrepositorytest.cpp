@@ -0,0 +1,181 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "notesrepository.h"
+
+#include <Akonadi/Collection>
+#include <Akonadi/Item>
+
+#include <QtTest/QtTest>
+
+static const Akonadi::Collection::Id s_notesCollectionId = 10;
+static const Akonadi::Collection::Id s_emailsCollectionId = 11;
+
+static Akonadi::Item noteItem(Akonadi::Item::Id id, const QString &opportunityId, const QString &description)
+{
+    SugarNote note;
+    note.setId(QString::fromLatin1("note-%1").arg(id));
+    note.setName(QString::fromLatin1("Note %1").arg(id));
+    note.setParentType(QLatin1String("Opportunities"));
+    note.setParentId(opportunityId);
+    note.setDescription(description);
+    Akonadi::Item item(id);
+    item.setMimeType(SugarNote::mimeType());
+    item.setPayload(note);
+    return item;
+}
+
+static Akonadi::Item emailItem(Akonadi::Item::Id id, const QString &opportunityId, const QString &description)
+{
+    SugarEmail email;
+    email.setId(QString::fromLatin1("email-%1").arg(id));
+    email.setName(QString::fromLatin1("Email %1").arg(id));
+    email.setParentType(QLatin1String("Opportunities"));
+    email.setParentId(opportunityId);
+    email.setDescription(description);
+    Akonadi::Item item(id);
+    item.setMimeType(SugarEmail::mimeType());
+    item.setPayload(email);
+    return item;
+}
+
+class NotesRepositoryTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void testChangesByCollection()
+    {
+        NotesRepository repo;
+        repo.setNotesCollection(Akonadi::Collection(s_notesCollectionId));
+        repo.setEmailsCollection(Akonadi::Collection(s_emailsCollectionId));
+
+        // what the monitor delivers
+        itemAdded(repo, noteItem(1, "opp-1", "First note"), s_notesCollectionId);
+        itemAdded(repo, emailItem(2, "opp-1", "First email"), s_emailsCollectionId);
+        itemAdded(repo, noteItem(3, "opp-2", "Elsewhere"), 99); // not ours
+        QCOMPARE(repo.countForOpportunity("opp-1"), 2);
+        QCOMPARE(repo.countForOpportunity("opp-2"), 0);
+
+        // only the headers are kept, the bodies are fetched on demand
+        QVERIFY(!repo.hasBodies("opp-1"));
+        const QVector<SugarNote> notes = repo.notesForOpportunity("opp-1");
+        QCOMPARE(notes.count(), 1);
+        QCOMPARE(notes.at(0).description(), QString::fromLatin1("First note"));
+        const QVector<SugarEmail> emails = repo.emailsForOpportunity("opp-1");
+        QCOMPARE(emails.count(), 1);
+        QCOMPARE(emails.at(0).description(), QString::fromLatin1("First email"));
+
+        // changes are told apart by payload
+        itemChanged(repo, emailItem(2, "opp-1", "Edited email"));
+        QCOMPARE(repo.countForOpportunity("opp-1"), 2);
+        QCOMPARE(repo.emailsForOpportunity("opp-1").at(0).description(), QString::fromLatin1("Edited email"));
+        QCOMPARE(repo.notesForOpportunity("opp-1").at(0).description(), QString::fromLatin1("First note"));
+
+        itemRemoved(repo, 1);
+        QCOMPARE(repo.countForOpportunity("opp-1"), 1);
+        QVERIFY(repo.notesForOpportunity("opp-1").isEmpty());
+        itemRemoved(repo, 2);
+        QCOMPARE(repo.countForOpportunity("opp-1"), 0);
+    }
+
+    void testIndex()
+    {
+        NotesRepository repo;
+        repo.setNotesCollection(Akonadi::Collection(s_notesCollectionId));
+        for (int id = 1; id <= 4; ++id) {
+            itemAdded(repo, noteItem(id, "opp-1", "Note"), s_notesCollectionId);
+        }
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1" << "note-2" << "note-3" << "note-4");
+
+        // changed in place
+        itemChanged(repo, noteItem(2, "opp-1", "Changed"));
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1" << "note-2" << "note-3" << "note-4");
+        QCOMPARE(description(repo, "opp-1", "note-2"), QString::fromLatin1("Changed"));
+
+        // moved to another opportunity, from a middle slot
+        itemChanged(repo, noteItem(2, "opp-2", "Moved"));
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1" << "note-3" << "note-4");
+        QCOMPARE(noteIds(repo, "opp-2"), QStringList() << "note-2");
+        QCOMPARE(description(repo, "opp-2", "note-2"), QString::fromLatin1("Moved"));
+
+        // removing a middle slot moves the last item into it, which can still be found
+        itemRemoved(repo, 4);
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1" << "note-3");
+        itemChanged(repo, noteItem(3, "opp-1", "Changed too"));
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1" << "note-3");
+        QCOMPARE(description(repo, "opp-1", "note-3"), QString::fromLatin1("Changed too"));
+        QCOMPARE(description(repo, "opp-1", "note-1"), QString::fromLatin1("Note"));
+
+        // removing the last slot, then the only one
+        itemRemoved(repo, 3);
+        QCOMPARE(noteIds(repo, "opp-1"), QStringList() << "note-1");
+        itemRemoved(repo, 1);
+        QVERIFY(noteIds(repo, "opp-1").isEmpty());
+        QCOMPARE(repo.countForOpportunity("opp-1"), 0);
+
+        itemRemoved(repo, 1); // unknown by now
+        itemRemoved(repo, 42);
+        QCOMPARE(repo.countForOpportunity("opp-2"), 1);
+    }
+
+private:
+    // in no particular order, see NotesRepository::notesForOpportunity()
+    static QStringList noteIds(NotesRepository &repo, const QString &opportunityId)
+    {
+        QStringList ids;
+        foreach (const SugarNote &note, repo.notesForOpportunity(opportunityId)) {
+            ids.append(note.id());
+        }
+        ids.sort();
+        return ids;
+    }
+
+    static QString description(NotesRepository &repo, const QString &opportunityId, const QString &noteId)
+    {
+        foreach (const SugarNote &note, repo.notesForOpportunity(opportunityId)) {
+            if (note.id() == noteId) {
+                return note.description();
+            }
+        }
+        return QString();
+    }
+
+    static void itemAdded(NotesRepository &repo, const Akonadi::Item &item, Akonadi::Collection::Id collectionId)
+    {
+        QVERIFY(QMetaObject::invokeMethod(&repo, "slotItemAdded", Qt::DirectConnection,
+                                          Q_ARG(Akonadi::Item, item), Q_ARG(Akonadi::Collection, Akonadi::Collection(collectionId))));
+    }
+
+    static void itemChanged(NotesRepository &repo, const Akonadi::Item &item)
+    {
+        QVERIFY(QMetaObject::invokeMethod(&repo, "slotItemChanged", Qt::DirectConnection, Q_ARG(Akonadi::Item, item)));
+    }
+
+    static void itemRemoved(NotesRepository &repo, Akonadi::Item::Id id)
+    {
+        QVERIFY(QMetaObject::invokeMethod(&repo, "slotItemRemoved", Qt::DirectConnection, Q_ARG(Akonadi::Item, Akonadi::Item(id))));
+    }
+};
+
+QTEST_MAIN(NotesRepositoryTest)
+#include "notesrepositorytest.moc"
@@ -0,0 +1,197 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "opportunityfilterproxymodel.h"
+#include "opportunityfiltersettings.h"
+#include "referenceddata.h"
+#include "enums.h"
+
+#include "sugaropportunity.h"
+
+#include <Akonadi/EntityTreeModel>
+#include <Akonadi/Item>
+
+#include <QtTest/QtTestGui>
+#include <QEventLoop>
+#include <QStandardItemModel>
+#include <QTimer>
+
+Q_DECLARE_METATYPE(OpportunityFilterSettings)
+
+static const char *s_assignees[] = { "David Faure", "Sabine Faure", "Kevin Krammer", "Michel Boyer" };
+static const char *s_countries[] = { "Germany", "France", "Sweden", "United States", "" };
+
+class OpportunityFilterProxyModelTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void initTestCase()
+    {
+        ReferencedData *countries = ReferencedData::instance(AccountCountryRef);
+        for (int i = 0; i < 50; ++i) {
+            countries->setReferencedData(accountId(i), QString::fromLatin1(s_countries[i % 5]));
+        }
+    }
+
+    void testFilter_data()
+    {
+        QTest::addColumn<OpportunityFilterSettings>("settings");
+        QTest::addColumn<int>("count");
+
+        QTest::newRow("default_sync") << OpportunityFilterSettings() << 1000;
+        QTest::newRow("default_async") << OpportunityFilterSettings() << 30000;
+
+        OpportunityFilterSettings settings;
+        settings.setShowOpenClosed(false, true);
+        QTest::newRow("closed") << settings << 1000;
+        settings.setShowOpenClosed(true, true);
+        QTest::newRow("open_and_closed") << settings << 1000;
+
+        settings.setAssignees(QStringList() << "David Faure" << "Kevin Krammer" << "Nobody", "Some people");
+        QTest::newRow("assignees_sync") << settings << 1000;
+        QTest::newRow("assignees_async") << settings << 30000;
+
+        settings = OpportunityFilterSettings();
+        settings.setCountries(QStringList() << "germany" << "SWEDEN", "Some countries");
+        QTest::newRow("countries_case_insensitive") << settings << 1000;
+
+        settings = OpportunityFilterSettings();
+        settings.setMaxDate(QDate(2015, 1, 20), 1);
+        QTest::newRow("max_date") << settings << 1000;
+
+        settings = OpportunityFilterSettings();
+        settings.setShowOpenClosed(true, true);
+        settings.setModifiedAfter(QDate(2015, 3, 5));
+        settings.setModifiedBefore(QDate(2015, 3, 20));
+        QTest::newRow("modified_range_sync") << settings << 1000;
+        QTest::newRow("modified_range_async") << settings << 30000;
+    }
+
+    void testFilter()
+    {
+        QFETCH(OpportunityFilterSettings, settings);
+        QFETCH(int, count);
+
+        QStandardItemModel sourceModel;
+        fillModel(&sourceModel, count);
+        OpportunityFilterProxyModel proxy;
+        proxy.setSourceModel(&sourceModel);
+
+        setFilterAndWait(&proxy, settings, count);
+        QCOMPARE(proxy.rowCount(), expectedCount(sourceModel, settings));
+    }
+
+    void benchmarkSetFilter()
+    {
+        // Switching between two saved filters, with 30k opportunities
+        QStandardItemModel sourceModel;
+        fillModel(&sourceModel, 30000);
+        OpportunityFilterProxyModel proxy;
+        proxy.setSourceModel(&sourceModel);
+
+        OpportunityFilterSettings mine;
+        mine.setAssignees(QStringList() << "David Faure", "Me");
+        mine.setMaxDate(QDate(2015, 2, 1), 1);
+        OpportunityFilterSettings countries;
+        countries.setCountries(QStringList() << "France" << "Germany", "Some countries");
+        countries.setShowOpenClosed(true, true);
+
+        QBENCHMARK {
+            setFilterAndWait(&proxy, mine, 30000);
+            setFilterAndWait(&proxy, countries, 30000);
+        }
+        QCOMPARE(proxy.rowCount(), expectedCount(sourceModel, countries));
+    }
+
+private:
+    static QString accountId(int i)
+    {
+        return QString::fromLatin1("account-%1").arg(i);
+    }
+
+    static void fillModel(QStandardItemModel *model, int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            SugarOpportunity opportunity;
+            opportunity.setName(QString::fromLatin1("Opportunity %1").arg(i));
+            opportunity.setAssignedUserName(QString::fromLatin1(s_assignees[i % 4]));
+            opportunity.setAccountId(accountId(i % 50));
+            opportunity.setSalesStage(i % 3 == 0 ? QString("Closed Won") : QString("Prospecting"));
+            if (i % 7 != 0) {
+                opportunity.setNextCallDateRaw(QDate(2015, 1, 1).addDays(i % 60).toString(Qt::ISODate));
+            }
+            opportunity.setDateModifiedRaw(QDate(2015, 3, 1).addDays(i % 30).toString(Qt::ISODate) + QLatin1String(" 12:00:00"));
+
+            Akonadi::Item item(i + 1);
+            item.setMimeType(SugarOpportunity::mimeType());
+            item.setPayload<SugarOpportunity>(opportunity);
+
+            QStandardItem *row = new QStandardItem(opportunity.name());
+            row->setData(QVariant::fromValue(item), Akonadi::EntityTreeModel::ItemRole);
+            row->setData(item.id(), Akonadi::EntityTreeModel::ItemIdRole);
+            model->appendRow(row);
+        }
+    }
+
+    // Large models are filtered asynchronously, the result is applied with a layout change
+    static void setFilterAndWait(OpportunityFilterProxyModel *proxy, const OpportunityFilterSettings &settings, int count)
+    {
+        QEventLoop loop;
+        connect(proxy, SIGNAL(layoutChanged()), &loop, SLOT(quit()));
+        proxy->setFilter(settings);
+        if (count >= 10000) {
+            QTimer::singleShot(10000, &loop, SLOT(quit()));
+            loop.exec();
+        }
+    }
+
+    // The semantics of OpportunityFilterSettings, evaluated naively
+    static int expectedCount(const QStandardItemModel &model, const OpportunityFilterSettings &settings)
+    {
+        int count = 0;
+        for (int row = 0; row < model.rowCount(); ++row) {
+            const Akonadi::Item item = model.index(row, 0).data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            const SugarOpportunity opportunity = item.payload<SugarOpportunity>();
+            if (!settings.assignees().isEmpty() && !settings.assignees().contains(opportunity.assignedUserName()))
+                continue;
+            const QString country = ReferencedData::instance(AccountCountryRef)->referencedData(opportunity.accountId());
+            if (!settings.countries().isEmpty() && !settings.countries().contains(country, Qt::CaseInsensitive))
+                continue;
+            const bool closed = opportunity.salesStage().contains("Closed");
+            if (closed ? !settings.showClosed() : !settings.showOpen())
+                continue;
+            if (settings.maxDate().isValid() && (!opportunity.nextCallDate().isValid() || opportunity.nextCallDate() > settings.maxDate()))
+                continue;
+            const QDate modified = opportunity.dateModified().date();
+            if (settings.modifiedAfter().isValid() && modified < settings.modifiedAfter())
+                continue;
+            if (settings.modifiedBefore().isValid() && modified > settings.modifiedBefore())
+                continue;
+            ++count;
+        }
+        return count;
+    }
+};
+
+QTEST_MAIN(OpportunityFilterProxyModelTest)
+#include "opportunityfilterproxymodeltest.moc"
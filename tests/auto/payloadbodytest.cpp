@@ -0,0 +1,247 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "payloadbody.h"
+#include "sugaremail.h"
+#include "sugaremailio.h"
+#include "sugarnote.h"
+#include "sugarnoteio.h"
+#include "sugaropportunity.h"
+#include "sugaropportunityio.h"
+
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QFuture>
+#include <QtConcurrentRun>
+
+// special characters, to check that the body is escaped and unescaped
+static QString longDescription()
+{
+    return QString::fromUtf8("Call back <b>Mr. Müller</b> & ask about \"the order\"\nSecond line </body> third line");
+}
+
+static QByteArray writeNote(const SugarNote &note, bool withBody)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    SugarNoteIO io;
+    if (!io.writeSugarNote(note, &buffer, withBody))
+        return QByteArray();
+    return data;
+}
+
+static SugarNote readNote(const QByteArray &data)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    SugarNoteIO io;
+    SugarNote note;
+    if (!io.readSugarNote(&buffer, note))
+        qWarning() << io.errorString();
+    return note;
+}
+
+static SugarNote testNote()
+{
+    SugarNote note;
+    note.setId(QLatin1String("note-1"));
+    note.setName(QLatin1String("Phone call"));
+    note.setParentType(QLatin1String("Opportunities"));
+    note.setParentId(QLatin1String("opp-1"));
+    note.setDescription(longDescription());
+    return note;
+}
+
+// what the detail views do with a payload shared with the list
+static QString copyAndReadDescription(const SugarNote &note)
+{
+    SugarNote copy = note;
+    copy.setContactName(QLatin1String("detached")); // copies the private data
+    return copy.description();
+}
+
+class PayloadBodyTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void testNoteRoundTrip()
+    {
+        const SugarNote note = testNote();
+        const SugarNote readBack = readNote(writeNote(note, true));
+        QVERIFY(readBack.hasPendingBody());
+        // the header is available without decoding the body
+        QCOMPARE(readBack.name(), note.name());
+        QCOMPARE(readBack.parentId(), note.parentId());
+        QVERIFY(readBack.hasPendingBody());
+
+        QCOMPARE(readBack.description(), longDescription());
+        QVERIFY(!readBack.hasPendingBody());
+        QVERIFY(readBack == note);
+    }
+
+    void testEmailRoundTrip()
+    {
+        SugarEmail email;
+        email.setId(QLatin1String("email-1"));
+        email.setName(QLatin1String("Re: the order"));
+        email.setFromAddrName(QLatin1String("someone@example.com"));
+        email.setDescription(longDescription());
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        SugarEmailIO io;
+        QVERIFY(io.writeSugarEmail(email, &buffer));
+        buffer.close();
+
+        buffer.open(QIODevice::ReadOnly);
+        SugarEmail readBack;
+        QVERIFY(io.readSugarEmail(&buffer, readBack));
+        QVERIFY(readBack.hasPendingBody());
+        QCOMPARE(readBack.fromAddrName(), email.fromAddrName());
+        QCOMPARE(readBack.description(), longDescription());
+        QVERIFY(!readBack.hasPendingBody());
+        QVERIFY(readBack == email);
+    }
+
+    void testOpportunityRoundTrip()
+    {
+        SugarOpportunity opportunity;
+        opportunity.setId(QLatin1String("opp-1"));
+        opportunity.setName(QLatin1String("Training"));
+        opportunity.setAccountId(QLatin1String("account-1"));
+        opportunity.setNextStep(QLatin1String("Send the offer"));
+        opportunity.setDescription(longDescription());
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        SugarOpportunityIO io;
+        QVERIFY(io.writeSugarOpportunity(opportunity, &buffer));
+        buffer.close();
+
+        buffer.open(QIODevice::ReadOnly);
+        SugarOpportunity readBack;
+        QVERIFY(io.readSugarOpportunity(&buffer, readBack));
+        QVERIFY(readBack.hasPendingBody());
+        QCOMPARE(readBack.accountId(), opportunity.accountId());
+        QCOMPARE(readBack.nextStep(), opportunity.nextStep());
+        QVERIFY(readBack.hasPendingBody());
+        QCOMPARE(readBack.description(), longDescription());
+        QVERIFY(!readBack.hasPendingBody());
+        QVERIFY(readBack == opportunity);
+    }
+
+    void testHeaderOnly()
+    {
+        // what the lists fetch: the payload part without the body
+        const QByteArray data = writeNote(testNote(), false);
+        QVERIFY(!data.contains("<body>"));
+        QVERIFY(!data.contains("order"));
+        const SugarNote note = readNote(data);
+        QVERIFY(!note.hasPendingBody());
+        QCOMPARE(note.name(), QString::fromLatin1("Phone call"));
+        QVERIFY(note.description().isEmpty());
+    }
+
+    void testVersion1()
+    {
+        // payloads stored before the body section existed, with the description among the other fields
+        const QByteArray noteData =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<!DOCTYPE sugarNote>\n"
+            "<sugarNote version=\"1.0\">\n"
+            " <id>note-1</id>\n"
+            " <description>Old &lt;style&gt; note</description>\n"
+            " <name>Phone call</name>\n"
+            "</sugarNote>\n";
+        const SugarNote note = readNote(noteData);
+        QVERIFY(!note.hasPendingBody());
+        QCOMPARE(note.id(), QString::fromLatin1("note-1"));
+        QCOMPARE(note.name(), QString::fromLatin1("Phone call"));
+        QCOMPARE(note.description(), QString::fromLatin1("Old <style> note"));
+
+        QByteArray opportunityData =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<!DOCTYPE sugarOpportunity>\n"
+            "<sugarOpportunity version=\"1.0\">\n"
+            " <name>Training</name>\n"
+            " <description>Old opportunity</description>\n"
+            " <account_id>account-1</account_id>\n"
+            "</sugarOpportunity>\n";
+        QBuffer buffer(&opportunityData);
+        buffer.open(QIODevice::ReadOnly);
+        SugarOpportunityIO io;
+        SugarOpportunity opportunity;
+        QVERIFY(io.readSugarOpportunity(&buffer, opportunity));
+        QVERIFY(!opportunity.hasPendingBody());
+        QCOMPARE(opportunity.name(), QString::fromLatin1("Training"));
+        QCOMPARE(opportunity.description(), QString::fromLatin1("Old opportunity"));
+
+        // and they are written back as 2.0
+        QVERIFY(writeNote(note, true).contains("version=\"2.0\""));
+    }
+
+    void testCopyPending()
+    {
+        const SugarNote note = readNote(writeNote(testNote(), true));
+        QVERIFY(note.hasPendingBody());
+
+        // a detached copy decodes its own body
+        SugarNote copy = note;
+        copy.setName(QLatin1String("Renamed"));
+        QVERIFY(copy.hasPendingBody());
+        QVERIFY(note.hasPendingBody());
+        QCOMPARE(copy.description(), longDescription());
+        QVERIFY(note.hasPendingBody());
+        QCOMPARE(note.description(), longDescription());
+
+        // setting a body field drops the pending body
+        SugarNote edited = readNote(writeNote(testNote(), true));
+        edited.setDescription(QLatin1String("Short"));
+        QVERIFY(!edited.hasPendingBody());
+        QCOMPARE(edited.description(), QString::fromLatin1("Short"));
+    }
+
+    void testCopyPendingFromThreads()
+    {
+        // copies taken while other threads decode the same payload
+        const QByteArray data = writeNote(testNote(), true);
+        for (int i = 0; i < 50; ++i) {
+            const SugarNote note = readNote(data);
+            QList<QFuture<QString> > futures;
+            for (int thread = 0; thread < 4; ++thread) {
+                futures.append(QtConcurrent::run(copyAndReadDescription, note));
+            }
+            QCOMPARE(note.description(), longDescription());
+            foreach (QFuture<QString> future, futures) {
+                QCOMPARE(future.result(), longDescription());
+            }
+        }
+    }
+};
+
+QTEST_MAIN(PayloadBodyTest)
+#include "payloadbodytest.moc"
@@ -26,6 +26,7 @@
 
 #include <QtTest/QtTestGui>
 #include <QComboBox>
+#include <QLineEdit>
 #include <QDebug>
 #include <QAbstractProxyModel>
 #include <QSignalSpy>
@@ -40,6 +41,8 @@ private Q_SLOTS:
         // Given GUI first
         QComboBox *combo = new QComboBox;
         ReferencedDataModel::setModelForCombo(combo, AssignedToRef);
+        QVERIFY(!combo->isEditable()); // only the account combos complete typed names
+        QCOMPARE(combo->sizeAdjustPolicy(), QComboBox::AdjustToContents);
         QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(combo->model());
         QVERIFY(proxy);
         QAbstractItemModel *sourceModel = proxy->sourceModel();
@@ -90,7 +93,263 @@ private Q_SLOTS:
                  << "Adam Faure" << "Charles Faure" << "David Faure" << "Ernest Faure" << "Sabine Faure");
     }
 
+    void testComboCompletion()
+    {
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        QMap<QString, QString> map;
+        map.insert("c1", "Zoe Zimmermann");
+        map.insert("c2", "anna Andersson");
+        map.insert("c3", "Bob Berger");
+        data->addMap(map, false);
+        data->emitInitialLoadingDone();
+
+        QComboBox combo;
+        ReferencedDataModel::setModelForCombo(&combo, AccountRef);
+        QVERIFY(combo.isEditable());
+        QCOMPARE(combo.sizeAdjustPolicy(), QComboBox::AdjustToMinimumContentsLengthWithIcon);
+        QCOMPARE(comboTexts(&combo), QStringList() << QString() << "anna Andersson" << "Bob Berger" << "Zoe Zimmermann");
+
+        // a second combo shares the sorted model
+        QComboBox otherCombo;
+        ReferencedDataModel::setModelForCombo(&otherCombo, AccountRef);
+        QCOMPARE(otherCombo.model(), combo.model());
+
+        QCOMPARE(ReferencedDataModel::findId(&combo, "c3"), 2);
+        QCOMPARE(ReferencedDataModel::findId(&combo, QString()), 0);
+        QCOMPARE(ReferencedDataModel::findId(&combo, "unknown"), -1);
+
+        // typing a name selects it, case-insensitively
+        combo.setCurrentIndex(0);
+        combo.lineEdit()->setText("zoe zimmermann");
+        QMetaObject::invokeMethod(combo.lineEdit(), "editingFinished");
+        QCOMPARE(combo.currentIndex(), 3);
+        QCOMPARE(combo.itemData(combo.currentIndex()).toString(), QString("c1"));
+
+        // typing something else keeps the current item
+        combo.lineEdit()->setText("Zo");
+        QMetaObject::invokeMethod(combo.lineEdit(), "editingFinished");
+        QCOMPARE(combo.currentIndex(), 3);
+        QCOMPARE(combo.lineEdit()->text(), QString("Zoe Zimmermann"));
+
+        data->setReferencedData("c4", "Carla Costa");
+        QCOMPARE(comboTexts(&combo), QStringList() << QString() << "anna Andersson" << "Bob Berger" << "Carla Costa" << "Zoe Zimmermann");
+        QCOMPARE(ReferencedDataModel::findId(&combo, "c4"), 3);
+    }
+
+    void testInitialLoadingIntoCombo()
+    {
+        // Given a combo created before the data is loaded
+        QComboBox combo;
+        ReferencedDataModel::setModelForCombo(&combo, ReportsToRef);
+        QCOMPARE(combo.count(), 1);
+
+        // When loading the data without signals
+        ReferencedData *data = ReferencedData::instance(ReportsToRef);
+        QMap<QString, QString> map;
+        map.insert("r1", "Zoe Zimmermann");
+        map.insert("r2", "anna Andersson");
+        map.insert("r3", "Bob Berger");
+        data->addMap(map, false);
+        QCOMPARE(combo.count(), 1);
+        data->emitInitialLoadingDone();
+
+        // Then the combo shows all of it, sorted
+        QCOMPARE(comboTexts(&combo), QStringList() << QString() << "anna Andersson" << "Bob Berger" << "Zoe Zimmermann");
+        QCOMPARE(ReferencedDataModel::findId(&combo, "r1"), 3);
+    }
+
+    void testAddMap()
+    {
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        QSignalSpy spyRowsATBI(data, SIGNAL(rowsAboutToBeInserted(int,int)));
+        QSignalSpy spyDataChanged(data, SIGNAL(dataChanged(int)));
+
+        QMap<QString, QString> map;
+        map.insert("b", "KDAB");
+        map.insert("d", "Acme");
+        data->addMap(map, true);
+        QCOMPARE(spyRowsATBI.count(), 1);
+        QCOMPARE(spyRowsATBI.at(0).at(0).toInt(), 0);
+        QCOMPARE(spyRowsATBI.at(0).at(1).toInt(), 1);
+
+        // new ids are inserted in runs of consecutive rows
+        spyRowsATBI.clear();
+        map.clear();
+        map.insert("a", "Foo");
+        map.insert("c", "Bar");
+        map.insert("d", "Acme Corp");
+        map.insert("e", "Baz");
+        map.insert("f", "Qux");
+        data->addMap(map, true);
+        QCOMPARE(spyDataChanged.count(), 1);
+        QCOMPARE(spyDataChanged.at(0).at(0).toInt(), 1);
+        QCOMPARE(spyRowsATBI.count(), 3);
+        QCOMPARE(spyRowsATBI.at(0).at(0).toInt(), 0);
+        QCOMPARE(spyRowsATBI.at(1).at(0).toInt(), 2);
+        QCOMPARE(spyRowsATBI.at(2).at(0).toInt(), 4);
+        QCOMPARE(spyRowsATBI.at(2).at(1).toInt(), 5);
+        QCOMPARE(dataKeys(data), QStringList() << "a" << "b" << "c" << "d" << "e" << "f");
+        QCOMPARE(data->referencedData("d"), QString("Acme Corp"));
+        QCOMPARE(data->data(3).second, QString("Acme Corp"));
+    }
+
+    void testRemove()
+    {
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        QCOMPARE(data->count(), 6); // from testAddMap
+        QSignalSpy spyRowsATBR(data, SIGNAL(rowsAboutToBeRemoved(int,int)));
+
+        data->removeReferencedData(QStringList() << "a" << "f" << "b" << "unknown", true);
+        QCOMPARE(spyRowsATBR.count(), 2);
+        QCOMPARE(spyRowsATBR.at(0).at(0).toInt(), 5);
+        QCOMPARE(spyRowsATBR.at(0).at(1).toInt(), 5);
+        QCOMPARE(spyRowsATBR.at(1).at(0).toInt(), 0);
+        QCOMPARE(spyRowsATBR.at(1).at(1).toInt(), 1);
+        QCOMPARE(dataKeys(data), QStringList() << "c" << "d" << "e");
+        QVERIFY(data->referencedData("a").isEmpty());
+
+        data->removeReferencedData("d", true);
+        QCOMPARE(spyRowsATBR.count(), 3);
+        QCOMPARE(spyRowsATBR.at(2).at(0).toInt(), 1);
+        QCOMPARE(dataKeys(data), QStringList() << "c" << "e");
+    }
+
+    void testChangedIds()
+    {
+        // ItemsTreeModel refreshes the items referring to accounts added or removed later on
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        QSignalSpy spyInserted(data, SIGNAL(idsInserted(QStringList)));
+        QSignalSpy spyRemoved(data, SIGNAL(idsRemoved(QStringList)));
+
+        QMap<QString, QString> map;
+        map.insert("a", "Foo");
+        map.insert("c", "Bar");
+        data->addMap(map, true);
+        QCOMPARE(spyInserted.count(), 1);
+        QCOMPARE(spyInserted.at(0).at(0).toStringList(), QStringList() << "a" << "c");
+
+        // only the new ids, in one signal for all the runs
+        map.insert("b", "Baz");
+        map.insert("d", "Qux");
+        data->addMap(map, true);
+        QCOMPARE(spyInserted.count(), 2);
+        QCOMPARE(spyInserted.at(1).at(0).toStringList(), QStringList() << "b" << "d");
+
+        data->setReferencedData("e", "Last");
+        data->setReferencedData("e", "Renamed");
+        QCOMPARE(spyInserted.count(), 3);
+        QCOMPARE(spyInserted.at(2).at(0).toStringList(), QStringList() << "e");
+
+        data->removeReferencedData(QStringList() << "a" << "unknown" << "d" << "a", true);
+        QCOMPARE(spyRemoved.count(), 1);
+        QCOMPARE(spyRemoved.at(0).at(0).toStringList(), QStringList() << "a" << "d");
+
+        // nothing when the changes are silent
+        data->removeReferencedData("b", false);
+        map.clear();
+        map.insert("f", "Silent");
+        data->addMap(map, false);
+        QCOMPARE(spyInserted.count(), 3);
+        QCOMPARE(spyRemoved.count(), 1);
+    }
+
+    void testSilentChanges()
+    {
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        QSignalSpy spyRowsATBI(data, SIGNAL(rowsAboutToBeInserted(int,int)));
+        QMap<QString, QString> map;
+        map.insert("z", "Last");
+        map.insert("m", "Middle");
+        data->addMap(map, false);
+        map.clear();
+        map.insert("a", "First");
+        data->addMap(map, false);
+        data->removeReferencedData("m", false);
+        QCOMPARE(spyRowsATBI.count(), 0);
+        QCOMPARE(data->count(), 2);
+        QCOMPARE(dataKeys(data), QStringList() << "a" << "z");
+
+        // and emitting again afterwards
+        data->setReferencedData("b", "Second");
+        QCOMPARE(spyRowsATBI.count(), 1);
+        QCOMPARE(spyRowsATBI.at(0).at(0).toInt(), 1);
+    }
+
+    void benchmarkInitialLoading()
+    {
+        // 60k accounts, loaded in batches like Page::addAccountsData(), then shown in a combo
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        const QList<QMap<QString, QString> > batches = accountBatches(60000);
+        QBENCHMARK {
+            data->clear();
+            foreach (const QMap<QString, QString> &batch, batches) {
+                data->addMap(batch, false);
+            }
+            data->data(0);
+        }
+        QCOMPARE(data->count(), 60000);
+    }
+
+    void benchmarkLookup()
+    {
+        // What ItemsTreeModel and the filters do for each opportunity
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        const QList<QMap<QString, QString> > batches = accountBatches(60000);
+        foreach (const QMap<QString, QString> &batch, batches) {
+            data->addMap(batch, false);
+        }
+        const QStringList ids = batches.first().keys();
+        QBENCHMARK {
+            for (int i = 0; i < 60000; ++i) {
+                data->referencedData(ids.at(i % ids.count()));
+            }
+        }
+    }
+
+    void benchmarkInsertAfterLoading()
+    {
+        // New accounts arriving one at a time once 60k are loaded
+        ReferencedData *data = ReferencedData::instance(AccountRef);
+        data->clear();
+        const QList<QMap<QString, QString> > batches = accountBatches(61000);
+        for (int i = 0; i < 60; ++i) {
+            data->addMap(batches.at(i), true);
+        }
+        const QMap<QString, QString> &last = batches.last();
+        QBENCHMARK_ONCE {
+            for (QMap<QString, QString>::const_iterator it = last.constBegin(); it != last.constEnd(); ++it) {
+                data->setReferencedData(it.key(), it.value());
+            }
+        }
+        QCOMPARE(data->count(), 61000);
+    }
+
 private:
+    // Batches of 1000 accounts, with ids in random order like SugarCRM's
+    static QList<QMap<QString, QString> > accountBatches(int count)
+    {
+        QList<QMap<QString, QString> > batches;
+        for (int i = 0; i < count; ++i) {
+            if (i % 1000 == 0)
+                batches.append(QMap<QString, QString>());
+            const QString id = QString::number(qHash(QString::number(i)), 16) + QString::number(i);
+            batches.last().insert(id, QString::fromLatin1("Account %1").arg(i));
+        }
+        return batches;
+    }
+
+    static QStringList dataKeys(ReferencedData *data) {
+        QStringList keys;
+        for (int i = 0; i < data->count(); ++i)
+            keys.append(data->data(i).first);
+        return keys;
+    }
+
     static QStringList comboTexts(QComboBox *combo) {
         QStringList items;
         for (int i = 0; i < combo->count(); ++i) {
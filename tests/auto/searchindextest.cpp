@@ -0,0 +1,168 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "searchindex.h"
+
+#include <QtTest/QtTest>
+#include <QStringList>
+
+class SearchIndexTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void testSearch_data()
+    {
+        QTest::addColumn<QString>("filter");
+
+        QTest::newRow("empty") << "";
+        QTest::newRow("one_char") << "a";
+        QTest::newRow("two_chars") << "RL";
+        QTest::newRow("trigram") << "ber";
+        QTest::newRow("word") << "Stockholm";
+        QTest::newRow("mixed_case") << "sToCk";
+        QTest::newRow("email") << "info12@";
+        QTest::newRow("umlaut") << "MÜNCHEN";
+        QTest::newRow("no_match") << "xyzzy";
+        QTest::newRow("across_texts") << "Berlin info";
+    }
+
+    void testSearch()
+    {
+        QFETCH(QString, filter);
+
+        const QList<QStringList> corpus = contactCorpus(2000);
+        SearchIndex index;
+        for (int i = 0; i < corpus.count(); ++i) {
+            index.insert(i, corpus.at(i));
+        }
+        QCOMPARE(index.count(), corpus.count());
+
+        // exact while the posting lists are still being built, and afterwards
+        QCOMPARE(index.search(filter), naiveSearch(corpus, filter));
+        index.waitForIndexing();
+        QCOMPARE(index.search(filter), naiveSearch(corpus, filter));
+    }
+
+    void testUpdates()
+    {
+        SearchIndex index;
+        index.insert(1, QStringList() << "KDAB" << "Berlin");
+        index.insert(2, QStringList() << "Acme" << "Stockholm");
+        index.waitForIndexing();
+        QCOMPARE(index.search("berlin"), QSet<qint64>() << 1);
+
+        // changed item, searched before and after its postings are updated
+        index.insert(2, QStringList() << "Acme" << "Berlin");
+        QCOMPARE(index.search("berlin"), QSet<qint64>() << 1 << 2);
+        QVERIFY(index.search("stockholm").isEmpty());
+        index.waitForIndexing();
+        QCOMPARE(index.search("berlin"), QSet<qint64>() << 1 << 2);
+        QVERIFY(index.search("stockholm").isEmpty());
+
+        index.remove(1);
+        QCOMPARE(index.search("berlin"), QSet<qint64>() << 2);
+        index.waitForIndexing();
+        QCOMPARE(index.search("berlin"), QSet<qint64>() << 2);
+        QVERIFY(!index.contains(1));
+        QVERIFY(index.matches(2, SearchIndex::fold("ACME")));
+
+        index.clear();
+        QCOMPARE(index.count(), 0);
+        QVERIFY(index.search("acme").isEmpty());
+    }
+
+    void benchmarkSearch_data()
+    {
+        QTest::addColumn<bool>("indexed");
+
+        QTest::newRow("contains") << false;
+        QTest::newRow("index") << true;
+    }
+
+    void benchmarkSearch()
+    {
+        QFETCH(bool, indexed);
+
+        // 80k contacts, searching as the user types
+        const QList<QStringList> corpus = contactCorpus(80000);
+        const QStringList filters = QStringList() << "s" << "st" << "sto" << "stoc" << "stock" << "stockh";
+        SearchIndex index;
+        if (indexed) {
+            for (int i = 0; i < corpus.count(); ++i) {
+                index.insert(i, corpus.at(i));
+            }
+            index.waitForIndexing();
+        }
+
+        QBENCHMARK {
+            foreach (const QString &filter, filters) {
+                if (indexed)
+                    index.search(filter);
+                else
+                    naiveSearch(corpus, filter);
+            }
+        }
+    }
+
+private:
+    // What FilterProxyModel used to do: one case-insensitive contains() per text
+    static QSet<qint64> naiveSearch(const QList<QStringList> &corpus, const QString &filter)
+    {
+        QSet<qint64> result;
+        for (int i = 0; i < corpus.count(); ++i) {
+            foreach (const QString &text, corpus.at(i)) {
+                if (text.contains(filter, Qt::CaseInsensitive)) {
+                    result.insert(i);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    static QList<QStringList> contactCorpus(int count)
+    {
+        static const char *firstNames[] = { "Anna", "Björn", "Carla", "David", "Erik", "Fatima", "Günter" };
+        static const char *lastNames[] = { "Andersson", "Berger", "Costa", "Dubois", "Eriksen", "Faure" };
+        static const char *cities[] = { "Berlin", "Stockholm", "München", "Paris", "Houston" };
+        const int firstNameCount = sizeof(firstNames) / sizeof(*firstNames);
+        const int lastNameCount = sizeof(lastNames) / sizeof(*lastNames);
+        const int cityCount = sizeof(cities) / sizeof(*cities);
+        QList<QStringList> corpus;
+        corpus.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const QString firstName = QString::fromUtf8(firstNames[i % firstNameCount]);
+            const QString lastName = QString::fromUtf8(lastNames[(i / firstNameCount) % lastNameCount]);
+            corpus.append(QStringList() << firstName + QLatin1Char(' ') + lastName
+                          << QString::fromLatin1("Company %1").arg(i % 997)
+                          << QString::fromLatin1("info%1@example.com").arg(i)
+                          << QString::fromLatin1("+49 30 %1").arg(i * 31)
+                          << firstName
+                          << QString::fromUtf8(cities[i % cityCount]));
+        }
+        return corpus;
+    }
+};
+
+QTEST_MAIN(SearchIndexTest)
+#include "searchindextest.moc"
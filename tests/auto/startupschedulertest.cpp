@@ -0,0 +1,86 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startupscheduler.h"
+
+#include <QtTest/QtTest>
+
+class StartupSchedulerTest : public QObject
+{
+    Q_OBJECT
+public:
+    StartupSchedulerTest() : mCalls(0) {}
+
+public Q_SLOTS:
+    void slotCalled() { ++mCalls; }
+
+private Q_SLOTS:
+    void testDependencies()
+    {
+        StartupScheduler scheduler;
+        QSignalSpy spyProgress(&scheduler, SIGNAL(progress(int,int)));
+        QSignalSpy spyFinished(&scheduler, SIGNAL(finished(qint64)));
+        scheduler.start(StartupScheduler::Accounts | StartupScheduler::Opportunities | StartupScheduler::Notes);
+        mCalls = 0;
+        scheduler.whenDone(StartupScheduler::Accounts | StartupScheduler::Opportunities, this, "slotCalled");
+
+        scheduler.setDone(StartupScheduler::Opportunities);
+        QCOMPARE(mCalls, 0);
+        scheduler.setDone(StartupScheduler::Opportunities); // no-op
+        QCOMPARE(spyProgress.count(), 1);
+        scheduler.setDone(StartupScheduler::Accounts);
+        QCOMPARE(mCalls, 1);
+        QCOMPARE(spyProgress.at(1).at(0).toInt(), 2);
+        QCOMPARE(spyProgress.at(1).at(1).toInt(), 3);
+        QCOMPARE(scheduler.pendingTasks(), StartupScheduler::Tasks(StartupScheduler::Notes));
+
+        // already done: called right away; tasks not scheduled are ignored
+        scheduler.whenDone(StartupScheduler::Accounts | StartupScheduler::Emails, this, "slotCalled");
+        QCOMPARE(mCalls, 2);
+
+        QCOMPARE(spyFinished.count(), 0);
+        scheduler.setDone(StartupScheduler::Notes);
+        QCOMPARE(spyFinished.count(), 1);
+        QCOMPARE(mCalls, 2);
+    }
+
+    void testRestart()
+    {
+        StartupScheduler scheduler;
+        scheduler.start(StartupScheduler::Accounts | StartupScheduler::Contacts);
+        mCalls = 0;
+        scheduler.whenDone(StartupScheduler::Contacts, this, "slotCalled");
+
+        // e.g. switching resources: the pending work is dropped
+        scheduler.start(StartupScheduler::Accounts | StartupScheduler::Contacts);
+        scheduler.setDone(StartupScheduler::taskForType(Contact));
+        QCOMPARE(mCalls, 0);
+        QVERIFY(scheduler.isDone(StartupScheduler::Contacts));
+        QVERIFY(!scheduler.isDone(StartupScheduler::Accounts | StartupScheduler::Contacts));
+    }
+
+private:
+    int mCalls;
+};
+
+QTEST_MAIN(StartupSchedulerTest)
+#include "startupschedulertest.moc"
@@ -0,0 +1,121 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sugaraccount.h"
+
+#include <QtTest/QtTest>
+#include <QStringList>
+
+class SugarAccountTest : public QObject
+{
+    Q_OBJECT
+public:
+private Q_SLOTS:
+    void testCleanAccountName_data()
+    {
+        QTest::addColumn<QString>("name");
+        QTest::addColumn<QString>("cleanName");
+
+        QTest::newRow("plain") << "KDAB" << "KDAB";
+        QTest::newRow("empty") << "" << "";
+        QTest::newRow("comma_dot") << "KDAB, Inc." << "KDAB";
+        QTest::newRow("comma") << "KDAB, Inc" << "KDAB";
+        QTest::newRow("space_dot") << "KDAB Inc." << "KDAB";
+        QTest::newRow("space") << "KDAB Ltd" << "KDAB";
+        QTest::newRow("longest_first") << "KDAB SAS" << "KDAB";
+        QTest::newRow("dotted") << "KDAB S.A.S." << "KDAB";
+        QTest::newRow("gmbh_co_kg") << "KDAB GmbH & Co. KG" << "KDAB";
+        QTest::newRow("middle") << "KDAB AB Sweden" << "KDAB Sweden";
+        QTest::newRow("twice") << "KDAB Holding AG, Inc." << "KDAB Holding";
+        QTest::newRow("no_separator") << "KDABInc" << "KDABInc";
+        QTest::newRow("case_sensitive") << "KDAB inc" << "KDAB inc";
+    }
+
+    void testCleanAccountName()
+    {
+        QFETCH(QString, name);
+        QFETCH(QString, cleanName);
+
+        SugarAccount account;
+        account.setName(name);
+        QCOMPARE(account.cleanAccountName(), cleanName);
+
+        // the cached value follows renames
+        SugarAccount copy = account;
+        copy.setName(name + QLatin1String(" GmbH"));
+        QCOMPARE(copy.cleanAccountName(), cleanName);
+        QCOMPARE(account.cleanAccountName(), cleanName);
+    }
+
+    void benchmarkCleanAccountName()
+    {
+        const QStringList names = nameCorpus();
+        QBENCHMARK {
+            foreach (const QString &name, names) {
+                SugarAccount account;
+                account.setName(name);
+            }
+        }
+    }
+
+    void benchmarkKey()
+    {
+        QList<SugarAccount> accounts;
+        foreach (const QString &name, nameCorpus()) {
+            SugarAccount account;
+            account.setName(name);
+            account.setBillingAddressCity(QLatin1String("Berlin"));
+            account.setBillingAddressCountry(QLatin1String("Germany"));
+            accounts.append(account);
+        }
+        QBENCHMARK {
+            foreach (const SugarAccount &account, accounts) {
+                account.key();
+            }
+        }
+    }
+
+private:
+    // 100k account names, 60% of them with a legal suffix
+    static QStringList nameCorpus()
+    {
+        static const char *words[] = { "KDAB", "Acme", "Nordic", "Systems", "Software", "Data", "Holding", "Group" };
+        static const char *suffixes[] = { ", Inc.", " Inc", " Ltd", " Limited", " GmbH", " GmbH & Co. KG",
+                                          " S.A.S", " SA", " S.p.A", " AB", " AG", " B.V.", " AS" };
+        const int wordCount = sizeof(words) / sizeof(*words);
+        const int suffixCount = sizeof(suffixes) / sizeof(*suffixes);
+        QStringList names;
+        names.reserve(100000);
+        for (int i = 0; i < 100000; ++i) {
+            QString name = QString::fromLatin1("%1 %2 %3").arg(QLatin1String(words[i % wordCount]))
+                           .arg(QLatin1String(words[(i / wordCount) % wordCount])).arg(i);
+            if (i % 5 < 3) {
+                name += QLatin1String(suffixes[i % suffixCount]);
+            }
+            names.append(name);
+        }
+        return names;
+    }
+};
+
+QTEST_MAIN(SugarAccountTest)
+#include "sugaraccounttest.moc"
@@ -66,6 +66,19 @@ private Q_SLOTS:
         if (expectedIndexOfValue > -1) {
             QCOMPARE(reloaded.indexOf(expectedIndexOfString), expectedIndexOfValue);
         }
+
+        const QByteArray compact = enums.toByteArray();
+        QVERIFY(EnumDefinitions::isByteArrayFormat(compact));
+        QVERIFY(!EnumDefinitions::isByteArrayFormat(str.toUtf8()));
+        const EnumDefinitions fromCompact = EnumDefinitions::fromByteArray(compact);
+        QCOMPARE(fromCompact.toString(), str);
+        QCOMPARE(fromCompact.count(), enums.count());
+        if (expectedIndexOfValue > -1) {
+            QCOMPARE(fromCompact.indexOf(expectedIndexOfString), expectedIndexOfValue);
+        }
+
+        // truncated data must not crash
+        QVERIFY(EnumDefinitions::fromByteArray(compact.left(compact.size() - 1)).count() <= enums.count());
     }
 
 };
@@ -0,0 +1,92 @@
+/*
+  This file is part of FatCRM, a desktop application for SugarCRM written by KDAB.
+
+  Copyright (C) 2015 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+  Authors: David Faure <david.faure@kdab.com>
+           Michel Boyer de la Giroday <michel.giroday@kdab.com>
+           Kevin Krammer <kevin.krammer@kdab.com>
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "tracer.h"
+
+#include <QtTest/QtTest>
+
+class TracerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init()
+    {
+        Tracer *tracer = Tracer::instance();
+        tracer->setCapacity(3);
+        tracer->clear();
+        tracer->setEnabled(true);
+    }
+
+    void cleanup()
+    {
+        Tracer::instance()->setEnabled(false);
+    }
+
+    void testDisabled()
+    {
+        Tracer::instance()->setEnabled(false);
+        QCOMPARE(Tracer::timestamp(), qint64(-1));
+        {
+            TraceScope trace("test", "test");
+            QVERIFY(!trace.isActive());
+        }
+        QCOMPARE(Tracer::instance()->eventCount(), 0);
+    }
+
+    void testRingBuffer()
+    {
+        Tracer *tracer = Tracer::instance();
+        const char *names[] = { "a", "b", "c", "d", "e" };
+        for (int i = 0; i < 5; ++i) {
+            TraceScope trace(names[i], "test");
+        }
+        // only the most recent ones are kept, oldest first
+        const QVector<Tracer::Event> events = tracer->events();
+        QCOMPARE(events.count(), 3);
+        QCOMPARE(QByteArray(events.at(0).name), QByteArray("c"));
+        QCOMPARE(QByteArray(events.at(2).name), QByteArray("e"));
+        QVERIFY(events.at(0).start <= events.at(1).start);
+
+        tracer->setCapacity(2);
+        QCOMPARE(tracer->eventCount(), 2);
+        QCOMPARE(QByteArray(tracer->events().at(0).name), QByteArray("d"));
+    }
+
+    void testChromeTrace()
+    {
+        Tracer *tracer = Tracer::instance();
+        const qint64 start = Tracer::timestamp();
+        QVERIFY(start >= 0);
+        tracer->addEvent("Page::loadModel", "startup", start, QString::fromUtf8("\"Accounts\"\n"));
+
+        const QByteArray json = tracer->toChromeTrace();
+        QVERIFY(json.startsWith("{\"traceEvents\":[{\"name\":\"Page::loadModel\",\"cat\":\"startup\",\"ph\":\"X\""));
+        QVERIFY(json.contains("\"tid\":1,"));
+        QVERIFY(json.contains("\"args\":{\"detail\":\"\\\"Accounts\\\"\\u000a\"}"));
+        QVERIFY(json.trimmed().endsWith("],\"displayTimeUnit\":\"ms\"}"));
+    }
+};
+
+QTEST_MAIN(TracerTest)
+
+#include "tracertest.moc"